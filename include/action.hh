@@ -10,7 +10,8 @@
 #include "generator.hh"
 #include "run.hh"
 #include "event.hh"
-#include "stepping.hh"
+#include "stacking.hh"
+#include "tracking.hh"
 
 /** 
  * @brief Mandatory user initialization concrete class of
@@ -20,14 +21,21 @@
 class MyActionInitialization : public G4VUserActionInitialization
 {
 public:
-    MyActionInitialization(G4int theMCID); /**< @brief Constructor of the class.*/
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param theMCID The Monte Carlo ID.
+     * @param shardDriver Pointer to the driver of the shard, if the
+     * application runs as one.
+     */
+    MyActionInitialization(G4int theMCID, MyShardDriver *shardDriver = nullptr);
     ~MyActionInitialization() override = default; /**< @brief Destructor of the class.*/
     
     /** 
      * @brief Configures user action classes for worker threads.
      *
      * In addition to @ref MyPrimaryGenerator, these include @ref MyRunAction(),
-     * @ref MyEventAction(), and @ref MySteppingAction().
+     * @ref MyEventAction(), @ref MyStackingAction() and @ref MyTrackingAction().
      */
     void Build() const override;
     /** 
@@ -38,6 +46,7 @@ public:
 
 private:
     G4int fMCID; /**< @brief The Monte Carlo ID.*/
+    MyShardDriver *fShardDriver; /**< @brief Pointer to the driver of the shard, if any.*/
 };
 
 #endif  // ACTION_HH
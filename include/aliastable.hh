@@ -0,0 +1,89 @@
+/**
+ * @file aliastable.hh
+ * @brief Definition of the class @ref MyAliasTable
+ */
+#ifndef ALIASTABLE_HH
+#define ALIASTABLE_HH
+
+#include <vector>
+
+#include "globals.hh"
+#include "Randomize.hh"
+
+/**
+ * @brief Walker's alias table: samples an index of a discrete distribution
+ * in constant time, with two random numbers, whatever the number of bins.
+ *
+ * Every bin of the table holds the probability to keep the bin and the
+ * index given instead (its alias); the table is built once with Vose's
+ * algorithm, in linear time.
+ */
+class MyAliasTable
+{
+public:
+    MyAliasTable() = default; /**< @brief Constructor of the class, empty table.*/
+
+    /**
+     * @brief Builds the table.
+     *
+     * @param weights The weights of the bins, not negative and not all null,
+     * not necessarily normalized.
+     */
+    void Build(const std::vector<G4double> &weights)
+    {
+        G4int n = static_cast<G4int>(weights.size());
+        G4double sum = 0.;
+        for(G4double weight : weights)
+            sum += weight;
+
+        fProbability.assign(n, 1.);
+        fAlias.resize(n);
+        std::vector<G4double> scaled(n);
+        std::vector<G4int> small, large;
+        for(G4int i = 0; i < n; i++)
+        {
+            fAlias[i] = i;
+            scaled[i] = weights[i]*n/sum;
+            if(scaled[i] < 1.)
+                small.push_back(i);
+            else
+                large.push_back(i);
+        }
+
+        // Fill the bins below the mean with the excess of the ones above it
+        while(!small.empty() && !large.empty())
+        {
+            G4int lower = small.back();
+            small.pop_back();
+            G4int upper = large.back();
+
+            fProbability[lower] = scaled[lower];
+            fAlias[lower] = upper;
+            scaled[upper] -= 1. - scaled[lower];
+            if(scaled[upper] < 1.)
+            {
+                large.pop_back();
+                small.push_back(upper);
+            }
+        }
+        // The bins left are full, up to the rounding
+    }
+
+    /** @brief Samples an index.*/
+    inline G4int Sample() const
+    {
+        G4int n = static_cast<G4int>(fProbability.size());
+        G4int i = static_cast<G4int>(G4UniformRand()*n);
+        if(i == n)
+            i--;
+        return G4UniformRand() < fProbability[i] ? i : fAlias[i];
+    }
+
+    inline G4int GetNBins() const { return static_cast<G4int>(fProbability.size()); } /**< @brief Get the number of bins.*/
+
+private:
+    std::vector<G4double> fProbability; /**< @brief Probability to keep the bin, [bin].*/
+    std::vector<G4int> fAlias; /**< @brief Bin given instead, [bin].*/
+};
+
+#endif  // ALIASTABLE_HH
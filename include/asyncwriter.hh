@@ -0,0 +1,100 @@
+/**
+ * @file asyncwriter.hh
+ * @brief Declaration of the class @ref MyAsyncWriter
+ */
+#ifndef ASYNCWRITER_HH
+#define ASYNCWRITER_HH
+
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstdint>
+
+#include "globals.hh"
+
+#include "eventrecord.hh"
+#include "boundedqueue.hh"
+#include "columnarwriter.hh"
+
+/** @brief Statistics of the queue of the @ref MyAsyncWriter.*/
+struct MyAsyncWriterStats
+{
+    std::uint64_t nEvents = 0; /**< @brief Number of events queued.*/
+    std::uint64_t capacity = 0; /**< @brief Capacity of the queue.*/
+    std::uint64_t maxDepth = 0; /**< @brief Maximum number of events waiting in the queue.*/
+    G4double meanDepth = 0.; /**< @brief Mean number of events waiting in the queue, seen by the events queued.*/
+    std::uint64_t nStalls = 0; /**< @brief Number of events that found the queue full.*/
+    G4double stallTime = 0.; /**< @brief Time spent by the threads waiting for room in the queue, in s.*/
+};
+
+
+
+/**
+ * @brief Dedicated thread writing the events of the run in columnar format
+ * (/MC_LYSO/output/format columnar), so that the serialization and the
+ * compression of the chunks don't stall the event loops.
+ *
+ * The threads processing the events move their records into records owned
+ * by the writer and push them in a bounded lock-free queue
+ * (@ref MyBoundedQueue); the writer thread fills the chunks and appends them
+ * to the @ref MyColumnarWriter. The emptied records go back to the threads
+ * through a second queue, so their vectors keep the capacity reached.
+ * The writer is started and stopped by the master @ref MyRunAction. If the
+ * queue is full, the threads wait: the number of times and the time spent
+ * are recorded, with the depth of the queue, to size it.
+ */
+class MyAsyncWriter
+{
+public:
+    MyAsyncWriter() = default; /**< @brief Constructor of the class.*/
+    ~MyAsyncWriter(); /**< @brief Destructor of the class, it stops the thread.*/
+
+    /** @brief The writer of the run, shared by the threads.*/
+    static MyAsyncWriter *Instance();
+
+    /**
+     * @brief Starts the writer thread, the columnar file must be open.
+     *
+     * @param queueSize The capacity of the queue, rounded up to a power of two.
+     * @param chunkSize The number of events per chunk.
+     * @param schema The output schema of the file.
+     */
+    void Start(G4int queueSize, G4int chunkSize, const MyOutputSchema &schema);
+    /**
+     * @brief Queues an event, thread-safe. It waits if the queue is full.
+     *
+     * @param record The event: its vectors are moved, it gets empty ones.
+     */
+    void Submit(MyEventRecord &record);
+    /** @brief Writes the events left in the queue and stops the thread.*/
+    void Stop();
+
+    inline G4bool IsRunning() const { return fThread.joinable(); } /**< @brief Tells whether the writer thread is running.*/
+    /** @brief Get the statistics of the queue of the last run.*/
+    inline const MyAsyncWriterStats &GetRunStats() const { return fRunStats; }
+    /** @brief Get the statistics of the queue of all the runs.*/
+    inline const MyAsyncWriterStats &GetTotalStats() const { return fTotalStats; }
+
+private:
+    void Loop(); /**< @brief Body of the writer thread.*/
+    /** @brief Writes a record into the chunk and gives it back to the threads.*/
+    void Write(MyEventRecord *record);
+
+    std::unique_ptr<MyBoundedQueue<MyEventRecord*>> fQueue; /**< @brief Queue of the events to write.*/
+    std::unique_ptr<MyBoundedQueue<MyEventRecord*>> fFreeRecords; /**< @brief Queue of the records written, to reuse.*/
+    std::thread fThread; /**< @brief The writer thread.*/
+    std::atomic<G4bool> fStop{false}; /**< @brief Tells the thread to return once the queue is empty.*/
+    MyColumnarChunk fChunk; /**< @brief Chunk being filled by the writer thread.*/
+    G4int fChunkSize = 1000; /**< @brief Number of events per chunk.*/
+
+    // Statistics, updated by the threads queuing the events
+    std::atomic<std::uint64_t> fNEvents{0}, /**< @brief Number of events queued.*/
+                               fSumDepth{0}, /**< @brief Sum of the depths seen by the events queued.*/
+                               fMaxDepth{0}, /**< @brief Maximum depth.*/
+                               fNStalls{0}, /**< @brief Number of events that found the queue full.*/
+                               fStallNs{0}; /**< @brief Time spent waiting for room, in ns.*/
+    MyAsyncWriterStats fRunStats; /**< @brief Statistics of the last run.*/
+    MyAsyncWriterStats fTotalStats; /**< @brief Statistics of all the runs.*/
+};
+
+#endif  // ASYNCWRITER_HH
@@ -0,0 +1,139 @@
+/**
+ * @file benchmark.hh
+ * @brief Declaration of the class @ref MyBenchmark
+ */
+#ifndef BENCHMARK_HH
+#define BENCHMARK_HH
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include "globals.hh"
+
+#include "perfcounters.hh"
+
+/** @brief A figure of merit of the benchmarks.*/
+struct MyBenchmarkMetric
+{
+    const char *name; /**< @brief Name of the metric, in the stats and in the baseline.*/
+    G4double value; /**< @brief Measured value.*/
+    G4bool higherIsBetter; /**< @brief Whether the metric regresses when it decreases (throughputs) or when it increases.*/
+};
+
+
+
+/**
+ * @brief Throughput of the application, over all the runs of the process:
+ * events, optical photons tracked, steps and hits per second of event loop,
+ * peak resident memory and output bytes per event.
+ *
+ * The master @ref MyRunAction times its runs and adds the totals of the
+ * @ref MyPerfCounters and the size of the output file. With --stats the
+ * main writes the metrics as JSON; with --baseline it compares them with
+ * the baseline of the macro, a text file with lines
+ *
+ *     macro metric value tolerance
+ *
+ * where macro is the name of the macro without extension. A throughput
+ * regresses below value*(1 - tolerance), the memory and the output size
+ * above value*(1 + tolerance). With --record it writes the metrics as the
+ * baseline of the macro instead.
+ *
+ * For the thread-scaling studies it also reports where the threads wait:
+ * the fraction of the event loop they're busy with events, the time spent
+ * in the output calls (the locks of the analysis manager or of the columnar
+ * file), writing to the Geant4 output streams (only with
+ * SetTimingStreams()) and at the end of the run, in the workers and in the
+ * merge by the master. With --scaling every process adds its row to a
+ * table of the macro, with the speedup and the efficiency.
+ */
+class MyBenchmark
+{
+public:
+    /** @brief The benchmark of the process.*/
+    static MyBenchmark *Instance();
+
+    void BeginRun(); /**< @brief Starts the timer of the event loop, by the master.*/
+    /**
+     * @brief Stops the timer of the event loop and adds the counters of the
+     * run, by the master.
+     *
+     * @param counters The counters merged from the workers.
+     * @param outputBytes The size of the output file of the run.
+     */
+    void EndRun(const MyPerfCounters &counters, std::uint64_t outputBytes, G4double mergeTime);
+
+    /** @brief Sets whether the threads time their writes to G4cout and G4cerr.*/
+    inline void SetTimingStreams(G4bool timing) { fTimingStreams = timing; }
+    inline G4bool IsTimingStreams() const { return fTimingStreams; } /**< @brief Tells whether the threads time their writes to G4cout and G4cerr.*/
+
+    /** @brief Computes the metrics of the runs so far.*/
+    std::vector<MyBenchmarkMetric> GetMetrics() const;
+    /**
+     * @brief Writes the counters and the metrics as JSON.
+     *
+     * @param fileName The JSON file.
+     * @param macro The macro executed.
+     * @param nThreads The number of threads.
+     * @param wallTime The duration of the whole macro, in s.
+     * @return false if the file can't be written.
+     */
+    G4bool WriteStats(const G4String &fileName, const G4String &macro, G4int nThreads, G4double wallTime) const;
+    /**
+     * @brief Compares the metrics with the baseline of a macro and prints
+     * the result. The metrics missing in the baseline are printed as the
+     * lines to add.
+     *
+     * @param baselineFile The baseline file.
+     * @param key The name of the macro in the baseline.
+     * @return false if a metric regressed, if the baseline has no
+     * throughput for the macro or if the file can't be read.
+     */
+    G4bool CompareBaseline(const G4String &baselineFile, const G4String &key) const;
+    /**
+     * @brief Records the metrics as the baseline of a macro, with the
+     * default tolerances, replacing its lines and keeping the other ones.
+     *
+     * @param baselineFile The baseline file.
+     * @param key The name of the macro in the baseline.
+     * @return false if the file can't be written.
+     */
+    G4bool RecordBaseline(const G4String &baselineFile, const G4String &key) const;
+    /**
+     * @brief Adds the row of this process to the thread-scaling table of a
+     * macro, replacing the one with the same number of threads, and prints
+     * the table. The speedup is relative to the fewest threads.
+     *
+     * @param fileName The file of the table.
+     * @param macro The macro executed.
+     * @param nThreads The number of threads.
+     * @return false if the file can't be written.
+     */
+    G4bool AddScalingRow(const G4String &fileName, const G4String &macro, G4int nThreads) const;
+
+private:
+    MyBenchmark() = default; /**< @brief Constructor of the class.*/
+
+    G4bool fTimingStreams = false; /**< @brief Whether the threads time their writes to the output streams.*/
+    std::chrono::steady_clock::time_point fRunStart; /**< @brief Start of the current run.*/
+    G4double fRunTime = 0.; /**< @brief Duration of the event loops, in s.*/
+    G4int fNRuns = 0; /**< @brief Number of runs.*/
+    std::uint64_t fNEvents = 0, /**< @brief Number of events processed.*/
+                  fNOpticalPhotons = 0, /**< @brief Number of optical photons tracked.*/
+                  fNSteps = 0, /**< @brief Number of steps.*/
+                  fNHits = 0, /**< @brief Number of hits.*/
+                  fOutputBytes = 0; /**< @brief Size of the output files.*/
+
+    // Contention diagnostics, summed over the runs
+    G4int fNThreads = 1; /**< @brief Number of threads processing the events.*/
+    G4double fBusyTime = 0., /**< @brief Time spent in the events, summed over the threads, in s.*/
+             fMinBusyTime = 0., /**< @brief Time spent in the events by the least busy thread, in s.*/
+             fMaxBusyTime = 0., /**< @brief Time spent in the events by the busiest thread, in s.*/
+             fOutputTime = 0., /**< @brief Time spent in the output calls, summed over the threads, in s.*/
+             fStreamTime = 0., /**< @brief Time spent writing to the output streams, summed over the threads, in s.*/
+             fEndOfRunTime = 0., /**< @brief Longest end of the run of the workers, in s.*/
+             fMergeTime = 0.; /**< @brief End of the run of the master, merge and write of the output, in s.*/
+};
+
+#endif  // BENCHMARK_HH
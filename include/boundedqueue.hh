@@ -0,0 +1,131 @@
+/**
+ * @file boundedqueue.hh
+ * @brief Definition of the class template @ref MyBoundedQueue
+ */
+#ifndef BOUNDEDQUEUE_HH
+#define BOUNDEDQUEUE_HH
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**
+ * @brief Bounded lock-free queue for many producers and many consumers.
+ *
+ * It's a ring of cells, each one with a sequence number telling whether the
+ * cell is free for the producer of a given turn or full for its consumer:
+ * producers and consumers only contend on their own position counter, with a
+ * compare-and-swap, and never wait for each other unless the queue is full
+ * or empty. The capacity is rounded up to a power of two.
+ *
+ * @tparam T The type of the elements, cheap to move (e.g. a pointer).
+ */
+template <typename T>
+class MyBoundedQueue
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param capacity The minimum number of elements the queue can hold.
+     */
+    explicit MyBoundedQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while(size < capacity)
+            size *= 2;
+
+        fCells = std::vector<Cell>(size);
+        for(size_t i = 0; i < size; i++)
+            fCells[i].sequence.store(i, std::memory_order_relaxed);
+        fMask = size - 1;
+    }
+
+    MyBoundedQueue(const MyBoundedQueue&) = delete;
+    MyBoundedQueue &operator=(const MyBoundedQueue&) = delete;
+
+    /**
+     * @brief Appends an element.
+     *
+     * @return false if the queue is full.
+     */
+    bool TryPush(T value)
+    {
+        size_t position = fEnqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for(;;)
+        {
+            cell = &fCells[position & fMask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if(diff == 0)
+            {
+                if(fEnqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+                return false;
+            else
+                position = fEnqueuePos.load(std::memory_order_relaxed);
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element.
+     *
+     * @return false if the queue is empty.
+     */
+    bool TryPop(T &value)
+    {
+        size_t position = fDequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for(;;)
+        {
+            cell = &fCells[position & fMask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if(diff == 0)
+            {
+                if(fDequeuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+                return false;
+            else
+                position = fDequeuePos.load(std::memory_order_relaxed);
+        }
+
+        value = std::move(cell->value);
+        cell->sequence.store(position + fMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Approximate number of elements, exact only when the queue is idle.*/
+    inline size_t GetDepth() const
+    {
+        size_t enqueued = fEnqueuePos.load(std::memory_order_relaxed);
+        size_t dequeued = fDequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+    inline size_t GetCapacity() const { return fMask + 1; } /**< @brief Get the number of elements the queue can hold.*/
+
+private:
+    /** @brief A slot of the ring.*/
+    struct Cell
+    {
+        std::atomic<size_t> sequence; /**< @brief Turn of the cell.*/
+        T value; /**< @brief The element.*/
+    };
+
+    std::vector<Cell> fCells; /**< @brief The ring.*/
+    size_t fMask; /**< @brief Capacity minus one.*/
+    alignas(64) std::atomic<size_t> fEnqueuePos{0}; /**< @brief Position of the next push.*/
+    alignas(64) std::atomic<size_t> fDequeuePos{0}; /**< @brief Position of the next pop.*/
+};
+
+#endif  // BOUNDEDQUEUE_HH
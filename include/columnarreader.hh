@@ -0,0 +1,421 @@
+/**
+ * @file columnarreader.hh
+ * @brief Definition of the columnar event format and of its header-only
+ * reader @ref MyColumnarReader
+ *
+ * This header doesn't depend on Geant4 nor ROOT: it can be copied in any
+ * analysis code.
+ *
+ * The file is made of a header, the name and the version of the output
+ * schema, the table of the columns, the chunks and, last, the index of the
+ * chunks. Every chunk holds a block of events, column
+ * by column: a scalar column is one segment with a value per event, an array
+ * column two segments, the offsets (nEvents + 1 of them, the event i owns the
+ * values from offsets[i] to offsets[i + 1]) and the flat values. Every
+ * segment starts 8-byte aligned.
+ * If the file is compressed, the integer segments are delta encoded, zigzag
+ * mapped and stored as LEB128 varints; the floating point and the 8-bit
+ * segments are always raw.
+ * Files of version 1 have no schema, they hold the full schema.
+ */
+#ifndef COLUMNARREADER_HH
+#define COLUMNARREADER_HH
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** @brief Types of the columns of the columnar file.*/
+enum MyColumnarType : std::uint32_t
+{
+    kColumnarInt = 0, /**< @brief 32-bit integer per event.*/
+    kColumnarDouble = 1, /**< @brief Double per event.*/
+    kColumnarIntArray = 2, /**< @brief Array of 32-bit integers per event.*/
+    kColumnarDoubleArray = 3, /**< @brief Array of doubles per event.*/
+    kColumnarFloat = 4, /**< @brief Float per event.*/
+    kColumnarFloatArray = 5, /**< @brief Array of floats per event.*/
+    kColumnarByteArray = 6 /**< @brief Array of 8-bit unsigned integers per event.*/
+};
+
+constexpr std::uint32_t columnarFormatVersion = 2; /**< @brief Version of the columnar format.*/
+constexpr std::uint32_t columnarFlagDeltaVarint = 1; /**< @brief Flag of the compressed files.*/
+constexpr std::uint32_t columnarChunkMagic = 0x4B4E4843; /**< @brief Magic number of a chunk ("CHNK").*/
+
+/** @brief Header of the columnar file.*/
+struct MyColumnarFileHeader
+{
+    char magic[8]; /**< @brief "LYSOCOLS".*/
+    std::uint32_t version; /**< @brief Version of the format.*/
+    std::uint32_t headerSize; /**< @brief Size of this header.*/
+    std::uint32_t nColumns; /**< @brief Number of columns.*/
+    std::uint32_t flags; /**< @brief Flags, e.g. columnarFlagDeltaVarint.*/
+    std::uint64_t columnsOffset; /**< @brief Offset of the table of the columns.*/
+    std::uint64_t indexOffset; /**< @brief Offset of the index of the chunks.*/
+    std::uint64_t nChunks; /**< @brief Number of chunks.*/
+    std::uint64_t nEvents; /**< @brief Number of events.*/
+    std::uint64_t fileSize; /**< @brief Size of the whole file.*/
+};
+
+/** @brief Output schema of the file, after the header (from version 2).*/
+struct MyColumnarSchemaInfo
+{
+    char name[24]; /**< @brief Name of the schema, null terminated.*/
+    std::uint32_t version; /**< @brief Version of the schema.*/
+    std::uint32_t reserved; /**< @brief Padding.*/
+};
+
+/** @brief Entry of the table of the columns.*/
+struct MyColumnarColumn
+{
+    char name[24]; /**< @brief Name of the column, null terminated.*/
+    std::uint32_t type; /**< @brief Type of the column, a MyColumnarType.*/
+    std::uint32_t reserved; /**< @brief Padding.*/
+};
+
+/** @brief Header of a chunk, followed by the table of its segments.*/
+struct MyColumnarChunkHeader
+{
+    std::uint32_t magic; /**< @brief columnarChunkMagic.*/
+    std::uint32_t nEvents; /**< @brief Number of events of the chunk.*/
+    std::uint64_t size; /**< @brief Size of the chunk, header included.*/
+};
+
+/** @brief Entry of the table of the segments of a chunk.*/
+struct MyColumnarSegment
+{
+    std::uint64_t offset; /**< @brief Offset from the start of the chunk.*/
+    std::uint64_t size; /**< @brief Size in bytes.*/
+};
+
+/** @brief Entry of the index of the chunks.*/
+struct MyColumnarIndexEntry
+{
+    std::uint64_t offset; /**< @brief Offset of the chunk in the file.*/
+    std::uint64_t firstEvent; /**< @brief Index of the first event of the chunk in the file.*/
+};
+
+static_assert(sizeof(MyColumnarFileHeader) == 64 && sizeof(MyColumnarSchemaInfo) == 32 && sizeof(MyColumnarColumn) == 32 && sizeof(MyColumnarChunkHeader) == 16 && sizeof(MyColumnarSegment) == 16, "Unexpected padding in the columnar format");
+
+
+
+/** @brief Tells whether a column holds an array per event.*/
+inline bool MyColumnarIsArray(std::uint32_t type)
+{
+    return type == kColumnarIntArray || type == kColumnarDoubleArray || type == kColumnarFloatArray || type == kColumnarByteArray;
+}
+
+
+
+/** @brief Number of segments of a column: two for the arrays, offsets and values.*/
+inline std::uint32_t MyColumnarSegments(std::uint32_t type)
+{
+    return MyColumnarIsArray(type) ? 2 : 1;
+}
+
+
+
+/**
+ * @brief Decodes n delta-zigzag-varint integers.
+ *
+ * @return The end of the decoded bytes, nullptr if the segment is too short.
+ */
+inline const char *MyDecodeDeltaVarint(const char *in, const char *end, std::int32_t *out, std::size_t n)
+{
+    std::int64_t previous = 0;
+    for(std::size_t i = 0; i < n; i++)
+    {
+        std::uint64_t zigzag = 0;
+        int shift = 0;
+        std::uint8_t byte;
+        do
+        {
+            if(in == end)
+                return nullptr;
+            byte = static_cast<std::uint8_t>(*in++);
+            zigzag |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while(byte & 0x80);
+
+        std::int64_t delta = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+        previous += delta;
+        out[i] = static_cast<std::int32_t>(previous);
+    }
+    return in;
+}
+
+
+
+/** @brief Read-only view over contiguous values, as std::span.*/
+template<typename T>
+class MySpan
+{
+public:
+    MySpan() = default;
+    MySpan(const T *data, std::size_t size) : fData(data), fSize(size) {}
+
+    inline const T *data() const { return fData; }
+    inline std::size_t size() const { return fSize; }
+    inline bool empty() const { return fSize == 0; }
+    inline const T *begin() const { return fData; }
+    inline const T *end() const { return fData + fSize; }
+    inline const T &operator[](std::size_t i) const { return fData[i]; }
+
+private:
+    const T *fData = nullptr;
+    std::size_t fSize = 0;
+};
+
+
+
+/**
+ * @brief View over a chunk of a @ref MyColumnarReader.
+ *
+ * The values are read in place from the mapped file; only the integer
+ * segments of a compressed file are decoded, in buffers owned by the view.
+ */
+class MyColumnarChunkView
+{
+public:
+    // Move only: the segments may point to the decoded buffers
+    MyColumnarChunkView(const MyColumnarChunkView&) = delete;
+    MyColumnarChunkView(MyColumnarChunkView&&) = default;
+    MyColumnarChunkView &operator=(const MyColumnarChunkView&) = delete;
+    MyColumnarChunkView &operator=(MyColumnarChunkView&&) = default;
+
+    inline std::uint32_t GetNEvents() const { return fNEvents; } /**< @brief Get the number of events of the chunk.*/
+
+    /** @brief The values of a scalar column, one per event (T = std::int32_t, float or double).*/
+    template<typename T>
+    MySpan<T> GetScalars(std::size_t column) const
+    {
+        return MySpan<T>(reinterpret_cast<const T*>(fSegments[fFirstSegment[column]]), fNEvents);
+    }
+
+    /** @brief The offsets of an array column, nEvents + 1 of them.*/
+    MySpan<std::int32_t> GetOffsets(std::size_t column) const
+    {
+        return MySpan<std::int32_t>(reinterpret_cast<const std::int32_t*>(fSegments[fFirstSegment[column]]), fNEvents + 1);
+    }
+
+    /** @brief The values of an array column for an event of the chunk (T = std::int32_t, std::uint8_t, float or double).*/
+    template<typename T>
+    MySpan<T> GetArray(std::size_t column, std::size_t event) const
+    {
+        const std::int32_t *offsets = reinterpret_cast<const std::int32_t*>(fSegments[fFirstSegment[column]]);
+        const T *values = reinterpret_cast<const T*>(fSegments[fFirstSegment[column] + 1]);
+        return MySpan<T>(values + offsets[event], offsets[event + 1] - offsets[event]);
+    }
+
+    /** @brief The values of an array column for all the events of the chunk.*/
+    template<typename T>
+    MySpan<T> GetArrayValues(std::size_t column) const
+    {
+        const std::int32_t *offsets = reinterpret_cast<const std::int32_t*>(fSegments[fFirstSegment[column]]);
+        return MySpan<T>(reinterpret_cast<const T*>(fSegments[fFirstSegment[column] + 1]), offsets[fNEvents]);
+    }
+
+private:
+    friend class MyColumnarReader;
+    MyColumnarChunkView() = default;
+
+    std::uint32_t fNEvents = 0; /**< @brief Number of events.*/
+    std::vector<const char*> fSegments; /**< @brief Start of every segment.*/
+    std::vector<std::size_t> fFirstSegment; /**< @brief First segment of every column.*/
+    std::vector<std::vector<std::int32_t>> fDecoded; /**< @brief Decoded segments of a compressed file.*/
+};
+
+
+
+/**
+ * @brief Header-only reader of the columnar event files written by MC_LYSO.
+ *
+ * The file is memory-mapped read-only: the chunks are accessed in place,
+ * with no copy, e.g.
+ * @code
+ * MyColumnarReader reader("RootFiles/MCID_1234.lysc");
+ * std::size_t tF = reader.FindColumn("T_F");
+ * for(std::size_t c = 0; c < reader.GetNChunks(); c++)
+ * {
+ *     MyColumnarChunkView chunk = reader.GetChunk(c);
+ *     for(std::uint32_t i = 0; i < chunk.GetNEvents(); i++)
+ *         for(double t : chunk.GetArray<double>(tF, i)) ...
+ * }
+ * @endcode
+ * Errors are reported with std::runtime_error.
+ */
+class MyColumnarReader
+{
+public:
+    /** @brief Maps and validates the file.*/
+    explicit MyColumnarReader(const std::string &fileName)
+    {
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if(fd < 0)
+            throw std::runtime_error("Can't open the columnar file " + fileName);
+
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0 || static_cast<std::size_t>(fileStat.st_size) < sizeof(MyColumnarFileHeader))
+        {
+            close(fd);
+            throw std::runtime_error("The columnar file " + fileName + " is not valid");
+        }
+
+        fSize = fileStat.st_size;
+        void *data = mmap(nullptr, fSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(data == MAP_FAILED)
+            throw std::runtime_error("Can't map the columnar file " + fileName);
+        fData = static_cast<const char*>(data);
+
+        fHeader = reinterpret_cast<const MyColumnarFileHeader*>(fData);
+        if(std::memcmp(fHeader->magic, "LYSOCOLS", 8) != 0)
+            Fail(fileName + " is not a columnar file");
+        if(fHeader->version < 1 || fHeader->version > columnarFormatVersion)
+            Fail("The columnar file " + fileName + " has format version " + std::to_string(fHeader->version));
+        std::size_t headerSize = sizeof(MyColumnarFileHeader) + (fHeader->version >= 2 ? sizeof(MyColumnarSchemaInfo) : 0);
+        if(fHeader->headerSize != headerSize || fSize < headerSize)
+            Fail(fileName + " is not a columnar file");
+        if(fHeader->fileSize != fSize || fHeader->indexOffset == 0)
+            Fail("The columnar file " + fileName + " is truncated or was not closed");
+        if(fHeader->columnsOffset + fHeader->nColumns*sizeof(MyColumnarColumn) > fSize || fHeader->indexOffset + fHeader->nChunks*sizeof(MyColumnarIndexEntry) > fSize)
+            Fail("The columnar file " + fileName + " is inconsistent");
+
+        if(fHeader->version >= 2)
+        {
+            const MyColumnarSchemaInfo *schema = reinterpret_cast<const MyColumnarSchemaInfo*>(fHeader + 1);
+            fSchemaName.assign(schema->name, strnlen(schema->name, sizeof(schema->name)));
+            fSchemaVersion = schema->version;
+        }
+
+        fColumns = reinterpret_cast<const MyColumnarColumn*>(fData + fHeader->columnsOffset);
+        fIndex = reinterpret_cast<const MyColumnarIndexEntry*>(fData + fHeader->indexOffset);
+
+        for(std::uint32_t k = 0; k < fHeader->nColumns; k++)
+        {
+            fFirstSegment.push_back(fNSegments);
+            fNSegments += MyColumnarSegments(fColumns[k].type);
+        }
+    }
+
+    ~MyColumnarReader()
+    {
+        if(fData)
+            munmap(const_cast<char*>(fData), fSize);
+    }
+
+    MyColumnarReader(const MyColumnarReader&) = delete;
+    MyColumnarReader &operator=(const MyColumnarReader&) = delete;
+
+    inline std::uint64_t GetNEvents() const { return fHeader->nEvents; } /**< @brief Get the number of events.*/
+    inline std::size_t GetNChunks() const { return fHeader->nChunks; } /**< @brief Get the number of chunks.*/
+    inline std::size_t GetNColumns() const { return fHeader->nColumns; } /**< @brief Get the number of columns.*/
+    inline std::uint32_t GetFlags() const { return fHeader->flags; } /**< @brief Get the flags of the file.*/
+    inline const std::string &GetSchemaName() const { return fSchemaName; } /**< @brief Get the name of the output schema.*/
+    inline std::uint32_t GetSchemaVersion() const { return fSchemaVersion; } /**< @brief Get the version of the output schema, 0 for the files without.*/
+    inline const MyColumnarColumn &GetColumn(std::size_t column) const { return fColumns[column]; } /**< @brief Get the name and the type of a column.*/
+    inline std::uint64_t GetFirstEvent(std::size_t chunk) const { return fIndex[chunk].firstEvent; } /**< @brief Get the index of the first event of a chunk.*/
+
+    /** @brief Index of a column by name, throws if missing.*/
+    std::size_t FindColumn(const std::string &name) const
+    {
+        for(std::size_t k = 0; k < fHeader->nColumns; k++)
+            if(name == fColumns[k].name)
+                return k;
+        throw std::runtime_error("No column " + name + " in the columnar file");
+    }
+
+    /** @brief The bytes of a chunk, header included.*/
+    MySpan<char> GetRawChunk(std::size_t chunk) const
+    {
+        const MyColumnarChunkHeader *header = GetChunkHeader(chunk);
+        return MySpan<char>(reinterpret_cast<const char*>(header), header->size);
+    }
+
+    /** @brief View over a chunk, decoding its integer segments if compressed.*/
+    MyColumnarChunkView GetChunk(std::size_t chunk) const
+    {
+        const MyColumnarChunkHeader *header = GetChunkHeader(chunk);
+        const char *base = reinterpret_cast<const char*>(header);
+        const MyColumnarSegment *segments = reinterpret_cast<const MyColumnarSegment*>(header + 1);
+
+        MyColumnarChunkView view;
+        view.fNEvents = header->nEvents;
+        view.fFirstSegment = fFirstSegment;
+        view.fSegments.resize(fNSegments);
+        for(std::size_t s = 0; s < fNSegments; s++)
+        {
+            if(segments[s].offset + segments[s].size > header->size)
+                throw std::runtime_error("Corrupted chunk in the columnar file");
+            view.fSegments[s] = base + segments[s].offset;
+        }
+
+        if(!(fHeader->flags & columnarFlagDeltaVarint))
+            return view;
+
+        // Decode the integer segments; the offsets come before the values
+        view.fDecoded.reserve(fNSegments);
+        for(std::size_t k = 0; k < fHeader->nColumns; k++)
+        {
+            std::size_t s = fFirstSegment[k];
+            std::uint32_t type = fColumns[k].type;
+
+            if(type == kColumnarInt)
+                Decode(view, s, segments[s], header->nEvents);
+            else if(MyColumnarIsArray(type))
+            {
+                Decode(view, s, segments[s], header->nEvents + 1);
+                std::size_t nValues = view.fDecoded.back()[header->nEvents];
+                if(type == kColumnarIntArray)
+                    Decode(view, s + 1, segments[s + 1], nValues);
+            }
+        }
+
+        return view;
+    }
+
+private:
+    [[noreturn]] void Fail(const std::string &message)
+    {
+        munmap(const_cast<char*>(fData), fSize);
+        fData = nullptr;
+        throw std::runtime_error(message);
+    }
+
+    const MyColumnarChunkHeader *GetChunkHeader(std::size_t chunk) const
+    {
+        if(chunk >= fHeader->nChunks || fIndex[chunk].offset + sizeof(MyColumnarChunkHeader) > fSize)
+            throw std::runtime_error("No chunk " + std::to_string(chunk) + " in the columnar file");
+
+        const MyColumnarChunkHeader *header = reinterpret_cast<const MyColumnarChunkHeader*>(fData + fIndex[chunk].offset);
+        if(header->magic != columnarChunkMagic || fIndex[chunk].offset + header->size > fSize)
+            throw std::runtime_error("Corrupted chunk in the columnar file");
+        return header;
+    }
+
+    static void Decode(MyColumnarChunkView &view, std::size_t s, const MyColumnarSegment &segment, std::size_t n)
+    {
+        view.fDecoded.emplace_back(n);
+        const char *begin = view.fSegments[s];
+        if(!MyDecodeDeltaVarint(begin, begin + segment.size, view.fDecoded.back().data(), n))
+            throw std::runtime_error("Corrupted segment in the columnar file");
+        view.fSegments[s] = reinterpret_cast<const char*>(view.fDecoded.back().data());
+    }
+
+    const char *fData = nullptr; /**< @brief The mapped file.*/
+    std::size_t fSize = 0; /**< @brief Size of the file.*/
+    const MyColumnarFileHeader *fHeader = nullptr; /**< @brief Header of the file.*/
+    const MyColumnarColumn *fColumns = nullptr; /**< @brief Table of the columns.*/
+    const MyColumnarIndexEntry *fIndex = nullptr; /**< @brief Index of the chunks.*/
+    std::vector<std::size_t> fFirstSegment; /**< @brief First segment of every column.*/
+    std::size_t fNSegments = 0; /**< @brief Number of segments of a chunk.*/
+    std::string fSchemaName = "full"; /**< @brief Name of the output schema.*/
+    std::uint32_t fSchemaVersion = 0; /**< @brief Version of the output schema.*/
+};
+
+#endif  // COLUMNARREADER_HH
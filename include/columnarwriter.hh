@@ -0,0 +1,118 @@
+/**
+ * @file columnarwriter.hh
+ * @brief Declaration of the classes @ref MyColumnarChunk and
+ * @ref MyColumnarWriter
+ */
+#ifndef COLUMNARWRITER_HH
+#define COLUMNARWRITER_HH
+
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "globals.hh"
+
+#include "ntuple.hh"
+#include "eventrecord.hh"
+#include "columnarreader.hh"
+
+/**
+ * @brief Thread-local block of events in columnar layout, filled event by
+ * event and appended to the @ref MyColumnarWriter when full.
+ *
+ * The columns are the ones of an output schema, converted to their stored
+ * type when added. The buffers keep their capacity between the chunks.
+ */
+class MyColumnarChunk
+{
+public:
+    /** @brief Sets the output schema of the chunk, emptying it.*/
+    void SetSchema(const MyOutputSchema &schema);
+    /** @brief Appends the columns of an event.*/
+    void Add(const MyEventRecord &record);
+    /** @brief Empties the chunk, keeping the capacity.*/
+    void Clear();
+    /**
+     * @brief Serializes the chunk in the columnar format (see
+     * columnarreader.hh).
+     *
+     * @param bytes The output buffer, overwritten.
+     * @param compress Whether to delta-varint encode the integer segments.
+     */
+    void Serialize(std::vector<char> &bytes, G4bool compress) const;
+
+    inline G4int GetNEvents() const { return fNEvents; } /**< @brief Get the number of events of the chunk.*/
+
+private:
+    /** @brief A column of the chunk.*/
+    struct Column
+    {
+        MyOutputColumn column; /**< @brief The column of the schema.*/
+        std::vector<std::int32_t> offsets; /**< @brief Offsets of the vector columns.*/
+        std::vector<char> values; /**< @brief Flat values, of the stored type.*/
+    };
+
+    G4int fNEvents = 0; /**< @brief Number of events of the chunk.*/
+    std::vector<Column> fColumns; /**< @brief The columns, in the order of the schema.*/
+};
+
+
+
+/**
+ * @brief Writer of the columnar event files, an output backend alternative to
+ * the root TTree (/MC_LYSO/output/format columnar).
+ *
+ * The file of the run is opened and closed by the master @ref MyRunAction,
+ * the chunks are appended by every thread (see @ref MyColumnarChunk). The
+ * file can be read with the header-only @ref MyColumnarReader.
+ */
+class MyColumnarWriter
+{
+public:
+    MyColumnarWriter() = default; /**< @brief Constructor of the class.*/
+    ~MyColumnarWriter(); /**< @brief Destructor of the class, it closes the file.*/
+
+    /** @brief The writer of the file of the run, shared by the threads.*/
+    static MyColumnarWriter *Instance();
+
+    /**
+     * @brief Creates the file and writes its header and the schema.
+     *
+     * @param fileName The name of the file.
+     * @param compress Whether the integer segments are delta-varint encoded.
+     * @param schema The output schema, the one of the chunks appended.
+     * @return false if the file can't be created.
+     */
+    G4bool Open(const G4String &fileName, G4bool compress, const MyOutputSchema &schema);
+    /** @brief Serializes and appends a chunk, thread-safe.*/
+    void Append(const MyColumnarChunk &chunk);
+    /** @brief Writes the index of the chunks and completes the header.*/
+    void Close();
+
+    inline G4bool IsOpen() const { return fFile.is_open(); } /**< @brief Tells whether a file is being written.*/
+    inline G4bool IsCompressed() const { return fCompress; } /**< @brief Tells whether the chunks are compressed.*/
+
+    /**
+     * @brief Concatenates columnar files with the same schema, copying their
+     * chunks as they are (e.g. to merge the shards).
+     *
+     * @return false if a file can't be read or has a different schema.
+     */
+    static G4bool Concatenate(const std::vector<G4String> &inputFiles, const G4String &outputFile);
+
+private:
+    /** @brief Creates the file with a given schema and table of columns.*/
+    G4bool Open(const G4String &fileName, std::uint32_t flags, const MyColumnarSchemaInfo &schema, const std::vector<MyColumnarColumn> &columns);
+    /** @brief Appends the bytes of a chunk, with the writer locked.*/
+    void AppendBytes(const char *bytes, std::uint64_t size, std::uint32_t nEvents);
+
+    std::ofstream fFile; /**< @brief The output file.*/
+    MyColumnarSchemaInfo fSchema; /**< @brief Name and version of the output schema.*/
+    G4bool fCompress = false; /**< @brief Whether the chunks are compressed.*/
+    std::uint64_t fOffset = 0; /**< @brief Current size of the file.*/
+    std::uint64_t fNEvents = 0; /**< @brief Number of events written.*/
+    std::vector<MyColumnarIndexEntry> fIndex; /**< @brief Index of the chunks written.*/
+    MyColumnarFileHeader fHeader; /**< @brief Header of the file, completed at Close().*/
+};
+
+#endif  // COLUMNARWRITER_HH
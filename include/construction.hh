@@ -20,9 +20,17 @@
 #include "G4GenericMessenger.hh"
 #include "G4OpticalSurface.hh"
 #include "G4LogicalSkinSurface.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4UserLimits.hh"
+#include "G4LogicalVolumeStore.hh"
 
 #include "globalsettings.hh"
 #include "detector.hh"
+#include "fastlight.hh"
+#include "crystalsd.hh"
+#include "cosmictriggersd.hh"
+#include "filter.hh"
 
 /**
  * @brief Mandatory user initialization concrete class of
@@ -43,9 +51,23 @@ public:
     MyDetectorConstruction();
     ~MyDetectorConstruction() override = default; /**< @brief Destructor of the class.*/
 
-    inline G4LogicalVolume *GetScoringVolume() const { return fScoringVolume;} /**< @brief Get the scoring volume. It will be used by MySteppingAction::UserSteppingAction().*/
-    inline G4LogicalVolume *GetCosmicTriggerVolume() const { return fCosmicTriggerVolume; }
-    inline G4LogicalVolume *GetDecayTriggerVolume() const { return fDecayTriggerVolume; }
+    /** @brief Get the construction and SiPM settings a light map must be built with to be used in this geometry.*/
+    inline MyLightMapGeometry GetLightMapGeometry() const { return {fIsGrease, fIsOpticalGreaseSurface, fIsLightGuide, nLightGuideMat, fIsPCB, fIsEndcap, MySensitiveDetector::efficiencySetting, GS::GetPDEChecksum(), 4.*GS::halfXsideDetector*GS::halfYsideDetector/mm2}; }
+    /** @brief Get the factor the scintillation yield is scaled by: GS::peakPDE if the PDE pre-scaling is on, 1 otherwise.*/
+    inline G4double GetYieldScale() const { return fIsPDEPrescaling ? GS::peakPDE : 1.; }
+    /** @brief Get the readout window: the optical photons (and the hits) later than it are dropped. DBL_MAX if not set.*/
+    inline G4double GetReadoutWindow() const { return fReadoutWindow > 0. ? fReadoutWindow : DBL_MAX; }
+    inline G4bool IsReadoutWindow() const { return fReadoutWindow > 0.; } /**< @brief Tells whether a readout window is set.*/
+
+    /**
+     * @brief Sets the readout window, before /run/initialize only: the
+     * G4UserSpecialCuts of the optical photons and the limits of the volumes
+     * are added at the initialization, and only if the window is set, so that
+     * the optical steps don't pay for them otherwise.
+     *
+     * @param window The readout window. A non-positive value disables it.
+     */
+    void SetReadoutWindow(G4double window);
     
     /**
      * @brief Construct the detector geometry.
@@ -60,7 +82,15 @@ public:
     G4VPhysicalVolume *Construct() override;
 
 private:
-    void ConstructSDandField() override; /**< @brief It sets all the SiPMs' silicon layers as sensitive detectors.*/
+    /**
+     * @brief It sets all the SiPMs' silicon layers as sensitive detectors.
+     *
+     * The crystal and the cosmic rays detectors get their scoring SDs,
+     * @ref MyCrystalSD and @ref MyCosmicTriggerSD.
+     * If the fast light simulation is enabled, it also attaches a
+     * @ref MyFastLightModel to the crystal region.
+     */
+    void ConstructSDandField() override;
     void ConstructGrease(); /**< @brief Auxiliary function called by Construct() for building the optical grease.*/
     void ConstructLightGuide(); /**< @brief Auxiliary function called by Construct() for building the lightguides.*/
     void ConstructPCB(); /**< @brief Auxiliary function called by Construct() for building the PCBs.*/
@@ -70,21 +100,19 @@ private:
 
     /**
      * @brief Auxiliary function called by Construct() for putting in the right
-     * position every SiPM.
+     * position every SiPM, according to the channel map GS::sipmChannels.
      * @param physFrontSiPM The pointer to the physical volume of the SiPM to
      * place on the front face of the scintillator
      * @param physBackSiPM The pointer to the physical volume of the SiPM to
      * place on the back face of the scintillator
-     * @param row The row of the SiPMs panel where the detector has to be placed
-     * @param col The column of the SiPMs panel where the detector has to be
-     * placed
-     * @param halfCols The integer half of the number of SiPMs in the row
-     * @param index The index number of the SiPM
+     * @param ch The channel of the SiPM. The copy numbers of the packages
+     * are GS::EncodeSiPMCopyNo() of the face and the channel
      */
-    void PositionSiPMs(G4VPhysicalVolume *physFrontSiPM, G4VPhysicalVolume *physBackSiPM, G4int row, G4int col, G4int index);
+    void PositionSiPMs(G4VPhysicalVolume *physFrontSiPM, G4VPhysicalVolume *physBackSiPM, G4int ch);
     void DefineMaterials(); /**< @brief Defines all materials.*/
     void DefineVisAttributes(); /**< @brief Defines the visualization attributes for every component of the apparatus.*/
     void DefineCommands(); /**< @brief Defines new user commands for detector construction.*/
+    void SetReadoutLimits(); /**< @brief Attaches the G4UserLimits of the readout window to all the logical volumes, if the window is set.*/
 
     // Logical volumes
     G4LogicalVolume *logicWorld, /**< @brief Pointer to world logical volume.*/
@@ -98,11 +126,6 @@ private:
                     *logicLightGuide, /**< @brief Pointer to light guide logical volume.*/
                     *logicGrease, /**< @brief Pointer to optical grease logical volume.*/
                     *logicCosmicRaysDetector;
-    
-    // Scoring logical volume
-    G4LogicalVolume *fScoringVolume, /**< @brief Pointer used to define the logical volume of the scoring volume. In the application it is assigned to @ref logicScintillator.*/
-                    *fDecayTriggerVolume,
-                    *fCosmicTriggerVolume;
 
     // Materials
     G4Material *fLYSO, /**< @brief Pointer to the LYSO material.*/
@@ -119,16 +142,25 @@ private:
     // Surfaces
     G4OpticalSurface *fOpGreaseSurface; /**< @brief Pointer to the optical grease surface.*/
 
+    // Readout window, enforced on the optical photons by G4UserSpecialCuts
+    G4UserLimits *fReadoutLimits; /**< @brief Pointer to the user limits shared by all the logical volumes.*/
+
     // Generic Messenger and settable variables 
-    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
+    G4GenericMessenger *fMessenger, /**< @brief Generic messenger of the class.*/
+                       *fReadoutMessenger; /**< @brief Generic messenger of the readout settings.*/
     G4bool fIsGrease, /**< @brief Flag indicating whether the optical grease must be constructed.*/
            fIsOpticalGreaseSurface, /**< @brief Flag indicating whether the optical grease surface must be constructed.*/
            fIsLightGuide, /**< @brief Flag indicating whether the light guides must be constructed.*/
            fIsPCB, /**< @brief Flag indicating whether the PCBs must be constructed.*/
            fIsEndcap, /**< @brief Flag indicating whether the endcaps must be constructed.*/
            fIsASiPM, /**< @brief Flag indicating whether only one SiPM must be constructed.*/
-           fIsCosmicRaysDetectors;
+           fIsCosmicRaysDetectors,
+           fIsFastLight, /**< @brief Flag indicating whether the optical photons in the crystal are handled by @ref MyFastLightModel.*/
+           fIsPDEPrescaling; /**< @brief Flag indicating whether the scintillation yield is scaled by the peak PDE, which is then divided out in the SD.*/
+    G4String fFastLightMap; /**< @brief Name of the light map file used by the fast light simulation.*/
     G4int nLightGuideMat; /**< @brief Indicates which material has to be used for light guides; 1 for plexiglass, 2 for sapphire.*/
+    G4double fNominalYieldLYSO; /**< @brief Scintillation yield of the LYSO, before the pre-scaling.*/
+    G4double fReadoutWindow; /**< @brief Readout window, from the beginning of the event. Disabled if not positive.*/
 };
 
 #endif  // CONSTRUCTION_HH
@@ -0,0 +1,83 @@
+/**
+ * @file cosmicrays.hh
+ * @brief Declaration of the class @ref MyCosmicRaySampler
+ */
+#ifndef COSMICRAYS_HH
+#define COSMICRAYS_HH
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "globalsettings.hh"
+
+/**
+ * @brief Samplers of the cosmic muons and geometric acceptance of the cosmic
+ * rays trigger.
+ *
+ * The kinetic energy follows E^-2.7, flat below @ref breakEnergy, up to
+ * @ref maxEnergy; the direction is downward with dN/dOmega proportional to
+ * cos^2(theta), theta from the vertical. Both are sampled by inverting their
+ * cumulative distributions.
+ * In cosmic rays mode the tracks are generated only in the phase space of the
+ * trigger, i.e. crossing the top face of the upper paddle and the bottom face
+ * of the lower one. A point is taken on each face: the pair is uniform in the
+ * area elements, while the directions need a density cos^2(theta) in the solid
+ * angle, i.e. cos^5(theta) in the area of the lower face. The pair is kept
+ * with probability cos^5(theta), which is above 0.7 with the paddles of
+ * @ref GS, so no track misses the trigger and a few pairs are drawn.
+ *
+ * The acceptance is the fraction of the muons crossing the upper paddle that
+ * cross the lower one as well, the integral of cos^5(theta) over the pairs of
+ * points divided by the one over the whole lower hemisphere. It depends only
+ * on the geometry and is computed with a Gauss-Legendre quadrature of the
+ * distribution of the separations of the points: a rate of muons through the
+ * upper paddle times the acceptance gives the trigger rate.
+ */
+class MyCosmicRaySampler
+{
+public:
+    /** @brief Samples the kinetic energy of a muon.*/
+    static G4double SampleEnergy();
+    /** @brief Samples cos(theta) of a downward muon, in [0, 1].*/
+    static G4double SampleCosTheta();
+    /**
+     * @brief Samples a downward direction, with y vertical.
+     *
+     * @param cosTheta The cosine of the angle from the vertical.
+     */
+    static G4ThreeVector SampleDirection(G4double cosTheta);
+    /**
+     * @brief Samples a muon track crossing both paddles of the trigger.
+     *
+     * @param position The starting point, on the top face of the upper paddle.
+     * @param direction The direction, downward.
+     */
+    static void SampleTriggeredTrack(G4ThreeVector &position, G4ThreeVector &direction);
+
+    /** @brief Fraction of the muons crossing the upper paddle that cross the lower one.*/
+    static G4double GetAcceptance();
+    /** @brief Acceptance times the area of the upper paddle times the solid angle weight 2pi/3, in mm2*sr.*/
+    static G4double GetEtendue();
+    /** @brief Fraction of the pairs of points kept by @ref SampleTriggeredTrack().*/
+    static G4double GetSamplingEfficiency();
+
+    static constexpr G4double breakEnergy = 3.4*GeV; /**< @brief Energy below which the spectrum is flat.*/
+    static constexpr G4double maxEnergy = 1.*TeV; /**< @brief Maximum kinetic energy.*/
+    static constexpr G4double spectralIndex = 2.7; /**< @brief Index of the power law of the spectrum.*/
+    static constexpr G4double halfSideCountingArea = 5.*cm; /**< @brief Half side of the square the muons start from in counting mode.*/
+
+private:
+    /** @brief Vertical distance between the top face of the upper paddle and the bottom face of the lower one.*/
+    static constexpr G4double height = 2.*(GS::yCosmicRayDetector + GS::halfYsideCosmicRayDetector);
+
+    /**
+     * @brief Integral of cos^n(theta) over the pairs of points of the faces of
+     * the paddles, in mm4.
+     *
+     * @param n The power of the cosine.
+     */
+    static G4double IntegrateOverPaddles(G4int n);
+};
+
+#endif  // COSMICRAYS_HH
@@ -0,0 +1,53 @@
+/**
+ * @file cosmictriggersd.hh
+ * @brief Declaration of the class @ref MyCosmicTriggerSD
+ */
+#ifndef COSMICTRIGGERSD_HH
+#define COSMICTRIGGERSD_HH
+
+#include "G4VSensitiveDetector.hh"
+#include "G4EventManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+
+class MyEventAction;
+
+/**
+ * @brief Concrete class of G4VSensitiveDetector, representing the two
+ * cosmic rays trigger detectors (copy number 0 = up, 1 = bottom).
+ *
+ * When the primary muon crosses a detector it sets the corresponding trigger
+ * flag of @ref MyEventAction; the muon is killed in the bottom one.
+ * It is active only in the cosmic rays modes (see
+ * MyRunAction::BeginOfRunAction()).
+ */
+class MyCosmicTriggerSD : public G4VSensitiveDetector
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     * @param name The name of the sensitive detector.
+     */
+    MyCosmicTriggerSD(G4String name);
+    ~MyCosmicTriggerSD() override = default; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Takes the event action of the thread at the beginning of each
+     * event.
+     *
+     * @param hce Pointer to the G4HCofThisEvent object. Not used.
+     */
+    void Initialize(G4HCofThisEvent *hce) override;
+    /**
+     * @brief Fires the trigger of the detector crossed by the primary muon.
+     *
+     * @param aStep G4Step object of the current step.
+     * @param ROhist G4TouchableHistory object. Obsolete, not used.
+     */
+    G4bool ProcessHits(G4Step *aStep, G4TouchableHistory *ROhist) override;
+
+private:
+    MyEventAction *fEventAction; /**< @brief Pointer to the event action storing the triggers.*/
+};
+
+#endif  // COSMICTRIGGERSD_HH
@@ -0,0 +1,54 @@
+/**
+ * @file crystalsd.hh
+ * @brief Declaration of the class @ref MyCrystalSD
+ */
+#ifndef CRYSTALSD_HH
+#define CRYSTALSD_HH
+
+#include "G4VSensitiveDetector.hh"
+#include "G4EventManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+
+class MyEventAction;
+
+/**
+ * @brief Concrete class of G4VSensitiveDetector, scoring the energy
+ * deposition inside the crystal.
+ *
+ * For every step of a non-optical particle in the crystal (the optical
+ * photons are rejected by a @ref MyNonOpticalFilter) it stores in
+ * @ref MyEventAction the total energy deposit, the maximum deposit per unit
+ * length with its position, and the arrival time and position of the
+ * primary particle (or daughters). No hits collection is created.
+ */
+class MyCrystalSD : public G4VSensitiveDetector
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     * @param name The name of the sensitive detector.
+     */
+    MyCrystalSD(G4String name);
+    ~MyCrystalSD() override = default; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Takes the event action of the thread at the beginning of each
+     * event.
+     *
+     * @param hce Pointer to the G4HCofThisEvent object. Not used.
+     */
+    void Initialize(G4HCofThisEvent *hce) override;
+    /**
+     * @brief Updates the energy deposition data of the event.
+     *
+     * @param aStep G4Step object of the current step.
+     * @param ROhist G4TouchableHistory object. Obsolete, not used.
+     */
+    G4bool ProcessHits(G4Step *aStep, G4TouchableHistory *ROhist) override;
+
+private:
+    MyEventAction *fEventAction; /**< @brief Pointer to the event action storing the data.*/
+};
+
+#endif  // CRYSTALSD_HH
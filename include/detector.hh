@@ -7,6 +7,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include "G4VSensitiveDetector.hh"
 #include "G4RunManager.hh"
@@ -16,9 +17,13 @@
 #include "G4Step.hh"
 #include "G4SDManager.hh"
 #include "G4PhysicsFreeVector.hh"
+#include "G4VProcess.hh"
+#include "G4OpticalPhoton.hh"
 
 #include "globalsettings.hh"
-#include "hit.hh"
+#include "hitbuffer.hh"
+
+class MyEventAction;
 
 /**
  * @brief Concrete class of G4VSensitiveDetector, representing the detector
@@ -30,26 +35,32 @@ public:
     /**
      * @brief Constructor of the class.
      * @param name The name of the sensitive detector.
-     * @param hitsCollectionName The name of the @ref MyHitsCollection
-     * associated with the SD.
+     * @param yieldScale The factor the scintillation yield has been scaled
+     * by (see MyDetectorConstruction): the scintillation photons are accepted
+     * with the PDE relative to it.
      */
-    MySensitiveDetector(G4String name, G4String hitsCollectionName);
+    MySensitiveDetector(G4String name, G4double yieldScale = 1.);
     ~MySensitiveDetector() override = default; /**< @brief Destructor of the class.*/
     
     /**
-     * @brief Associates a new @ref MyHitsCollection with a G4HCofThisEvent
-     * object at the beginning of each event.
+     * @brief Takes the @ref MyHitBuffer of the thread, the current readout
+     * window and the event action the dropped hits are counted in, at the
+     * beginning of each event.
      * 
-     * @param hce Pointer to the G4HCofThisEvent object.
+     * @param hce Pointer to the G4HCofThisEvent object. Not used, the hits
+     * are not stored in a G4VHitsCollection.
      */
     void Initialize(G4HCofThisEvent *hce) override;
     /**
      * @brief For every optical photon that hits the SD this method
-     * instantiates a MyHit object, fills his data and store it in the
-     * @ref MyHitsCollection of the event.
+     * appends a hit to the @ref MyHitBuffer of the event.
      *
      * This method is invoked by G4SteppingManager when a step is composed in
      * the G4LogicalVolume which has the pointer to this SD.
+     * The photon is accepted with the PDE of the channel, divided by
+     * @ref fYieldScale if it comes from the scintillation.
+     * Other particles are not detected, but in the Si trigger runs the
+     * electrons crossing the trigger SiPM fire the trigger of the event.
      *
      * @param aStep G4Step object of the current step.
      * @param ROhist G4TouchableHistory object. Obsolete, not used.
@@ -57,16 +68,39 @@ public:
     G4bool ProcessHits(G4Step *aStep, G4TouchableHistory *ROhist) override;
     // void EndOfEvent(G4HCofThisEvent*) override;
 
+    /**
+     * @brief Appends a hit to the @ref MyHitBuffer of the event.
+     *
+     * It is used by ProcessHits() and by the models that detect optical
+     * photons without tracking them (see @ref MyFastLightModel).
+     * Hits later than the readout window are dropped and counted.
+     *
+     * @param time The time of detection.
+     * @param face The face of the SiPM: 0 = front, 1 = back.
+     * @param ch The channel of the SiPM.
+     * @return true if the hit is stored.
+     */
+    G4bool InsertHit(G4double time, G4int face, G4int ch);
+
+    inline void SetSiTrigger(G4bool isSiTrigger) { fIsSiTrigger = isSiTrigger; } /**< @brief Enables the Si trigger (mode 22), set at the beginning of the run.*/
+
+    enum SetEfficiencies {fIsNominalEfficiency, fIsFixedEfficiency, fIsRandomEfficiency, fIsAssignedEfficiency}; /**< @brief Type of PDEs.*/
+    static constexpr SetEfficiencies efficiencySetting = fIsNominalEfficiency; /**< @brief Type of PDEs of all the SDs, part of the settings of a light map.*/
+
 private:
     void RandomizeEfficiencies(); /**< @brief Fixes random efficiencies for all MPPCs.*/
     void GetEfficienciesFromFile(); /**< @brief Reads and sets the efficiencies from the file.*/
+    void CheckEfficiencies() const; /**< @brief Warns if an efficiency can't be reached with the pre-scaled yield.*/
 
-    MyHitsCollection *fHitsCollection; /**< @brief Pointer to the hits collection of the event.*/
+    MyHitBuffer *fHitBuffer; /**< @brief Pointer to the hit buffer of the thread.*/
+    MyEventAction *fEventAction; /**< @brief Pointer to the event action, counting the hits out of the readout window.*/
+    G4double fReadoutWindow; /**< @brief Readout window of the event.*/
+    G4bool fIsSiTrigger; /**< @brief Flag indicating whether the electrons fire the Si trigger.*/
 
-    enum SetEfficiencies {fIsNominalEfficiency, fIsFixedEfficiency, fIsRandomEfficiency, fIsAssignedEfficiency}; /**< @brief Type of PDEs.*/
     SetEfficiencies fEfficiencySetting; /**< @brief Type of SetEfficiencies.*/
-    G4PhysicsFreeVector *fPDE;
-    G4double fFixedEfficiency;
+    G4PhysicsFreeVector *fPDE; /**< @brief Nominal PDE as a function of the photon energy.*/
+    G4double fFixedEfficiency; /**< @brief PDE of all the MPPCs if fixed.*/
+    G4double fYieldScale; /**< @brief Scale factor of the scintillation yield, 1 if no pre-scaling.*/
     G4double fFrontEfficiency[GS::nOfSiPMs]; /**< @brief Array of PDEs for front MPPCs.*/
     G4double fBackEfficiency[GS::nOfSiPMs]; /**< @brief Array of PDEs for back MPPCs.*/
 };
@@ -0,0 +1,108 @@
+/**
+ * @file digitizer.hh
+ * @brief Declaration of the class @ref MyDigitizer
+ */
+#ifndef DIGITIZER_HH
+#define DIGITIZER_HH
+
+#include <vector>
+
+#include "globals.hh"
+#include "G4GenericMessenger.hh"
+
+#include "globalsettings.hh"
+#include "hitbuffer.hh"
+
+/**
+ * @brief Digitization of the SiPMs: turns the hits of an event into sampled
+ * waveforms, one per channel, and extracts from them the charge and the
+ * leading-edge time.
+ *
+ * Every hit is a single photoelectron (SPE) pulse, a double exponential of
+ * peak amplitude 1 p.e., plus the avalanches triggered by optical crosstalk
+ * (each one triggers another with the crosstalk probability). Dark counts
+ * are added uniformly in time, Poisson-distributed over the channels; the
+ * ones earlier than the window contribute with their tails.
+ * The pulse is tabulated once, at a few sub-sample phases, so every
+ * avalanche is a scaled sum of the kernel into the waveform, a contiguous
+ * loop the compiler vectorizes.
+ *
+ * The channels follow the numbering of the packages placed by
+ * MyDetectorConstruction::PositionSiPMs(), and the outputs are per face,
+ * [ch] or [ch*nSamples + sample]. There is one digitizer per thread, owned
+ * by @ref MyEventAction; when enabled, the output schemas write its outputs
+ * instead of the photon lists.
+ */
+class MyDigitizer
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * It defines the UI commands of the digitizer.
+     */
+    MyDigitizer();
+    ~MyDigitizer(); /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Digitizes the hits of an event and fills the outputs.
+     *
+     * @param hits The hits of the event.
+     */
+    void Digitize(const MyHitBuffer &hits);
+
+    inline G4bool IsEnabled() const { return fEnabled; } /**< @brief Tells whether the digitizer runs.*/
+    inline G4bool SavesTraces() const { return fEnabled && fSaveTraces; } /**< @brief Tells whether the sampled waveforms are written.*/
+
+    // Outputs, [face]
+    std::vector<G4double> fCharge[2], /**< @brief Charge of every channel in p.e., [face][ch].*/
+                          fLeadTime[2], /**< @brief Leading-edge time of every channel (999999. if below threshold), [face][ch].*/
+                          fTrace[2]; /**< @brief Sampled waveforms in p.e., if saved, [face][ch*nSamples + sample].*/
+
+private:
+    /** @brief Tabulates the SPE pulse and allocates the waveforms, if the settings changed.*/
+    void Configure();
+    /**
+     * @brief Adds a pulse to the waveform of a channel.
+     *
+     * @param k The channel, face*GS::nOfSiPMs + ch.
+     * @param time The time of the avalanche.
+     * @param amplitude The number of avalanches.
+     */
+    void AddPulse(G4int k, G4double time, G4double amplitude);
+    /** @brief Number of avalanches fired by a primary one, crosstalk included.*/
+    G4int SampleAvalanches() const;
+    /** @brief Charge and leading-edge time of a channel.*/
+    void Analyze(G4int k, G4double &charge, G4double &leadTime) const;
+
+    static constexpr G4int nPhases = 8; /**< @brief Number of sub-sample phases of the kernel.*/
+    static constexpr G4int nChannels = 2*GS::nOfSiPMs; /**< @brief Number of channels of both faces.*/
+
+    // Settings
+    G4bool   fEnabled, /**< @brief Whether the digitizer runs.*/
+             fSaveTraces; /**< @brief Whether the sampled waveforms are written.*/
+    G4double fSamplingPeriod, /**< @brief Sampling period of the waveforms.*/
+             fWindowStart, /**< @brief Time of the first sample.*/
+             fRiseTime, /**< @brief Rise time constant of the SPE pulse.*/
+             fFallTime, /**< @brief Fall time constant of the SPE pulse.*/
+             fDarkRate, /**< @brief Dark count rate of a SiPM.*/
+             fCrosstalk, /**< @brief Probability that an avalanche triggers another one.*/
+             fThreshold; /**< @brief Threshold of the leading-edge time, in p.e.*/
+    G4int    fNSamples; /**< @brief Number of samples of the waveforms.*/
+
+    // Kernel and waveforms, built by Configure()
+    G4double fKernelPeriod = 0., /**< @brief Sampling period the kernel has been built with.*/
+             fKernelRise = 0., /**< @brief Rise time the kernel has been built with.*/
+             fKernelFall = 0.; /**< @brief Fall time the kernel has been built with.*/
+    G4int    fKernelSamples = 0; /**< @brief Number of samples the waveforms have been allocated with.*/
+    G4int    fKernelLength = 0; /**< @brief Number of samples of a phase of the kernel.*/
+    G4double fPulseArea = 1.; /**< @brief Integral of the SPE pulse, for the charge in p.e.*/
+    std::vector<G4double> fKernel; /**< @brief The SPE pulse, [phase][sample].*/
+    std::vector<G4double> fWaveforms; /**< @brief The waveforms of the event, [k][sample].*/
+    std::vector<G4int> fTouched; /**< @brief The channels with pulses in the event, to analyze and reset.*/
+    std::vector<G4bool> fIsTouched; /**< @brief Whether a channel has pulses in the event, [k].*/
+
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
+};
+
+#endif  // DIGITIZER_HH
@@ -6,6 +6,7 @@
 #define EVENT_HH
 
 #include <vector>
+#include <chrono>
 
 #include "G4RunManager.hh"
 #include "G4UserEventAction.hh"
@@ -13,8 +14,16 @@
 #include "G4AnalysisManager.hh"
 
 #include "globalsettings.hh"
-#include "hit.hh"
+#include "hitbuffer.hh"
+#include "digitizer.hh"
 #include "generator.hh"
+#include "lightmapbuilder.hh"
+#include "perfcounters.hh"
+#include "ledstats.hh"
+#include "runstats.hh"
+#include "eventrecord.hh"
+
+class MyRunAction;
 
 /** 
  * @brief User action concrete class of G4UserEventAction. In addition to
@@ -25,22 +34,33 @@
 class MyEventAction : public G4UserEventAction
 {
 public:
-    MyEventAction() = default; /**< @brief Constructor of the class.*/
+    /**
+     * @brief Constructor of the class.
+     *
+     * It binds the vector columns of the @ref MyEventRecord to the hit
+     * buffer, to the position vectors and to the outputs of the digitizer.
+     */
+    MyEventAction();
     ~MyEventAction() override = default; /**< @brief Destructor of the class.*/
 
     /**
      * @brief Resets every data containers at the beginning of a new event.
+     *
+     * The containers are cleared without releasing their memory.
      * 
      * @param event Pointer to the G4Event.
      */
     void BeginOfEventAction(const G4Event *event) override;
     /**
-     * @brief Fills the TTree with the data of the event.
+     * @brief Fills the record of the event and hands it to the
+     * @ref MyRunAction, which writes it.
      *  
-     * It accesses the MyHitsCollection of the event and fills the detector
-     * branches with data stored in it. After that, it fills the other branches
-     * with data concerning the primary particle and the energy deposit in the
-     * crystal.
+     * The detector columns are bound to the @ref MyHitBuffer of the event,
+     * only the positions of the SiPMs hit are filled here. After that, it
+     * fills the other columns with data concerning the primary particle and
+     * the energy deposit in the crystal. If enabled, the digitizer runs
+     * on the hits, or the arrival time histograms are filled, instead of
+     * the positions.
      *
      * @param event Pointer to the G4Event.
      */
@@ -91,11 +111,77 @@ public:
     };
 
 
+    /**
+     * @brief Tells whether the trigger of the run mode fired in the event.
+     *
+     * Modes 22 (Si trigger) and 30/31 (cosmic rays coincidence) require a
+     * trigger, the other modes always pass.
+     *
+     * @param modeType The run mode.
+     */
+    G4bool IsEventTriggered(G4int modeType) const;
+
+    inline void AddWindowKilledPhoton() { fNKilledWindow++; } /**< @brief Counts an optical photon killed during the tracking by the readout window.*/
+    inline void AddLateHit() { fNLateHits++; } /**< @brief Counts a hit dropped by the SD because later than the readout window.*/
+
+    /**
+     * @brief Stores the ID and the seeds of the event, set by the
+     * @ref MyPrimaryGenerator before the event starts.
+     */
+    inline void SetEventSeeds(G4int eventID, G4int seed0, G4int seed1)
+    {
+        fEventID = eventID;
+        fSeed0 = seed0;
+        fSeed1 = seed1;
+    }
+
+    /**
+     * @brief Stores the LED fired in the event and the photons it emitted,
+     * set by the @ref MyPrimaryGenerator before the event starts.
+     *
+     * @param led The LED (see @ref MyLEDStats), -1 if none.
+     * @param nPhotons The number of photons emitted.
+     */
+    inline void SetLEDPulse(G4int led, G4int nPhotons)
+    {
+        fLEDID = led;
+        fLEDPhotons = nPhotons;
+    }
+
+    inline void SetRunAction(MyRunAction *runAction) { fRunAction = runAction; } /**< @brief Set the run action writing the events of the thread.*/
+    inline const MyEventRecord &GetRecord() const { return fRecord; } /**< @brief Get the record of the event, bound to the buffers of the columns.*/
+
+    /**
+     * @brief Sets the binning of the arrival time histograms, set by
+     * @ref MyRunAction at the beginning of the run.
+     *
+     * @param nBins The number of bins, 0 to write the photon lists instead.
+     * @param width The width of the bins.
+     * @param start The lower edge of the first bin.
+     */
+    inline void SetTimeBinning(G4int nBins, G4double width, G4double start)
+    {
+        fNTimeBins = nBins;
+        fTimeBinWidth = width;
+        fTimeBinStart = start;
+    }
+
+    /** @brief Sets whether only the hits per channel are written, set by @ref MyRunAction at the beginning of the run.*/
+    inline void SetCountsOnly(G4bool countsOnly) { fCountsOnly = countsOnly; }
+
+    /** @brief Sets whether the events are written in the ntuple, set by @ref MyRunAction at the beginning of the run.*/
+    inline void SetWriteNtuple(G4bool writeNtuple) { fWriteNtuple = writeNtuple; }
+
     inline void SetDecayTriggerSi(G4bool trg) { fDecayTriggerSi = trg; }
     inline void SetCosmicTriggerUp(G4bool trg) { fCosmicTriggerUp = trg; }
     inline void SetCosmicTriggerBottom(G4bool trg) { fCosmicTriggerBottom = trg; }
 
 
+    // Event's ID and seeds
+    G4int    fEventID, /**< @brief ID of the event, after the offset or the replay list.*/
+             fSeed0, /**< @brief First seed of the event.*/
+             fSeed1; /**< @brief Second seed of the event.*/
+
     // Primary's data
     G4double fTimeIn, /**< @brief Time of arrival of primary gamma.*/
              fPosXIn, /**< @brief X position of arrival of primary gamma.*/
@@ -112,24 +198,72 @@ public:
     G4ThreeVector fMaxEdepPos; /**< @brief Position of the maximum deposit of energy per unit length in the crystal.*/
 
     // Detectors' data
-    G4int                 fHitsNum_F, /**< @brief Total number of optical photons detected by SiPMs on the front face.*/
-                          fHitsNum_B; /**< @brief Total number of optical photons detected by SiPMs on the back face.*/
-    std::vector<G4double> fT_F, /**< @brief Vector containing times of detection of optical photons on the front face.*/
-                          fX_F, /**< @brief Vector containing x-positions of detection of optical photons on the front face.*/
+    MyHitBuffer           fHits; /**< @brief Hits of the event (times, channels and hits per channel of both faces), filled by MySensitiveDetector.*/
+    std::vector<G4double> fX_F, /**< @brief Vector containing x-positions of detection of optical photons on the front face.*/
                           fY_F, /**< @brief Vector containing y-positions of detection of optical photons on the front face.*/
-                          fT_B, /**< @brief Vector containing times of detection of optical photons on the back face.*/
                           fX_B, /**< @brief Vector containing x-positions of detection of optical photons on the back face.*/
                           fY_B; /**< @brief Vector containing y-positions of detection of optical photons on the back face.*/
-    std::vector<G4int>    fHitsNum_F_Ch,
-                          fChannel_F, /**< @brief Vector containing SiPM channels of detection of optical photons on the front face.*/
-                          fHitsNum_B_Ch,
-                          fChannel_B; /**< @brief Vector containing SiPM channels of detection of optical photons on the back face.*/
+    MyDigitizer           fDigitizer; /**< @brief Digitizer of the SiPMs, filling charges, leading-edge times and waveforms.*/
+    std::vector<G4int>    fTimeBins[2]; /**< @brief Arrival time histograms of the channels, [face][ch*nBins + bin].*/
+
+    // Readout window
+    G4int                 fNKilledWindow, /**< @brief Number of optical photons killed during the tracking by the readout window.*/
+                          fNLateHits; /**< @brief Number of hits dropped by the SD because later than the readout window.*/
+
+    // Light map mode
+    MyLightMapBuilder fLightMapBuilder; /**< @brief Accumulator of the light map statistics, registered by MyRunAction.*/
+
+    // LED modes
+    G4int      fLEDID = -1, /**< @brief LED fired in the event, -1 if none.*/
+               fLEDPhotons = 0; /**< @brief Number of photons emitted by the LED in the event.*/
+    MyLEDStats fLEDStats; /**< @brief Accumulator of the response of the channels per LED, registered by MyRunAction.*/
+
+    // Run statistics
+    MyRunStats fRunStats; /**< @brief Accumulator of the per-channel, occupancy, time and energy statistics, registered by MyRunAction.*/
+
+    // Benchmarks
+    MyPerfCounters fPerfCounters; /**< @brief Counters of the events, tracks, steps and hits, registered by MyRunAction.*/
 
     // Intercalibration triggers
     G4double fTimeOfDecay;
     G4bool   fDecayTriggerSi,
              fCosmicTriggerUp,
              fCosmicTriggerBottom;
+
+private:
+    MyRunAction *fRunAction = nullptr; /**< @brief Pointer to the run action writing the events.*/
+    MyEventRecord fRecord; /**< @brief Output of the event.*/
+    std::chrono::steady_clock::time_point fEventStart; /**< @brief Start of the event, for the busy time of the thread.*/
+    G4int fNTimeBins = 0; /**< @brief Number of bins of the arrival time histograms, 0 if not filled.*/
+    G4double fTimeBinWidth = 0.; /**< @brief Width of the bins of the arrival time histograms.*/
+    G4double fTimeBinStart = 0.; /**< @brief Lower edge of the arrival time histograms.*/
+    G4bool fCountsOnly = false; /**< @brief Whether only the hits per channel are written, without the positions.*/
+    G4bool fWriteNtuple = true; /**< @brief Whether the events are written in the ntuple.*/
+
+    /**
+     * @brief Fills the position vectors of a face with the centers of the
+     * SiPM packages hit, from the channel map GS::sipmChannels.
+     *
+     * @param face The face: 0 = front, 1 = back.
+     * @param x The vector of the x-positions.
+     * @param y The vector of the y-positions.
+     */
+    void FillHitPositions(G4int face, std::vector<G4double> &x, std::vector<G4double> &y);
+    /**
+     * @brief Fills the arrival time histograms of a face from the hit buffer.
+     * The hits out of the histograms are only counted in the hits per
+     * channel.
+     *
+     * @param face The face: 0 = front, 1 = back.
+     */
+    void FillTimeBins(G4int face);
+    /**
+     * @brief In light map mode, fills @ref fLightMapBuilder with the hits of
+     * the event instead of the TTree.
+     *
+     * @param event Pointer to the G4Event.
+     */
+    void FillLightMap(const G4Event *event);
 };
 
 #endif  // EVENT_HH
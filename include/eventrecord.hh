@@ -0,0 +1,93 @@
+/**
+ * @file eventrecord.hh
+ * @brief Definition of the struct @ref MyEventRecord
+ */
+#ifndef EVENTRECORD_HH
+#define EVENTRECORD_HH
+
+#include <array>
+#include <vector>
+
+#include "globals.hh"
+
+#include "ntuple.hh"
+
+/**
+ * @brief The output of an event, laid out after the schema @ref NT::columns.
+ *
+ * The scalar columns are stored by value, in the order of their type; the
+ * vector columns point to the buffers of the @ref MyEventAction. The record
+ * is handed to the output backend chosen by @ref MyRunAction (root TTree or
+ * columnar file).
+ * A record queued to the @ref MyAsyncWriter owns its vectors instead: they
+ * are moved in with MoveTo().
+ */
+struct MyEventRecord
+{
+    std::array<G4int, NT::nInts> ints{}; /**< @brief Values of the integer columns.*/
+    std::array<G4double, NT::nDoubles> doubles{}; /**< @brief Values of the double columns.*/
+    std::array<std::vector<G4int>*, NT::nIntVectors> intVectors{}; /**< @brief Buffers of the integer vector columns.*/
+    std::array<std::vector<G4double>*, NT::nDoubleVectors> doubleVectors{}; /**< @brief Buffers of the double vector columns.*/
+    std::array<std::vector<G4int>, NT::nIntVectors> intStorage; /**< @brief Integer vectors owned by the record.*/
+    std::array<std::vector<G4double>, NT::nDoubleVectors> doubleStorage; /**< @brief Double vectors owned by the record.*/
+
+    /**
+     * @brief Sets the value of an integer column, by its index in the schema
+     * (see NT::FindColumn()), checked at compile time.
+     */
+    template<size_t column>
+    inline void SetInt(G4int value)
+    {
+        static_assert(column < NT::columns.size() && NT::columns[column].type == MyColumnType::Int, "Not an integer column");
+        ints[NT::GetSlot(column)] = value;
+    }
+    /**
+     * @brief Sets the value of a double column, by its index in the schema
+     * (see NT::FindColumn()), checked at compile time.
+     */
+    template<size_t column>
+    inline void SetDouble(G4double value)
+    {
+        static_assert(column < NT::columns.size() && NT::columns[column].type == MyColumnType::Double, "Not a double column");
+        doubles[NT::GetSlot(column)] = value;
+    }
+    /** @brief Binds an integer vector column to a buffer, by its index in the schema.*/
+    template<size_t column>
+    inline void BindIntVector(std::vector<G4int> *buffer)
+    {
+        static_assert(column < NT::columns.size() && NT::columns[column].type == MyColumnType::IntVector, "Not an integer vector column");
+        intVectors[NT::GetSlot(column)] = buffer;
+    }
+    /** @brief Binds a double vector column to a buffer, by its index in the schema.*/
+    template<size_t column>
+    inline void BindDoubleVector(std::vector<G4double> *buffer)
+    {
+        static_assert(column < NT::columns.size() && NT::columns[column].type == MyColumnType::DoubleVector, "Not a double vector column");
+        doubleVectors[NT::GetSlot(column)] = buffer;
+    }
+
+    /**
+     * @brief Copies the scalars into another record and moves the vectors
+     * into its storage, without copying them: the buffers of this record
+     * get the previous (cleared) storage of the other one and its capacity.
+     *
+     * @param owner The record taking the event.
+     */
+    void MoveTo(MyEventRecord &owner)
+    {
+        owner.ints = ints;
+        owner.doubles = doubles;
+        for(size_t i = 0; i < NT::nIntVectors; i++)
+        {
+            owner.intStorage[i].swap(*intVectors[i]);
+            owner.intVectors[i] = &owner.intStorage[i];
+        }
+        for(size_t i = 0; i < NT::nDoubleVectors; i++)
+        {
+            owner.doubleStorage[i].swap(*doubleVectors[i]);
+            owner.doubleVectors[i] = &owner.doubleStorage[i];
+        }
+    }
+};
+
+#endif  // EVENTRECORD_HH
@@ -0,0 +1,61 @@
+/**
+ * @file fastlight.hh
+ * @brief Declaration of the class @ref MyFastLightModel
+ */
+#ifndef FASTLIGHT_HH
+#define FASTLIGHT_HH
+
+#include <memory>
+
+#include "G4VFastSimulationModel.hh"
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Region.hh"
+#include "G4OpticalPhoton.hh"
+
+#include "globalsettings.hh"
+#include "detector.hh"
+#include "lightmap.hh"
+
+/**
+ * @brief Concrete class of G4VFastSimulationModel, replacing the transport of
+ * the optical photons emitted inside the crystal.
+ *
+ * Every optical photon created in the envelope (the crystal) is killed at its
+ * first step: its detection channel and arrival time are sampled from a
+ * @ref MyLightMap and, if detected, the hit is stored by the
+ * @ref MySensitiveDetector exactly as a tracked photon would be.
+ * Primary optical photons (e.g. the ones fired to build the map) are always
+ * tracked.
+ */
+class MyFastLightModel : public G4VFastSimulationModel
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param name The name of the model.
+     * @param envelope The region of the crystal.
+     * @param sensDet The SD storing the hits of the event.
+     * @param lightMap The map the hits are sampled from, shared by all the threads.
+     * @param yieldScale The factor the scintillation yield has been scaled
+     * by: the detection probabilities of the map are divided by it for the
+     * scintillation photons.
+     */
+    MyFastLightModel(G4String name, G4Region *envelope, MySensitiveDetector *sensDet, std::shared_ptr<const MyLightMap> lightMap, G4double yieldScale = 1.);
+    ~MyFastLightModel() override = default; /**< @brief Destructor of the class.*/
+
+    /** @brief The model applies only to optical photons.*/
+    G4bool IsApplicable(const G4ParticleDefinition &particle) override;
+    /** @brief Triggers the model for secondary photons that have not moved yet, i.e. at their emission point.*/
+    G4bool ModelTrigger(const G4FastTrack &fastTrack) override;
+    /** @brief Samples the hit from the map and kills the photon.*/
+    void DoIt(const G4FastTrack &fastTrack, G4FastStep &fastStep) override;
+
+private:
+    MySensitiveDetector *fSensDet; /**< @brief Pointer to the SD storing the hits.*/
+    std::shared_ptr<const MyLightMap> fLightMap; /**< @brief Pointer to the light map.*/
+    G4double fYieldScale; /**< @brief Scale factor of the scintillation yield.*/
+};
+
+#endif  // FASTLIGHT_HH
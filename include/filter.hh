@@ -0,0 +1,35 @@
+/**
+ * @file filter.hh
+ * @brief Declaration of the class @ref MyNonOpticalFilter
+ */
+#ifndef FILTER_HH
+#define FILTER_HH
+
+#include "G4VSDFilter.hh"
+#include "G4Step.hh"
+#include "G4OpticalPhoton.hh"
+
+/**
+ * @brief Concrete class of G4VSDFilter rejecting the optical photons, so that
+ * the scoring SDs (@ref MyCrystalSD, @ref MyCosmicTriggerSD) never process
+ * their steps.
+ *
+ * There's no stepping action: on the optical steps in the scoring volumes
+ * the only user code left is Accept(), called by Geant4 before the SD (a
+ * virtual call and a pointer comparison per step), and none elsewhere but in
+ * the SiPM silicon.
+ */
+class MyNonOpticalFilter : public G4VSDFilter
+{
+public:
+    MyNonOpticalFilter(G4String name) : G4VSDFilter(name), fOpticalPhoton(G4OpticalPhoton::OpticalPhotonDefinition()) {} /**< @brief Constructor of the class.*/
+    ~MyNonOpticalFilter() override = default; /**< @brief Destructor of the class.*/
+
+    /** @brief Accepts every step but the ones of the optical photons.*/
+    inline G4bool Accept(const G4Step *step) const override { return step->GetTrack()->GetDefinition() != fOpticalPhoton; }
+
+private:
+    const G4ParticleDefinition *fOpticalPhoton; /**< @brief The optical photon definition, looked up once.*/
+};
+
+#endif  // FILTER_HH
@@ -5,6 +5,8 @@
 #ifndef GENERATOR_HH
 #define GENERATOR_HH
 
+#include <vector>
+
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4ParticleGun.hh"
 #include "G4SystemOfUnits.hh"
@@ -13,8 +15,12 @@
 #include "G4ParticleDefinition.hh"
 #include "Randomize.hh"
 #include "G4GenericMessenger.hh"
+#include "G4Material.hh"
+#include "G4EventManager.hh"
 
 #include "globalsettings.hh"
+#include "seeding.hh"
+#include "ludecay.hh"
 
 /**
  * @brief Mandatory user action concrete class of
@@ -30,8 +36,11 @@ public:
      * It defines the UI commands through DefineCommands() and gives
      * default values to the settable variables. Then, it instantiates the
      * G4ParticleGun object, representing the source of one primary gamma.
+     *
+     * @param theMCID The Monte Carlo ID, from which the seeds of the events
+     * are derived.
      */
-    MyPrimaryGenerator();
+    MyPrimaryGenerator(G4int theMCID);
     ~MyPrimaryGenerator() override; /**< @brief Destructor of the class.*/
 
     /**
@@ -47,28 +56,73 @@ public:
      * In calibration mode, the isotropic emission of an optical photon from a
      * monochromatic blue LED (@ref GS::energyLED) situated in one of the light
      * guide's cavities is simulated.
+     * Before all, the engine is reseeded for the event by @ref MyEventSeeder.
      *
      * @param anEvent Pointer to the G4Event.
      */
     void GeneratePrimaries(G4Event *anEvent) override;
 
     inline G4int GetModeType() const { return fModeType; };
+    inline G4bool IsTabulatedLuDecay() const { return fIsTabulatedLuDecay; } /**< @brief Tells whether the 176Lu decay products are generated directly.*/
 
 private:
     void PrimariesForStandardMode(); /**< @brief Generate primaries auxiliary function for Standard mode.*/
     void PrimariesForSpreadBeam(); /**< @brief Generate primaries auxiliary function for spread beam.*/
     void PrimariesForCircleBeam(); /**< @brief Generate primaries auxiliary function for circle beam.*/
     void PrimariesForLuDecayMode(); /**< @brief Generate primaries auxiliary function for Lu decay mode.*/
-    void PrimariesForCosmicRaysMode(); /**< @brief Generate primaries auxiliary function for Cosmic rays mode.*/
-    void PrimariesForCountingCosmicRaysMode();
+    /**
+     * @brief Generate primaries auxiliary function for Lu decay mode with the
+     * tabulated decay: the products of @ref MyLuDecaySampler are added to a
+     * vertex of their own, instead of the particle gun.
+     *
+     * @param anEvent Pointer to the G4Event.
+     */
+    void PrimariesForTabulatedLuDecayMode(G4Event *anEvent);
+    void PrimariesForCosmicRaysMode(); /**< @brief Generate primaries auxiliary function for Cosmic rays mode, only muons crossing both the cosmic rays detectors.*/
+    void PrimariesForCountingCosmicRaysMode(); /**< @brief Generate primaries auxiliary function for Cosmic rays counting mode, muons from a square around the up cosmic rays detector.*/
     void PrimariesForLEDMode(); /**< @brief Generate primaries auxiliary function for LED mode.*/
+    /**
+     * @brief Generate primaries auxiliary function for LED pulse modes.
+     *
+     * A pulse of @ref fLEDPhotons optical photons (fixed or Poisson) is
+     * emitted by the LED according to Lambert's cosine law around the
+     * normal of the LED, i.e. the direction of the axis of the light guide,
+     * with the times sampled from the time profile of the pulse. Every
+     * photon has a vertex of its own.
+     *
+     * @param anEvent Pointer to the G4Event.
+     * @param posLed The position of the LED.
+     * @return The number of photons of the pulse.
+     */
+    G4int PrimariesForLEDPulseMode(G4Event *anEvent, const G4ThreeVector &posLed);
+    /**
+     * @brief Position of an LED.
+     *
+     * @param face The face: F(ront) or B(ack).
+     * @param hole The hole: u(p), d(own), r(ight) or l(eft).
+     */
+    G4ThreeVector GetLEDPosition(const G4String &face, const G4String &hole);
+    /** @brief Sets the LEDs fired in turn in mode 42, from a list of names separated by blanks.*/
+    void SetLEDSchedule(const G4String &schedule);
+    G4double SampleLEDPulseTime(); /**< @brief Samples the emission time of a photon of a pulse from its time profile.*/
+    /**
+     * @brief Generate primaries auxiliary function for light map mode.
+     *
+     * It fires an optical photon, with energy sampled from the LYSO emission
+     * spectrum, isotropically from a random point of a voxel of the light
+     * map. The voxels are visited in turn, according to the event ID.
+     *
+     * @param eventID The ID of the event.
+     */
+    void PrimariesForLightMapMode(G4int eventID);
 
-    G4double PDF_E_CosmicRay(G4double energy);
-    G4ThreeVector ProjectOnBottomDetector(G4ThreeVector pos0, G4ThreeVector mom0);
+    G4ThreeVector SampleLuDecayPosition(); /**< @brief Samples the position of the 176Lu decay, according to the mode.*/
+    G4double SampleScintillationEnergy(); /**< @brief Samples an energy from the LYSO emission spectrum (SCINTILLATIONCOMPONENT1).*/
 
     void DefineCommands(); /**< @brief Defines new user commands for primary particle generation.*/
 
     G4ParticleGun *fParticleGun; /**< @brief Pointer to the G4ParticleGun object.*/
+    MyEventSeeder *fSeeder; /**< @brief Pointer to the seeder of the events.*/
 
     // Generic Messengers
     G4GenericMessenger *fMessenger_Mode; /**< @brief Generic messenger for mode selection.*/
@@ -83,8 +137,19 @@ private:
              fRadiusSpread, /**< @brief Radius of the area on the front face of the crystal that could be hit by primary gamma when spread is enabled.*/
              fRadiusCircle; /**< @brief Radius of the beam profile in circle type.*/
     G4ThreeVector fPosFixedDecay; /**< @brief Position of 176Lu isotope for fixed-position mode.*/
+    G4bool fIsTabulatedLuDecay; /**< @brief Flag indicating whether the 176Lu decay products are generated from tables.*/
+    MyLuDecaySampler fLuDecay; /**< @brief Tables of the 176Lu decay.*/
     G4String fChooseFrontorBack, /**< @brief Flag indicating on which face of the crystal a LED has to be switched ON.*/
              fSwitchOnLED; /**< @brief Flag indicating which LED has to be switched ON.*/
+    G4int fLEDPhotons; /**< @brief Number of photons of a LED pulse, the mean if Poisson-distributed.*/
+    G4bool fIsPoissonLED; /**< @brief Flag indicating whether the number of photons of a LED pulse is Poisson-distributed.*/
+    G4String fLEDPulseShape; /**< @brief Time profile of a LED pulse: square, gauss or exp.*/
+    G4double fLEDPulseWidth; /**< @brief Width of the time profile of a LED pulse.*/
+    std::vector<G4int> fLEDSchedule; /**< @brief LEDs fired in turn in mode 42.*/
+
+    // Cumulative LYSO emission spectrum, built at the first use
+    std::vector<G4double> fEmissionEnergies, /**< @brief Energies of the LYSO emission spectrum.*/
+                          fEmissionCDF; /**< @brief Cumulative distribution of the LYSO emission spectrum.*/
 };
 
 #endif  // GENERATOR_HH
\ No newline at end of file
@@ -5,6 +5,8 @@
 #ifndef GLOBALSETTINGS_HH
 #define GLOBALSETTINGS_HH
 
+#include <array>
+
 #include "G4SystemOfUnits.hh"
 
 /**
@@ -84,9 +86,53 @@ namespace GS
     constexpr G4double yDetector = 0*mm; /**< @brief y-position of the SiPM silicon layer referring to window center.*/
     constexpr G4double zDetector = halfZsideDetector - halfZsideWindowSiPM; /**< @brief z-position of the SiPM silicon layer referring to window center.*/
 
+        // Channel map
+    /** @brief Row, column and center (x, y) of the package of a SiPM channel. The same for both faces.*/
+    struct SiPMChannel
+    {
+        G4int row, col;
+        G4double x, y;
+    };
+
+    /** @brief Builds the channel map: channels are numbered row by row, from the top-left SiPM of @ref panelSiPMs.*/
+    constexpr std::array<SiPMChannel, nOfSiPMs> MakeSiPMChannels()
+    {
+        std::array<SiPMChannel, nOfSiPMs> channels{};
+        G4int ch = 0;
+        for(G4int row = 0; row < nRowsSiPMs; row++)
+        {
+            for(G4int col = 0; col < nColsSiPMs; col++)
+            {
+                if(!panelSiPMs[row][col])
+                    continue;
+                channels[ch] = {row, col, -halfXsidePackageSiPM*(nColsSiPMs - 1) + col*2*halfXsidePackageSiPM, halfYsidePackageSiPM*(nRowsSiPMs - 1) - row*2*halfYsidePackageSiPM};
+                ch++;
+            }
+        }
+        return channels;
+    }
+
+    /** @brief Counts the SiPMs of @ref panelSiPMs.*/
+    constexpr G4int CountSiPMs()
+    {
+        G4int n = 0;
+        for(G4int row = 0; row < nRowsSiPMs; row++)
+            for(G4int col = 0; col < nColsSiPMs; col++)
+                n += panelSiPMs[row][col];
+        return n;
+    }
+    static_assert(CountSiPMs() == nOfSiPMs, "panelSiPMs doesn't match nOfSiPMs");
+
+    constexpr std::array<SiPMChannel, nOfSiPMs> sipmChannels = MakeSiPMChannels(); /**< @brief The channel map, [ch].*/
+
+    /** @brief Copy number of the package of a SiPM: face*nOfSiPMs + ch, with face 0 = front, 1 = back.*/
+    constexpr G4int EncodeSiPMCopyNo(G4int face, G4int ch) { return face*nOfSiPMs + ch; }
+    constexpr G4int GetSiPMFace(G4int copyNo) { return copyNo/nOfSiPMs; } /**< @brief Face of a SiPM from its copy number.*/
+    constexpr G4int GetSiPMChannel(G4int copyNo) { return copyNo%nOfSiPMs; } /**< @brief Channel of a SiPM from its copy number.*/
+
     constexpr G4double meanPDE = 23.6*perCent;
-    
-    const std::vector<G4double> pdeEnergies =
+
+    constexpr std::array<G4double, 54> pdeEnergies =
     {
         2.09*eV, 2.12*eV, 2.15*eV, 2.16*eV, 2.19*eV,
         2.20*eV, 2.25*eV, 2.28*eV, 2.31*eV, 2.34*eV,
@@ -101,7 +147,7 @@ namespace GS
         3.78*eV, 3.80*eV, 3.81*eV, 3.86*eV
     };
 
-    const std::vector<G4double> pdeValues =
+    constexpr std::array<G4double, 54> pdeValues =
     {
         17.3*perCent, 18.0*perCent, 18.5*perCent, 18.9*perCent, 19.5*perCent,
         19.9*perCent, 20.8*perCent, 21.3*perCent, 21.9*perCent, 22.4*perCent,
@@ -116,6 +162,25 @@ namespace GS
         4.47*perCent, 3.81*perCent, 3.03*perCent, 2.19*perCent
     };
 
+    /** @brief Maximum of @ref pdeValues.*/
+    constexpr G4double GetPeakPDE()
+    {
+        G4double peak = 0.;
+        for(G4double pde : pdeValues)
+            if(pde > peak) peak = pde;
+        return peak;
+    }
+    /** @brief Checksum of @ref pdeEnergies, @ref pdeValues and @ref meanPDE, identifying the PDE a light map has been built with.*/
+    constexpr G4double GetPDEChecksum()
+    {
+        G4double checksum = meanPDE;
+        for(size_t i = 0; i < pdeValues.size(); i++)
+            checksum += (i + 1)*pdeEnergies[i]/eV + (i + 1)*(i + 1)*pdeValues[i];
+        return checksum;
+    }
+
+    constexpr G4double peakPDE = GetPeakPDE(); /**< @brief Maximum of @ref pdeValues. It is the scale factor of the scintillation yield when the PDE pre-scaling is on.*/
+
 
     // PCB
     constexpr G4double radiusPCB = radiusScintillator + 10.*mm; /**< @brief Radius of the Printed Circuit Board (PCB). */
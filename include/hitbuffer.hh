@@ -0,0 +1,55 @@
+/**
+ * @file hitbuffer.hh
+ * @brief Declaration of the class @ref MyHitBuffer
+ */
+#ifndef HITBUFFER_HH
+#define HITBUFFER_HH
+
+#include <vector>
+
+#include "globals.hh"
+
+#include "globalsettings.hh"
+
+/**
+ * @brief Structure-of-arrays container of the hits of an event, i.e. of the
+ * optical photons detected by the SiPMs.
+ *
+ * A hit is the triplet (face, channel, time): the hits of each face are
+ * stored in parallel vectors, which are bound to the TTree columns by
+ * @ref MyRunAction and read in place at the end of the event.
+ * There is one buffer per thread, owned by @ref MyEventAction: Clear() only
+ * resets the sizes, so the capacity reached in the heaviest events is kept
+ * and no allocation happens on the hot path.
+ */
+class MyHitBuffer
+{
+public:
+    MyHitBuffer(); /**< @brief Constructor of the class.*/
+    ~MyHitBuffer() = default; /**< @brief Destructor of the class.*/
+
+    void Clear(); /**< @brief Removes all the hits, keeping the capacity.*/
+
+    /**
+     * @brief Appends a hit.
+     *
+     * @param face The face of the SiPM: 0 = front, 1 = back.
+     * @param ch The channel of the SiPM.
+     * @param time The time of detection.
+     */
+    inline void Add(G4int face, G4int ch, G4double time)
+    {
+        fTime[face].push_back(time);
+        fChannel[face].push_back(ch);
+        fHitsPerChannel[face][ch]++;
+    }
+
+    inline G4int GetNHits(G4int face) const { return fTime[face].size(); } /**< @brief Get the number of hits on a face.*/
+    inline G4int GetNHits() const { return fTime[0].size() + fTime[1].size(); } /**< @brief Get the total number of hits.*/
+
+    std::vector<G4double> fTime[2]; /**< @brief Times of detection, [face][hit].*/
+    std::vector<G4int>    fChannel[2], /**< @brief Channels of detection, [face][hit].*/
+                          fHitsPerChannel[2]; /**< @brief Number of hits of every channel, [face][ch].*/
+};
+
+#endif  // HITBUFFER_HH
@@ -0,0 +1,93 @@
+/**
+ * @file ledstats.hh
+ * @brief Declaration of the class @ref MyLEDStats
+ */
+#ifndef LEDSTATS_HH
+#define LEDSTATS_HH
+
+#include <vector>
+#include <cstdint>
+
+#include "G4VAccumulable.hh"
+
+#include "globalsettings.hh"
+
+/**
+ * @brief Thread-local accumulator of the response of the channels to the
+ * LEDs of the calibration system, per LED.
+ *
+ * The 8 LEDs are numbered face*4 + hole, with the holes in the order up,
+ * down, right, left, and named after the commands of the LED-system, e.g.
+ * "Fu" or "Bl". For every LED the pulses, the photons emitted and the sum and
+ * the sum of the squares of the photons detected by every channel are
+ * accumulated, so a single run firing all the LEDs (mode 42) gives the
+ * mean and the RMS per LED and per channel.
+ *
+ * It is registered in the G4AccumulableManager by @ref MyRunAction: the
+ * workers' sums are merged into the master's ones at the end of the run,
+ * then the master writes the table with Write(). The tables of the shards
+ * are merged by @ref MyShardDriver with Read(). The sums are allocated at
+ * the first Fill(), so the other modes don't pay for them.
+ */
+class MyLEDStats : public G4VAccumulable
+{
+public:
+    MyLEDStats() : G4VAccumulable("LEDStats") {} /**< @brief Constructor of the class.*/
+    ~MyLEDStats() override = default; /**< @brief Destructor of the class.*/
+
+    void Merge(const G4VAccumulable &other) override; /**< @brief Adds the sums of a worker.*/
+    void Reset() override; /**< @brief Releases the sums.*/
+
+    /**
+     * @brief Accumulates a pulse.
+     *
+     * @param led The LED fired.
+     * @param nPhotons The number of photons emitted.
+     * @param hitsPerChannel The photons detected by every channel, [face][ch].
+     */
+    void Fill(G4int led, G4int nPhotons, const std::vector<G4int> hitsPerChannel[2]);
+
+    /**
+     * @brief Writes the table of the LEDs fired: pulses, photons emitted, sum
+     * and sum of the squares and mean and RMS of the photons detected per
+     * pulse by every channel. A line per LED is printed too.
+     *
+     * @param fileName The name of the text file.
+     */
+    void Write(const G4String &fileName) const;
+    /**
+     * @brief Adds the sums of a table written by Write(), e.g. to merge the
+     * tables of the shards.
+     *
+     * @param fileName The name of the text file.
+     * @return false if the table can't be read.
+     */
+    G4bool Read(const G4String &fileName);
+
+    inline G4bool HasEntries() const { return !fNPulses.empty(); } /**< @brief Tells whether something has been filled in this run.*/
+
+    /** @brief Name of an LED, e.g. "Fu".*/
+    static G4String GetLEDName(G4int led);
+    /**
+     * @brief Finds an LED by its face and hole.
+     *
+     * @param face The face: F(ront) or B(ack).
+     * @param hole The hole: u(p), d(own), r(ight) or l(eft).
+     * @return The number of the LED, -1 if not valid.
+     */
+    static G4int FindLED(const G4String &face, const G4String &hole);
+
+    static constexpr G4int nLEDs = 8; /**< @brief Number of LEDs, 4 per face.*/
+
+private:
+    void Book(); /**< @brief Allocates the sums.*/
+
+    static constexpr G4int nChannels = 2*GS::nOfSiPMs; /**< @brief Number of channels of both faces.*/
+
+    std::vector<std::uint64_t> fNPulses, /**< @brief Number of pulses, [led].*/
+                               fNPhotons; /**< @brief Number of photons emitted, [led].*/
+    std::vector<G4double> fSum, /**< @brief Sum of the photons detected, [led][face*GS::nOfSiPMs + ch].*/
+                          fSum2; /**< @brief Sum of the squares of the photons detected, [led][face*GS::nOfSiPMs + ch].*/
+};
+
+#endif  // LEDSTATS_HH
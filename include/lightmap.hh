@@ -0,0 +1,155 @@
+/**
+ * @file lightmap.hh
+ * @brief Declaration of the classes @ref MyLightMapBinning and
+ * @ref MyLightMap, and of the binary format of the light map files
+ */
+#ifndef LIGHTMAP_HH
+#define LIGHTMAP_HH
+
+#include <cstdint>
+#include <memory>
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "globalsettings.hh"
+
+/**
+ * @brief Binning of a light map: the crystal is divided in nR x nPhi x nZ
+ * voxels (radial bins are equal-area, i.e. uniform in r^2) and the arrival
+ * times in nT bins over [0, tMax].
+ */
+struct MyLightMapBinning
+{
+    G4int nR = 5, /**< @brief Number of radial (equal-area) bins.*/
+          nPhi = 12, /**< @brief Number of azimuthal bins.*/
+          nZ = 20, /**< @brief Number of bins along the crystal axis.*/
+          nT = 32; /**< @brief Number of bins of the arrival time distributions.*/
+    G4double radius = GS::radiusScintillator, /**< @brief Radius of the mapped crystal.*/
+             halfHeight = GS::halfheightScintillator, /**< @brief Half height of the mapped crystal.*/
+             tMax = 32.*ns; /**< @brief Upper edge of the arrival time distributions.*/
+
+    inline G4int GetNVoxels() const { return nR*nPhi*nZ; } /**< @brief Get the total number of voxels.*/
+
+    /**
+     * @brief Returns the index of the voxel containing a point.
+     *
+     * @param localPos The point, in the local frame of the crystal.
+     * @return The voxel index, or -1 if the point is outside the crystal.
+     */
+    G4int GetVoxel(const G4ThreeVector &localPos) const;
+    /**
+     * @brief Samples a point uniformly inside a voxel.
+     *
+     * @param voxel The voxel index.
+     * @return The point, in the local frame of the crystal.
+     */
+    G4ThreeVector SampleInVoxel(G4int voxel) const;
+    /** @brief Returns the bin of an arrival time (times beyond tMax go in the last bin).*/
+    G4int GetTimeBin(G4double time) const;
+
+    G4bool operator==(const MyLightMapBinning &right) const; /**< @brief Equality operator.*/
+};
+
+/**
+ * @brief The construction and detection settings a light map has been built
+ * with. A map can only be used with the same geometry and SiPMs.
+ */
+struct MyLightMapGeometry
+{
+    std::int32_t isGrease, /**< @brief Optical grease present.*/
+                 isOpticalGreaseSurface, /**< @brief Optical surface of the grease present.*/
+                 isLightGuide, /**< @brief Light guides present.*/
+                 lightGuideMaterial, /**< @brief Material of the light guides.*/
+                 isPCB, /**< @brief PCBs present.*/
+                 isEndcap, /**< @brief Endcaps present.*/
+                 efficiencySetting; /**< @brief Type of PDEs of the SiPMs, see @ref MySensitiveDetector.*/
+    double       pdeChecksum, /**< @brief Checksum of the PDE of the SiPMs, see GS::GetPDEChecksum().*/
+                 activeArea; /**< @brief Active area of a SiPM, in mm2.*/
+
+    G4bool operator==(const MyLightMapGeometry &right) const; /**< @brief Equality operator.*/
+};
+
+/**
+ * @brief Header of a light map file.
+ *
+ * The file is laid out so that it can be memory-mapped and used in place:
+ * the header is followed (at 64-byte aligned offsets) by the two float tables
+ * described in @ref MyLightMap.
+ */
+struct MyLightMapHeader
+{
+    char          magic[8]; /**< @brief Always "LYSOLMAP".*/
+    std::uint32_t version, /**< @brief Version of the format, @ref MyLightMap::formatVersion.*/
+                  headerSize; /**< @brief sizeof(MyLightMapHeader), as a sanity check.*/
+    std::int32_t  nR, nPhi, nZ, nT, /**< @brief Binning, see @ref MyLightMapBinning.*/
+                  nChannels; /**< @brief Number of readout channels.*/
+    MyLightMapGeometry geometry; /**< @brief Construction settings of the map.*/
+    double        radius, halfHeight, tMax; /**< @brief Binning, see @ref MyLightMapBinning.*/
+    std::uint64_t nEmitted, /**< @brief Number of photons the map has been built with.*/
+                  cumProbOffset, /**< @brief Byte offset of the cumulative detection probabilities.*/
+                  timeCDFOffset, /**< @brief Byte offset of the cumulative arrival time distributions.*/
+                  fileSize; /**< @brief Total size of the file.*/
+};
+
+/**
+ * @brief Voxelized detection map of the crystal, used by
+ * @ref MyFastLightModel in place of the optical photon transport.
+ *
+ * For every voxel and for every readout channel k = face*GS::nOfSiPMs + ch
+ * (face 0 = front, 1 = back) the map stores:
+ * - the cumulative probability that an optical photon emitted in the voxel is
+ * detected by a channel <= k (the last entry is the total detection
+ * probability);
+ * - the cumulative distribution of the arrival time, relative to the emission.
+ *
+ * The file is memory-mapped read-only and shared by all the threads: use
+ * Open() to get it.
+ */
+class MyLightMap
+{
+public:
+    ~MyLightMap(); /**< @brief Destructor of the class. It unmaps the file.*/
+
+    /**
+     * @brief Returns the map stored in a file, mapping it the first time it is
+     * requested. It is thread-safe and all the callers share the same copy.
+     *
+     * A fatal G4Exception is raised if the file is not a valid map or if it
+     * has been built with a different geometry.
+     *
+     * @param fileName The name of the map file.
+     * @param geometry The construction settings of the current geometry.
+     */
+    static std::shared_ptr<const MyLightMap> Open(const G4String &fileName, const MyLightMapGeometry &geometry);
+
+    /**
+     * @brief Samples the fate of one optical photon emitted in a voxel.
+     *
+     * @param voxel The voxel of the emission point.
+     * @param scale Scale factor dividing the detection probabilities.
+     * @param channel Output: the channel k = face*GS::nOfSiPMs + ch hit.
+     * @param time Output: the arrival time relative to the emission.
+     * @return true if the photon is detected.
+     */
+    G4bool SampleHit(G4int voxel, G4double scale, G4int &channel, G4double &time) const;
+
+    inline const MyLightMapBinning &GetBinning() const { return fBinning; } /**< @brief Get the binning of the map.*/
+
+    static constexpr G4int nChannels = 2*GS::nOfSiPMs; /**< @brief Number of readout channels (front and back).*/
+    static constexpr std::uint32_t formatVersion = 2; /**< @brief Current version of the file format.*/
+
+private:
+    MyLightMap() = default; /**< @brief Constructor of the class, see Open().*/
+    G4bool Map(const G4String &fileName); /**< @brief Maps the file and validates its header.*/
+
+    MyLightMapBinning fBinning; /**< @brief Binning of the map.*/
+    MyLightMapGeometry fGeometry; /**< @brief Construction settings of the map.*/
+    void *fData = nullptr; /**< @brief Start of the mapped file.*/
+    size_t fSize = 0; /**< @brief Size of the mapped file.*/
+    const float *fCumProb = nullptr; /**< @brief Cumulative detection probabilities, [voxel][channel].*/
+    const float *fTimeCDF = nullptr; /**< @brief Cumulative arrival time distributions, [voxel][channel][bin].*/
+};
+
+#endif  // LIGHTMAP_HH
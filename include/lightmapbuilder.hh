@@ -0,0 +1,99 @@
+/**
+ * @file lightmapbuilder.hh
+ * @brief Declaration of the class @ref MyLightMapBuilder
+ */
+#ifndef LIGHTMAPBUILDER_HH
+#define LIGHTMAPBUILDER_HH
+
+#include <vector>
+#include <cstdint>
+
+#include "G4VAccumulable.hh"
+#include "G4GenericMessenger.hh"
+
+#include "lightmap.hh"
+
+/**
+ * @brief Thread-local accumulator of the detection statistics used to build a
+ * @ref MyLightMap in the light map run mode (/MC_LYSO/Mode 50).
+ *
+ * It is registered in the G4AccumulableManager by @ref MyRunAction: the
+ * workers' counters are merged into the master's one at the end of the run,
+ * then the master writes the normalized map with Write(). The shards and the
+ * checkpointed blocks write their raw counters with WriteCounts() instead,
+ * and @ref MyShardDriver sums them up with ReadCounts() before normalizing.
+ * The counters are allocated at the first Fill(), so the other modes don't
+ * pay for them.
+ */
+class MyLightMapBuilder : public G4VAccumulable
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * It defines the UI commands for the binning and the output file of the
+     * map.
+     */
+    MyLightMapBuilder();
+    ~MyLightMapBuilder() override; /**< @brief Destructor of the class.*/
+
+    void Merge(const G4VAccumulable &other) override; /**< @brief Adds the counters of a worker.*/
+    void Reset() override; /**< @brief Releases the counters.*/
+
+    /**
+     * @brief Counts an optical photon emitted in a voxel.
+     *
+     * @param voxel The voxel of the emission point.
+     */
+    void CountEmission(G4int voxel);
+    /**
+     * @brief Counts a detected optical photon.
+     *
+     * @param voxel The voxel of the emission point.
+     * @param channel The channel k = face*GS::nOfSiPMs + ch hit.
+     * @param time The arrival time relative to the emission.
+     */
+    void Fill(G4int voxel, G4int channel, G4double time);
+
+    /**
+     * @brief Normalizes the counters and writes the map file.
+     *
+     * @param geometry The construction settings of the map.
+     */
+    void Write(const MyLightMapGeometry &geometry) const;
+    /**
+     * @brief Writes the raw counters, with the binning, the geometry and the
+     * name of the map file, to be merged later by ReadCounts().
+     *
+     * @param fileName The name of the counters file.
+     * @param geometry The construction settings of the map.
+     */
+    void WriteCounts(const G4String &fileName, const MyLightMapGeometry &geometry) const;
+    /**
+     * @brief Adds the counters of a file written by WriteCounts(). The
+     * binning, the geometry and the map file must be the same as the ones of
+     * the files read before.
+     *
+     * @param fileName The name of the counters file.
+     * @param geometry The construction settings of the map: set by the first
+     * file, checked against the following ones.
+     * @return false if the file can't be read or doesn't match.
+     */
+    G4bool ReadCounts(const G4String &fileName, MyLightMapGeometry &geometry);
+
+    inline G4bool HasEntries() const { return !fEmitted.empty(); } /**< @brief Tells whether something has been filled in this run.*/
+    inline const MyLightMapBinning &GetBinning() const { return fBinning; } /**< @brief Get the binning of the map.*/
+
+private:
+    void Book(); /**< @brief Allocates the counters according to @ref fBinning.*/
+
+    MyLightMapBinning fBinning; /**< @brief Binning of the map.*/
+    MyLightMapBinning fBookedBinning; /**< @brief Binning the counters have been allocated with.*/
+    G4String fFileName; /**< @brief Name of the output map file.*/
+    std::vector<std::uint64_t> fEmitted; /**< @brief Number of emitted photons, [voxel].*/
+    std::vector<std::uint32_t> fCounts; /**< @brief Arrival time histograms, [voxel][channel][bin].*/
+
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
+};
+
+#endif  // LIGHTMAPBUILDER_HH
@@ -0,0 +1,62 @@
+/**
+ * @file ludecay.hh
+ * @brief Declaration of the class @ref MyLuDecaySampler
+ */
+#ifndef LUDECAY_HH
+#define LUDECAY_HH
+
+#include "globals.hh"
+#include "G4PrimaryVertex.hh"
+
+#include "aliastable.hh"
+
+/**
+ * @brief Tabulated 176Lu decay: the products are generated directly as
+ * primaries at t = 0, without tracking the ion through
+ * G4RadioactiveDecay.
+ *
+ * Only the main branch is simulated (99.7%). In it, the beta- decay feeds
+ * the 596.8 keV level of 176Hf, which de-excites through the 306.8, 201.8
+ * and 88.3 keV cascade. The electron energy is sampled from the allowed
+ * spectrum p W (W0 - W)^2 F(Z, W), with the non-relativistic Fermi function
+ * of the daughter. The spectrum is tabulated once in @ref nBins bins and
+ * sampled with a @ref MyAliasTable, uniformly within the bin.
+ * A transition of the cascade emits a gamma with its measured intensity;
+ * otherwise it is converted. Every conversion is taken from the K shell:
+ * the conversion electron, a Kalpha X-ray and an Auger electron with the
+ * rest of the binding energy. All the products are isotropic and
+ * uncorrelated.
+ */
+class MyLuDecaySampler
+{
+public:
+    MyLuDecaySampler(); /**< @brief Constructor of the class, it tabulates the beta spectrum.*/
+
+    /**
+     * @brief Adds the products of a decay to a vertex.
+     *
+     * The electron is the first primary of the vertex.
+     *
+     * @param vertex The decay vertex.
+     */
+    void GenerateDecay(G4PrimaryVertex *vertex) const;
+    /** @brief Samples the kinetic energy of the beta electron.*/
+    G4double SampleBetaEnergy() const;
+
+    static constexpr G4int nBins = 1024; /**< @brief Number of bins of the tabulated beta spectrum.*/
+
+private:
+    /**
+     * @brief Adds a particle, emitted isotropically, to a vertex.
+     *
+     * @param vertex The decay vertex.
+     * @param isGamma Whether the particle is a photon (or an electron).
+     * @param energy The kinetic energy.
+     */
+    void AddIsotropic(G4PrimaryVertex *vertex, G4bool isGamma, G4double energy) const;
+
+    G4double fBinWidth; /**< @brief Width of the bins of the beta spectrum.*/
+    MyAliasTable fBetaTable; /**< @brief Alias table of the beta spectrum.*/
+};
+
+#endif  // LUDECAY_HH
@@ -0,0 +1,251 @@
+/**
+ * @file ntuple.hh
+ * @brief Definition of the columns of the output, of the output schemas and
+ * declaration of the function @ref BookNtuple()
+ */
+#ifndef NTUPLE_HH
+#define NTUPLE_HH
+
+#include <array>
+#include <vector>
+
+#include "G4AnalysisManager.hh"
+
+#include "globalsettings.hh"
+
+/**
+ * @brief Types of the columns of the output TTree. The event is filled with
+ * the first four, the reduced-precision ones are only used to store the
+ * columns in an output schema.
+ */
+enum class MyColumnType { Int, Double, IntVector, DoubleVector, Float, FloatVector, ByteVector };
+
+/** @brief A column of the output TTree: name and type.*/
+struct MyNtupleColumn
+{
+    const char *name; /**< @brief Name of the branch.*/
+    MyColumnType type; /**< @brief Type of the branch.*/
+};
+
+/**
+ * @brief Encapsulates the schema of the output TTree, shared by the
+ * @ref MyRunAction writing it and the merge of the shards reading it back
+ * (see @ref MyShardDriver).
+ */
+namespace NT
+{
+    constexpr const char *ntupleName = "lyso"; /**< @brief Name of the TTree.*/
+    constexpr const char *ntupleTitle = "Primary Gamma, energy deposition inside the crystal and detectors output"; /**< @brief Title of the TTree.*/
+
+    /**
+     * @brief The columns, in order: their index is the one used to fill the
+     * scalar columns.
+     */
+    constexpr std::array<MyNtupleColumn, 48> columns = {{
+        // Data of primary gamma
+        {"Event", MyColumnType::Int}, // entry 0
+        {"PID_gun", MyColumnType::Int},
+        {"E_gun", MyColumnType::Double},
+        {"X_gun", MyColumnType::Double},
+        {"Y_gun", MyColumnType::Double},
+        {"Z_gun", MyColumnType::Double}, // entry 5
+        {"MomX_gun", MyColumnType::Double},
+        {"MomY_gun", MyColumnType::Double},
+        {"MomZ_gun", MyColumnType::Double},
+        {"ToA", MyColumnType::Double},
+        {"XoA", MyColumnType::Double}, // entry 10
+        {"YoA", MyColumnType::Double},
+        {"ZoA", MyColumnType::Double},
+        {"ToFI", MyColumnType::Double},
+        {"XoFI", MyColumnType::Double},
+        {"YoFI", MyColumnType::Double}, // entry 15
+        {"ZoFI", MyColumnType::Double},
+        // Data of energy deposition inside the crystal
+        {"Edep", MyColumnType::Double},
+        {"MaxEdep", MyColumnType::Double},
+        {"MaxEdepPosX", MyColumnType::Double},
+        {"MaxEdepPosY", MyColumnType::Double}, // entry 20
+        {"MaxEdepPosZ", MyColumnType::Double},
+        // Data of detectors
+        {"NHits_F", MyColumnType::Int},
+        {"NHits_B", MyColumnType::Int},
+        {"NHits_Tot", MyColumnType::Int},
+        {"NHits_F_Ch", MyColumnType::IntVector}, // entry 25
+        {"T_F", MyColumnType::DoubleVector},
+        {"X_F", MyColumnType::DoubleVector},
+        {"Y_F", MyColumnType::DoubleVector},
+        {"Ch_F", MyColumnType::IntVector},
+        {"NHits_B_Ch", MyColumnType::IntVector}, // entry 30
+        {"T_B", MyColumnType::DoubleVector},
+        {"X_B", MyColumnType::DoubleVector},
+        {"Y_B", MyColumnType::DoubleVector},
+        {"Ch_B", MyColumnType::IntVector},
+        // Photons dropped by the readout window
+        {"NKilled_Window", MyColumnType::Int}, // entry 35
+        {"NLateHits", MyColumnType::Int},
+        // Seeds of the event, to replay it
+        {"Seed0", MyColumnType::Int},
+        {"Seed1", MyColumnType::Int},
+        // Digitized SiPMs (see MyDigitizer), [ch] and [ch*nSamples + sample]
+        {"Charge_F", MyColumnType::DoubleVector},
+        {"TLead_F", MyColumnType::DoubleVector}, // entry 40
+        {"Charge_B", MyColumnType::DoubleVector},
+        {"TLead_B", MyColumnType::DoubleVector},
+        {"Trace_F", MyColumnType::DoubleVector},
+        {"Trace_B", MyColumnType::DoubleVector},
+        // Arrival time histograms, [ch*nBins + bin]
+        {"TBins_F", MyColumnType::IntVector}, // entry 45
+        {"TBins_B", MyColumnType::IntVector},
+        // LED fired in the event (LED modes, see MyLEDStats), -1 otherwise
+        {"LED", MyColumnType::Int}
+    }};
+    static_assert(columns.back().name != nullptr, "NT::columns is declared with more entries than it has");
+
+    /** @brief Counts the columns of a type.*/
+    constexpr size_t CountColumns(MyColumnType type)
+    {
+        size_t n = 0;
+        for(const auto &column : columns)
+            if(column.type == type) n++;
+        return n;
+    }
+
+    constexpr size_t nInts = CountColumns(MyColumnType::Int); /**< @brief Number of integer columns.*/
+    constexpr size_t nDoubles = CountColumns(MyColumnType::Double); /**< @brief Number of double columns.*/
+    constexpr size_t nIntVectors = CountColumns(MyColumnType::IntVector); /**< @brief Number of integer vector columns.*/
+    constexpr size_t nDoubleVectors = CountColumns(MyColumnType::DoubleVector); /**< @brief Number of double vector columns.*/
+
+    /** @brief Compares two names at compile time.*/
+    constexpr G4bool IsSameName(const char *a, const char *b)
+    {
+        while(*a && *a == *b)
+        {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    /**
+     * @brief Index of a column by its name, to address the columns by name
+     * at compile time, e.g. NT::FindColumn("Seed0").
+     *
+     * @return The index in @ref columns, columns.size() if missing.
+     */
+    constexpr size_t FindColumn(const char *name)
+    {
+        for(size_t k = 0; k < columns.size(); k++)
+            if(IsSameName(columns[k].name, name)) return k;
+        return columns.size();
+    }
+
+    /**
+     * @brief Position of a column among the ones of its type, e.g. in the
+     * arrays of a @ref MyEventRecord.
+     */
+    constexpr size_t GetSlot(size_t column)
+    {
+        size_t slot = 0;
+        for(size_t k = 0; k < column; k++)
+            if(columns[k].type == columns[column].type) slot++;
+        return slot;
+    }
+}
+
+/** @brief A column of an output schema: a column of @ref NT::columns and the type it's stored with.*/
+struct MyOutputColumn
+{
+    size_t column; /**< @brief Index of the column in NT::columns.*/
+    size_t slot; /**< @brief Position of the column among the ones of its type in NT::columns.*/
+    MyColumnType type; /**< @brief Type of the stored values.*/
+
+    inline const char *GetName() const { return NT::columns[column].name; } /**< @brief Get the name of the column.*/
+};
+
+/**
+ * @brief A selection of the columns of @ref NT::columns and of their
+ * precision, i.e. the layout of the output files.
+ *
+ * - *full*: all the columns, as filled (the default);
+ * - *compact*: all the columns, with floats instead of doubles and 8-bit
+ * channels;
+ * - *led*: as compact, without the primary gamma and the crystal columns,
+ * meaningless in the LED modes (40, 41 and 42).
+ *
+ * The compact schemas can also drop the columns derivable from the others
+ * (their name gets a "-min" suffix): the positions of the SiPMs hit, given
+ * by the channels, the hits per channel and the total number of hits.
+ * Every schema has a variant for each @ref MySiPMOutput but the photon
+ * lists: with the arrival time histograms (suffix "-binned") the times, the
+ * channels and the positions of the photons are replaced by the histograms;
+ * with the @ref MyDigitizer (suffix "-digi", or "-traces" with the
+ * waveforms) the photon lists and the hits per channel are replaced by the
+ * charges and the leading-edge times of the channels; with the counts
+ * (suffix "-counts") only the hits per channel are kept, e.g. for the LED
+ * pulses of modes 41 and 42.
+ * The name and the version of the schema are written in the files.
+ */
+/** @brief What the output holds about the SiPMs.*/
+enum class MySiPMOutput
+{
+    Photons, /**< @brief The time and the channel of every photon detected.*/
+    Binned, /**< @brief The arrival time histogram of every channel.*/
+    Digitized, /**< @brief The charge and the leading-edge time of every channel.*/
+    Traces, /**< @brief As Digitized, with the waveforms.*/
+    Counts /**< @brief The number of photons detected by every channel.*/
+};
+
+struct MyOutputSchema
+{
+    G4String name; /**< @brief Name of the schema.*/
+    std::vector<MyOutputColumn> columns; /**< @brief The stored columns, in order.*/
+
+    /** @brief Title of the TTree, with the name and the version of the schema.*/
+    G4String GetTitle() const;
+};
+
+namespace NT
+{
+    constexpr G4int schemaVersion = 2; /**< @brief Version of the output schemas, increased whenever a schema changes.*/
+
+    static_assert(GS::nOfSiPMs <= 256, "The channels of the compact schemas are 8-bit");
+
+    /** @brief All the output schemas, built at the first call.*/
+    const std::vector<MyOutputSchema> &GetSchemas();
+    /**
+     * @brief Finds an output schema.
+     *
+     * @param name The name of the schema: full, compact or led.
+     * @param dropDerived Whether to drop the derivable columns (not for the
+     * full schema).
+     * @param sipmOutput What the output holds about the SiPMs.
+     * @return The index of the schema in GetSchemas(), -1 if missing.
+     */
+    G4int FindSchema(const G4String &name, G4bool dropDerived = false, MySiPMOutput sipmOutput = MySiPMOutput::Photons);
+}
+
+/**
+ * @brief Buffers the vector columns of the TTree are bound to, by their
+ * position among the columns of their type in @ref NT::columns.
+ *
+ * The reduced-precision vectors are bound to the float buffers, which must be
+ * filled from the double ones before every row. 8-bit vectors are stored as
+ * integers in the TTree.
+ */
+struct MyNtupleBuffers
+{
+    std::array<std::vector<G4int>*, NT::nIntVectors> intVectors{}; /**< @brief Buffers of the integer vector columns.*/
+    std::array<std::vector<G4double>*, NT::nDoubleVectors> doubleVectors{}; /**< @brief Buffers of the double vector columns.*/
+    std::array<std::vector<G4float>*, NT::nDoubleVectors> floatVectors{}; /**< @brief Buffers of the double vector columns stored as floats.*/
+};
+
+/**
+ * @brief Creates an output TTree with the columns of an output schema.
+ *
+ * @param schema The output schema.
+ * @param buffers The buffers the vector columns are bound to.
+ * @return The ID of the ntuple.
+ */
+G4int BookNtuple(const MyOutputSchema &schema, const MyNtupleBuffers &buffers);
+
+#endif  // NTUPLE_HH
@@ -0,0 +1,113 @@
+/**
+ * @file perfcounters.hh
+ * @brief Declaration of the class @ref MyPerfCounters
+ */
+#ifndef PERFCOUNTERS_HH
+#define PERFCOUNTERS_HH
+
+#include <chrono>
+#include <cstdint>
+
+#include "G4VAccumulable.hh"
+
+/** @brief Adds the time elapsed from its construction to its destruction to a counter, in s.*/
+class MyScopeTimer
+{
+public:
+    /**
+     * @brief Constructor of the class, it starts the timer.
+     *
+     * @param time The counter.
+     */
+    explicit MyScopeTimer(G4double &time) : fTime(time), fStart(std::chrono::steady_clock::now()) {}
+    /**
+     * @brief Constructor of the class, for a timer already started.
+     *
+     * @param time The counter.
+     * @param start The start of the timer.
+     */
+    MyScopeTimer(G4double &time, std::chrono::steady_clock::time_point start) : fTime(time), fStart(start) {}
+    ~MyScopeTimer() { fTime += std::chrono::duration<G4double>(std::chrono::steady_clock::now() - fStart).count(); } /**< @brief Destructor of the class, it stops the timer.*/
+
+private:
+    G4double &fTime; /**< @brief The counter.*/
+    std::chrono::steady_clock::time_point fStart; /**< @brief Start of the timer.*/
+};
+
+
+
+
+/**
+ * @brief Thread-local counters of the work done in a run: events, tracks of
+ * optical photons, steps and hits, for the throughputs reported by
+ * @ref MyBenchmark. They also time the thread: events (busy time), output
+ * calls (rows of the TTree, chunks of the columnar files), writes to the
+ * Geant4 output streams and end of the run, where the threads wait for
+ * the shared resources.
+ *
+ * They are registered in the G4AccumulableManager by @ref MyRunAction, so
+ * the master gets the totals of the workers at the end of the run, with the
+ * range of the busy time over the threads. Owned by @ref MyEventAction and
+ * filled by it, by @ref MyTrackingAction and by @ref MyRunAction.
+ */
+class MyPerfCounters : public G4VAccumulable
+{
+public:
+    MyPerfCounters() : G4VAccumulable("PerfCounters") {} /**< @brief Constructor of the class.*/
+    ~MyPerfCounters() override = default; /**< @brief Destructor of the class.*/
+
+    void Merge(const G4VAccumulable &other) override; /**< @brief Adds the counters of a worker, one thread.*/
+    void Reset() override; /**< @brief Zeroes the counters.*/
+
+    /**
+     * @brief Counts a track at its end.
+     *
+     * @param nSteps The number of steps of the track.
+     * @param isOpticalPhoton Whether it's an optical photon.
+     */
+    inline void CountTrack(G4int nSteps, G4bool isOpticalPhoton)
+    {
+        fNSteps += nSteps;
+        if(isOpticalPhoton)
+            fNOpticalPhotons++;
+    }
+    /**
+     * @brief Counts an event at its end.
+     *
+     * @param nHits The number of hits of the event.
+     */
+    inline void CountEvent(G4int nHits)
+    {
+        fNEvents++;
+        fNHits += nHits;
+    }
+
+    /** @brief Get the number of threads merged, 1 if none (sequential mode).*/
+    inline G4int GetNThreads() const { return fNThreads > 0 ? fNThreads : 1; }
+    /** @brief Get the shortest busy time of the threads.*/
+    inline G4double GetMinBusyTime() const { return fNThreads > 0 ? fMinBusyTime : fBusyTime; }
+    /** @brief Get the longest busy time of the threads.*/
+    inline G4double GetMaxBusyTime() const { return fNThreads > 0 ? fMaxBusyTime : fBusyTime; }
+
+    inline std::uint64_t GetNEvents() const { return fNEvents; } /**< @brief Get the number of events processed.*/
+    inline std::uint64_t GetNOpticalPhotons() const { return fNOpticalPhotons; } /**< @brief Get the number of optical photons tracked.*/
+    inline std::uint64_t GetNSteps() const { return fNSteps; } /**< @brief Get the number of steps of all the tracks.*/
+    inline std::uint64_t GetNHits() const { return fNHits; } /**< @brief Get the number of hits.*/
+
+    // Timers of the thread, the sums over the threads once merged
+    G4double fBusyTime = 0., /**< @brief Time spent in the events, in s.*/
+             fOutputTime = 0., /**< @brief Time spent in the output calls, locks included, in s.*/
+             fStreamTime = 0., /**< @brief Time spent writing to G4cout and G4cerr, in s.*/
+             fEndOfRunTime = 0.; /**< @brief Duration of the end of the run, in s: the longest of the threads once merged.*/
+
+private:
+    std::uint64_t fNEvents = 0, /**< @brief Number of events processed.*/
+                  fNOpticalPhotons = 0, /**< @brief Number of optical photons tracked.*/
+                  fNSteps = 0, /**< @brief Number of steps of all the tracks.*/
+                  fNHits = 0; /**< @brief Number of hits.*/
+    G4int fNThreads = 0; /**< @brief Number of threads merged.*/
+    G4double fMinBusyTime = 0., /**< @brief Shortest busy time of the threads merged.*/
+             fMaxBusyTime = 0.; /**< @brief Longest busy time of the threads merged.*/
+};
+
+#endif  // PERFCOUNTERS_HH
@@ -10,17 +10,52 @@
 #include "G4OpticalPhysics.hh"
 #include "G4DecayPhysics.hh"
 #include "G4RadioactiveDecayPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4UserSpecialCuts.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4ProcessManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ApplicationState.hh"
+#include "G4RunManager.hh"
+
+#include "construction.hh"
 
 /**
  * @brief Mandatory user initialization concrete class of G4VModularPhysicsList.
  * It defines physical processes and particles to be considered in the
  * simulation.
+ *
+ * The radioactive decay can be left out before the initialization, when the
+ * 176Lu decays are generated from the tables of @ref MyLuDecaySampler, so
+ * that no decay table is loaded.
  */
 class MyPhysicsList : public G4VModularPhysicsList
 {
 public:
-    MyPhysicsList(); /**< @brief Constructor of the class.*/
-    ~MyPhysicsList() override = default; /**< @brief Destructor of the class.*/
+    MyPhysicsList(); /**< @brief Constructor of the class, it defines the UI commands of the physics.*/
+    ~MyPhysicsList() override; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Constructs the processes of the registered physics and, if a
+     * readout window is set, adds G4UserSpecialCuts to the optical photons,
+     * which kills them outside of it (see
+     * MyDetectorConstruction::SetReadoutWindow()).
+     */
+    void ConstructProcess() override;
+
+    inline G4bool HasRadioactiveDecay() const { return fRadioactiveDecay != nullptr; } /**< @brief Tells whether the radioactive decay is simulated.*/
+
+private:
+    /**
+     * @brief Adds or removes the radioactive decay, before the
+     * initialization only.
+     *
+     * @param enable Whether the radioactive decay is simulated.
+     */
+    void SetRadioactiveDecay(G4bool enable);
+
+    G4VPhysicsConstructor *fRadioactiveDecay; /**< @brief The radioactive decay physics, nullptr if removed.*/
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
 };
 
 #endif  // PHYSICS_HH
@@ -5,11 +5,24 @@
 #ifndef RUN_HH
 #define RUN_HH
 
+#include <filesystem>
+
 #include "G4UserRunAction.hh"
 #include "G4Run.hh"
 #include "G4AnalysisManager.hh"
+#include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
 
 #include "event.hh"
+#include "construction.hh"
+#include "ntuple.hh"
+#include "eventrecord.hh"
+#include "columnarwriter.hh"
+#include "asyncwriter.hh"
+#include "shard.hh"
+#include "benchmark.hh"
+#include "timedstreambuf.hh"
 
 /**
  * @brief User action concrete class of G4UserRunAction. It defines procedures
@@ -22,32 +35,90 @@ public:
      * @brief Constructor of the class.
      *
      * It creates the TTree and its branches to store simulation
-     * output.
+     * output. In multi-threading mode the TTrees of the workers are merged
+     * by the master, which writes one file per run.
      * 
      * @param eventAction Pointer to a MyEventAction object, necessary for
      * associating data saved in each event with the TTree.
+     * @param shardDriver Pointer to the driver of the batch macro, if the
+     * application runs as a shard or in checkpointed blocks (its files are
+     * named after the shard and the block, and recorded in the manifest).
      */
-    MyRunAction(G4int theMCID, MyEventAction* eventAction);
-    ~MyRunAction() override = default; /**< @brief Destructor of the class.*/
+    MyRunAction(G4int theMCID, MyEventAction* eventAction, MyShardDriver *shardDriver = nullptr);
+    ~MyRunAction() override; /**< @brief Destructor of the class.*/
 
     /**
-     * @brief Creates and accesses the output root file at the beginning of the
-     * run.
+     * @brief Creates and accesses the output file at the beginning of the
+     * run, in the output directory (created if missing). The columnar file
+     * is opened by the master only.
+     *
+     * It also activates the scoring SDs needed by the run mode.
      * 
      * @param run Pointer to the G4Run.
      */
     void BeginOfRunAction(const G4Run* run) override;
     /**
      * @brief Writes the TTree to the output root file and closes it at the end
-     * of the run.
+     * of the run. In columnar format every thread appends its last chunk,
+     * then the master stops the writer thread and closes the file.
+     *
+     * It also merges the accumulables and, in light map mode, the master
+     * writes the light map file.
      * 
      * @param run Pointer to the G4Run.
      */
     void EndOfRunAction(const G4Run* run) override;
 
+    /**
+     * @brief Writes an event with the output backend of the run: a row of
+     * the TTree or, in columnar format, an entry of the chunk of the thread,
+     * appended to the file when full. With the writer thread, the event is
+     * queued to the @ref MyAsyncWriter instead.
+     *
+     * @param record The columns of the event. With the writer thread its
+     * vectors are moved, and replaced by empty ones.
+     */
+    void WriteEvent(MyEventRecord &record);
+
 private:
+    /**
+     * @brief Activates the SDs (and their options) needed by the run mode:
+     * the cosmic rays trigger only in modes 30 and 31, the Si trigger only in
+     * mode 22 and the crystal scoring in every mode but 50. It also warns if
+     * the output schema doesn't fit the mode.
+     *
+     * It acts only on the threads processing the events.
+     */
+    void ActivateScoring();
+
     G4int fMCID; /**< @brief The Monte Carlo ID.*/
     MyEventAction *fEventAction; /**< @brief Pointer to the MyEventAction object.*/
+    MyShardDriver *fShardDriver; /**< @brief Pointer to the driver of the shard, if any.*/
+    G4String fOutputDirectory; /**< @brief Directory of the output root files.*/
+    G4String fFileName; /**< @brief Output root file of the current run.*/
+    G4String fFormat; /**< @brief Output format: root or columnar.*/
+    G4String fSchemaName; /**< @brief Output schema: full, compact or led.*/
+    G4bool fDropDerived; /**< @brief Whether the compact schemas drop the derivable columns.*/
+    G4int fSchemaID; /**< @brief Index of the output schema of the current run in NT::GetSchemas().*/
+    std::vector<G4int> fNtupleIDs; /**< @brief IDs of the TTrees of the output schemas, -1 until booked by the first run writing them.*/
+    std::array<std::vector<G4float>, NT::nDoubleVectors> fFloatVectors; /**< @brief Float copies of the double vector columns, for the compact schemas.*/
+    G4bool fCompress; /**< @brief Whether the integer columns of the columnar files are compressed.*/
+    G4int fChunkSize; /**< @brief Number of events per chunk of the columnar files.*/
+    G4int fQueueSize; /**< @brief Capacity of the queue of the columnar writer thread, 0 for no thread.*/
+    G4int fNTimeBins; /**< @brief Number of bins of the arrival time histograms, 0 to write the photon lists.*/
+    G4double fTimeBinWidth; /**< @brief Width of the bins of the arrival time histograms.*/
+    G4double fTimeBinStart; /**< @brief Lower edge of the arrival time histograms.*/
+    G4bool fCountsOnly; /**< @brief Whether only the hits per channel are written instead of the photon lists.*/
+    G4bool fWriteNtuple; /**< @brief Whether the events are written in the ntuple (TTree or columnar file).*/
+    G4String fBaseName; /**< @brief Output files of the current run, without the extension: the tables of the run are named after it.*/
+    G4bool fRunWritesNtuple; /**< @brief Whether the current run writes the ntuple: @ref fWriteNtuple, unless the shards need it.*/
+    G4bool fColumnar; /**< @brief Whether the current run writes a columnar file.*/
+    G4bool fAsync; /**< @brief Whether the current run writes through the writer thread.*/
+    MyColumnarChunk fChunk; /**< @brief Chunk of the thread being filled, in columnar format.*/
+    MyTimedStreamBuf fCoutTimer; /**< @brief Timer of the writes of the thread to G4cout, for the benchmarks.*/
+    MyTimedStreamBuf fCerrTimer; /**< @brief Timer of the writes of the thread to G4cerr, for the benchmarks.*/
+
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
 };
 
 #endif  // RUN_HH
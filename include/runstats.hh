@@ -0,0 +1,106 @@
+/**
+ * @file runstats.hh
+ * @brief Declaration of the class @ref MyRunStats
+ */
+#ifndef RUNSTATS_HH
+#define RUNSTATS_HH
+
+#include <vector>
+#include <cstdint>
+
+#include "G4VAccumulable.hh"
+#include "G4GenericMessenger.hh"
+
+#include "globalsettings.hh"
+#include "hitbuffer.hh"
+
+/**
+ * @brief Thread-local accumulator of the calibration and data-quality
+ * statistics of a run, enabled with /MC_LYSO/stats/enable.
+ *
+ * For every channel of both faces the sum and the sum of the squares of the
+ * photons detected per event and the number of events with at least a hit
+ * (the occupancy) are accumulated; the arrival times of the photons of each
+ * face and the energy deposited in the crystal (by the events depositing
+ * some) are histogrammed, with an overflow bin each.
+ *
+ * It is registered in the G4AccumulableManager by @ref MyRunAction: the
+ * workers' sums are merged into the master's ones at the end of the run,
+ * then the master writes the summary with Write(), so per-channel means and
+ * RMS, occupancy maps and spectra don't need the ntuple at all (see
+ * /MC_LYSO/output/ntuple). The summaries of the shards are merged by
+ * @ref MyShardDriver with Read(). The sums are allocated at the first Fill(),
+ * with the binning set at that time.
+ */
+class MyRunStats : public G4VAccumulable
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * It defines the UI commands enabling the statistics and setting the
+     * binning of the histograms.
+     */
+    MyRunStats();
+    ~MyRunStats() override; /**< @brief Destructor of the class.*/
+
+    void Merge(const G4VAccumulable &other) override; /**< @brief Adds the sums of a worker.*/
+    void Reset() override; /**< @brief Releases the sums.*/
+
+    /**
+     * @brief Accumulates an event.
+     *
+     * @param hits The hits of the event.
+     * @param edep The energy deposited in the crystal.
+     */
+    void Fill(const MyHitBuffer &hits, G4double edep);
+
+    /**
+     * @brief Writes the summary of the run: the binning, the table of the
+     * channels (sums, mean, RMS and occupancy), the 13x11 occupancy maps of
+     * the faces, the arrival time histograms and the spectrum of the energy
+     * deposited.
+     *
+     * @param fileName The name of the text file.
+     */
+    void Write(const G4String &fileName) const;
+    /**
+     * @brief Adds the sums of a summary written by Write(), e.g. to merge
+     * the summaries of the shards. The binning must be the same as the one of
+     * the summaries read before.
+     *
+     * @param fileName The name of the text file.
+     * @return false if the summary can't be read or its binning differs.
+     */
+    G4bool Read(const G4String &fileName);
+
+    inline G4bool IsEnabled() const { return fEnabled; } /**< @brief Tells whether the statistics are accumulated.*/
+    inline G4bool HasEntries() const { return fNEvents > 0; } /**< @brief Tells whether something has been filled in this run.*/
+
+private:
+    void Book(G4int nTimeBins, G4double timeMax, G4int nEdepBins, G4double edepMax); /**< @brief Allocates the sums according to the binning.*/
+
+    static constexpr G4int nChannels = 2*GS::nOfSiPMs; /**< @brief Number of channels of both faces.*/
+
+    G4bool fEnabled; /**< @brief Whether the statistics are accumulated.*/
+    G4int fNTimeBins; /**< @brief Number of bins of the arrival time histograms.*/
+    G4double fTimeMax; /**< @brief Upper edge of the arrival time histograms, the lower one is 0.*/
+    G4int fNEdepBins; /**< @brief Number of bins of the spectrum of the energy deposited.*/
+    G4double fEdepMax; /**< @brief Upper edge of the spectrum of the energy deposited, the lower one is 0.*/
+
+    G4int fBookedNTimeBins = 0; /**< @brief Number of bins of the time histograms allocated.*/
+    G4double fBookedTimeMax = 0.; /**< @brief Upper edge of the time histograms allocated.*/
+    G4int fBookedNEdepBins = 0; /**< @brief Number of bins of the spectrum allocated.*/
+    G4double fBookedEdepMax = 0.; /**< @brief Upper edge of the spectrum allocated.*/
+
+    std::uint64_t fNEvents = 0; /**< @brief Number of events accumulated.*/
+    std::vector<G4double> fSum, /**< @brief Sum of the photons detected, [face*GS::nOfSiPMs + ch].*/
+                          fSum2; /**< @brief Sum of the squares of the photons detected, [face*GS::nOfSiPMs + ch].*/
+    std::vector<std::uint64_t> fOccupancy, /**< @brief Number of events with a hit, [face*GS::nOfSiPMs + ch].*/
+                               fTimes, /**< @brief Arrival time histograms, [face][bin], the last bin is the overflow.*/
+                               fEdep; /**< @brief Spectrum of the energy deposited, [bin], the last bin is the overflow.*/
+
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
+};
+
+#endif  // RUNSTATS_HH
@@ -0,0 +1,72 @@
+/**
+ * @file seeding.hh
+ * @brief Declaration of the class @ref MyEventSeeder
+ */
+#ifndef SEEDING_HH
+#define SEEDING_HH
+
+#include <vector>
+
+#include "G4GenericMessenger.hh"
+#include "Randomize.hh"
+
+/**
+ * @brief Reseeds the random engine at the beginning of every event, from the
+ * MCID, the run ID and the event ID.
+ *
+ * The output of an event then doesn't depend on the thread processing it (nor
+ * on the number of threads or shards), and a single event can be simulated
+ * again alone: the replay list maps the events of a run to the IDs to be
+ * replayed.
+ * The event IDs can be shifted by an offset, so that the shards of a Monte
+ * Carlo (see @ref MyShardDriver) number their events as a single process
+ * would.
+ */
+class MyEventSeeder
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * It defines the UI commands of the seeding and of the replay.
+     *
+     * @param theMCID The Monte Carlo ID.
+     */
+    MyEventSeeder(G4int theMCID);
+    ~MyEventSeeder(); /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Reseeds the engine for an event.
+     *
+     * @param runID The ID of the run (replaced by the one set by command, if
+     * any).
+     * @param eventIndex The ID of the event given by Geant4.
+     * @return false if the event is beyond the replay list.
+     */
+    G4bool SeedEvent(G4int runID, G4int eventIndex);
+
+    /**
+     * @brief Derives the seeds of an event with SplitMix64.
+     *
+     * @param seeds The two seeds, in [1, 2^31 - 1].
+     */
+    static void DeriveSeeds(G4int mcid, G4int runID, G4int eventID, long seeds[2]);
+
+    inline G4int GetEventID() const { return fEventID; } /**< @brief Get the ID of the event, after the offset or the replay list.*/
+    inline G4int GetSeed(G4int i) const { return static_cast<G4int>(fSeeds[i]); } /**< @brief Get one of the two seeds of the event.*/
+
+private:
+    void SetReplayList(const G4String &list); /**< @brief Sets the event IDs to replay, from a list separated by blanks.*/
+
+    G4int fMCID; /**< @brief The Monte Carlo ID.*/
+    G4int fEventOffset; /**< @brief Offset added to the event IDs given by Geant4.*/
+    G4int fRunID; /**< @brief ID of the run the seeds are derived from, the current one if negative.*/
+    std::vector<G4int> fReplayEvents; /**< @brief Event IDs to replay, empty for a normal run.*/
+
+    G4int fEventID; /**< @brief ID of the current event.*/
+    long fSeeds[3]; /**< @brief Seeds of the current event (zero terminated).*/
+
+    G4GenericMessenger *fMessenger; /**< @brief Generic messenger of the class.*/
+};
+
+#endif  // SEEDING_HH
@@ -0,0 +1,180 @@
+/**
+ * @file shard.hh
+ * @brief Declaration of the class @ref MyShardDriver
+ */
+#ifndef SHARD_HH
+#define SHARD_HH
+
+#include <vector>
+#include <cstdint>
+
+#include "globals.hh"
+
+/**
+ * @brief Drives the batch macro as one of N independent processes (shards)
+ * sharing its events, optionally in checkpointed blocks, and merges the
+ * outputs.
+ *
+ * Every /run/beamOn of the macro is split among the shards: the shard runs
+ * its part of the events, numbered (and then seeded by @ref MyEventSeeder)
+ * as in a single process. With a checkpoint interval, the part of the shard
+ * is further split into blocks, each one run separately and written to its
+ * own chunk file.
+ * Every file completed is recorded at once in the manifest of the shard,
+ * which is then its checkpoint: a resumed shard skips the blocks already
+ * done and, the events being seeded from their IDs, continues exactly as an
+ * uninterrupted one.
+ * Once all the shards are done, Merge() combines the manifests into the usual
+ * MCID_<seed> files and writes one entry in the MC summaries.
+ */
+class MyShardDriver
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param theMCID The Monte Carlo ID, shared by all the shards.
+     * @param index The index of this shard, from 0 to nShards - 1.
+     * @param nShards The number of shards.
+     * @param nEvents The total number of events of every run, overriding the
+     * ones of the /run/beamOn commands if positive.
+     * @param interval The number of events of the checkpointed blocks, zero
+     * to run the part of the shard at once.
+     * @param resume Whether to resume the shard from its manifest.
+     */
+    MyShardDriver(G4int theMCID, G4int index, G4int nShards, G4int nEvents = 0, G4int interval = 0, G4bool resume = false);
+    ~MyShardDriver() = default; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Parses the "i/N" specification of the shard.
+     *
+     * @return false if it isn't valid.
+     */
+    static G4bool ParseShard(const G4String &spec, G4int &index, G4int &nShards);
+    /**
+     * @brief Returns the next output of the SplitMix64 generator.
+     *
+     * @param state The state of the generator, advanced by the call.
+     */
+    static std::uint64_t SplitMix64(std::uint64_t &state);
+
+    /** @brief Seed of the random stream of this shard, derived from the MCID.*/
+    long GetSeed() const;
+    /** @brief Number of events of this shard, out of nTotal.*/
+    G4int GetShardEvents(G4int nTotal) const;
+    /** @brief ID of the first event of this shard, out of nTotal.*/
+    G4int GetFirstEvent(G4int nTotal) const;
+    /** @brief Tells whether the outputs have to be merged, i.e. there are shards or chunks.*/
+    inline G4bool NeedsMerge() const { return fNShards > 1 || fInterval > 0; }
+
+    /** @brief ID of the run of the macro being executed, i.e. its /run/beamOn count.*/
+    inline G4int GetRunID() const { return fRunID; }
+    /** @brief Suffix of the output file of the current block.*/
+    G4String GetFileSuffix() const;
+
+    /**
+     * @brief Executes the batch macro, with the events of every /run/beamOn
+     * reduced to the ones of this shard, run block by block.
+     *
+     * Only the /run/beamOn lines of the macro itself are split: a macro it
+     * executes with a /run/beamOn is refused.
+     *
+     * @return false if a command fails, a run has less events than shards,
+     * a nested macro has a /run/beamOn or the manifest to resume is missing
+     * or not of this shard.
+     */
+    G4bool ExecuteMacro(const G4String &macroFile);
+    /**
+     * @brief Records the output file of the block just completed in the
+     * manifest, called by the master @ref MyRunAction at the end of every
+     * run.
+     *
+     * @param nEvents The number of events of the block.
+     * @param fileName The output file of the block.
+     * @param schema The output schema of the file.
+     */
+    void AddOutputFile(G4int nEvents, const G4String &fileName, const G4String &schema);
+    /**
+     * @brief Marks the manifest of the shard as completed.
+     *
+     * @param duration The duration (in seconds) of the shard.
+     */
+    void CloseManifest(G4double duration) const;
+
+    /**
+     * @brief Merges the outputs of all the shards of a Monte Carlo.
+     *
+     * The rows are copied run by run, in shard and block order: the event
+     * IDs are already unique, since every block offsets them (see
+     * @ref MyEventSeeder). The LED tables, the run statistics and the
+     * light map counters of the shards are summed up too.
+     * An entry is then added to the MC summaries.
+     *
+     * @param manifests The manifest files, one per shard.
+     * @return false if the manifests are inconsistent or incomplete.
+     */
+    static G4bool Merge(const std::vector<G4String> &manifests);
+
+private:
+    /** @brief An output file (of a block) of the shard.*/
+    struct OutputFile
+    {
+        G4int runID; /**< @brief ID of the run.*/
+        G4int firstEvent; /**< @brief ID of the first event of the block.*/
+        G4int nEvents; /**< @brief Number of events of the block.*/
+        G4String schema; /**< @brief Output schema of the file.*/
+        G4String fileName; /**< @brief Name of the root file.*/
+    };
+
+    /** @brief Contents of a manifest.*/
+    struct Manifest
+    {
+        G4int mcid = 0; /**< @brief The Monte Carlo ID.*/
+        G4int index = -1; /**< @brief Index of the shard.*/
+        G4int nShards = 0; /**< @brief Number of shards.*/
+        G4int interval = 0; /**< @brief Events of the checkpointed blocks.*/
+        G4String macroFile; /**< @brief Batch macro of the shards.*/
+        G4double duration = -1.; /**< @brief Duration of the shard, negative if not completed.*/
+        std::vector<OutputFile> files; /**< @brief Output files of the shard.*/
+    };
+
+    /** @brief The shards' files of a run, merged into one file.*/
+    struct MergeJob
+    {
+        std::vector<G4String> inputFiles; /**< @brief Files of the shards, in shard and block order.*/
+        G4String outputFile; /**< @brief Name of the merged file.*/
+        G4String schema; /**< @brief Output schema of the files.*/
+    };
+
+    /**
+     * @brief Looks for a /run/beamOn in the macros executed by a macro
+     * (/control/execute, /control/loop and /control/foreach), recursively.
+     *
+     * @param macroFile The macro.
+     * @param depth The nesting level of the macro, 0 for the run macro.
+     * @param nestedMacro Output: the macro with the /run/beamOn.
+     * @return true if a nested /run/beamOn is found.
+     */
+    static G4bool FindNestedBeamOn(const G4String &macroFile, G4int depth, G4String &nestedMacro);
+    /** @brief Reads a manifest file, false if it can't be parsed.*/
+    static G4bool ReadManifest(const G4String &fileName, Manifest &manifest);
+    /** @brief Writes the header of the manifest and the files of the resumed blocks.*/
+    G4bool OpenManifest(const G4String &macroFile, const std::vector<OutputFile> &doneFiles) const;
+    /** @brief Copies the rows (root) or the chunks (columnar) of the shards' files into the merged files.*/
+    static G4bool MergeFiles(const std::vector<MergeJob> &jobs);
+    /** @brief Adds up the LED tables, the run statistics and the light map counters written next to the shards' files into the merged ones.*/
+    static G4bool MergeTables(const std::vector<MergeJob> &jobs);
+
+    G4int fMCID; /**< @brief The Monte Carlo ID.*/
+    G4int fIndex; /**< @brief Index of this shard.*/
+    G4int fNShards; /**< @brief Number of shards.*/
+    G4int fNEvents; /**< @brief Total number of events of every run, if positive.*/
+    G4int fInterval; /**< @brief Number of events of the checkpointed blocks, if positive.*/
+    G4bool fResume; /**< @brief Whether to resume the shard from its manifest.*/
+    G4String fManifestName; /**< @brief Name of the manifest of the shard.*/
+
+    G4int fRunID; /**< @brief ID of the run being executed.*/
+    G4int fFirstEvent; /**< @brief ID of the first event of the block being executed.*/
+};
+
+#endif  // SHARD_HH
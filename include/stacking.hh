@@ -0,0 +1,69 @@
+/**
+ * @file stacking.hh
+ * @brief Declaration of the class @ref MyStackingAction
+ */
+#ifndef STACKING_HH
+#define STACKING_HH
+
+#include "G4UserStackingAction.hh"
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4VProcess.hh"
+
+#include "event.hh"
+#include "generator.hh"
+
+/**
+ * @brief User action concrete class of G4UserStackingAction. In the run
+ * modes with a trigger it defers the tracking of the optical photons until
+ * the trigger is known.
+ *
+ * In the 176Lu decay modes (20, 21 and 22) it also makes the decay
+ * instantaneous: the decay products of the primary ion start at t = 0, and
+ * the decay point is stored as arrival and first interaction of the
+ * primary. With the tabulated decay the products are already the primaries
+ * at t = 0, and only the decay point is stored.
+ *
+ * In modes 22, 30 and 31 the optical photons are sent to the waiting stack,
+ * so that all the other particles (which fire the triggers) are tracked
+ * first. When the urgent stack is empty the trigger flags of
+ * @ref MyEventAction are checked: if the trigger failed the event would be
+ * discarded anyway, so all the optical photons are dropped without being
+ * tracked.
+ */
+class MyStackingAction : public G4UserStackingAction
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param eventAction Pointer to the MyEventAction object holding the
+     * trigger flags of the event.
+     */
+    MyStackingAction(MyEventAction *eventAction);
+    ~MyStackingAction() override = default; /**< @brief Destructor of the class.*/
+
+    /** @brief Sends the optical photons to the waiting stack in the triggered modes, and resets the time of the 176Lu decay products.*/
+    G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track *track) override;
+    /** @brief Drops the optical photons if the trigger of the event failed.*/
+    void NewStage() override;
+    /** @brief Caches the run mode at the beginning of the event.*/
+    void PrepareNewEvent() override;
+
+private:
+    /**
+     * @brief Makes the 176Lu decay instantaneous.
+     *
+     * @param track The new track.
+     */
+    void SetTimeOfDecay(const G4Track *track);
+
+    MyEventAction *fEventAction; /**< @brief Pointer to the MyEventAction object.*/
+    G4int fModeType; /**< @brief The run mode of the current event.*/
+    G4bool fIsTriggeredMode, /**< @brief Flag indicating whether the run mode requires a trigger.*/
+           fIsLuDecayMode, /**< @brief Flag indicating whether the run mode is a 176Lu decay one.*/
+           fIsTabulatedLuDecay; /**< @brief Flag indicating whether the 176Lu decay products are generated as primaries.*/
+};
+
+#endif  // STACKING_HH
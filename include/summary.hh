@@ -9,12 +9,17 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <cmath>
 #include <cstdlib>
 #include <string>
 #include <unistd.h>
 
 #include "globals.hh"
 
+#include "globalsettings.hh"
+#include "asyncwriter.hh"
+#include "cosmicrays.hh"
+
 
 /**
  * @brief Auxiliary function called by @ref MC_summary() to extract settings
@@ -34,14 +39,19 @@ G4String extract_value(const G4String& line, const G4String& keyword);
  * The summary includes:
  * - Monte Carlo ID (the seed of the run), date, username and
  * duration;
- * - Settings related to the primary generator;
+ * - Depth and stalls of the queue of the columnar writer thread, if used;
+ * - Settings related to the primary generator, with the acceptance of the
+ * cosmic rays trigger in the cosmic rays modes;
  * - Settings related to the construction.
  *
  * @param macrofile The name of the run macro file
  * @param seed The seed of the simulation
  * @param duration The duration (in seconds) of the simulation
  * @param output_filename The name of the text output file
+ * @param nShards The number of processes the Monte Carlo has been split into
+ * @param nEvents The total number of events, if it overrides the ones of the
+ * run macro
  */
-void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4String& output_filename);
+void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4String& output_filename, G4int nShards = 1, G4int nEvents = 0);
 
 #endif  // SUMMARY_HH
@@ -0,0 +1,53 @@
+/**
+ * @file timedstreambuf.hh
+ * @brief Declaration of the class @ref MyTimedStreamBuf
+ */
+#ifndef TIMEDSTREAMBUF_HH
+#define TIMEDSTREAMBUF_HH
+
+#include <streambuf>
+#include <ostream>
+
+#include "globals.hh"
+
+/**
+ * @brief Stream buffer measuring the time spent writing to a Geant4 output
+ * stream (G4cout, G4cerr), for the contention diagnostics of
+ * @ref MyBenchmark.
+ *
+ * It is installed in front of the buffer of the stream of a thread and
+ * forwards everything to it: in multi-threading the buffer of a worker hands
+ * its lines to the destination shared with the master, under a lock, and
+ * the time waited for it is included. It has no buffer of its own, so the
+ * stream output is unchanged.
+ */
+class MyTimedStreamBuf : public std::streambuf
+{
+public:
+    MyTimedStreamBuf() = default; /**< @brief Constructor of the class.*/
+    ~MyTimedStreamBuf() override = default; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Installs the buffer in front of the one of a stream, until
+     * Uninstall().
+     *
+     * @param stream The stream, of the current thread.
+     */
+    void Install(std::ostream &stream);
+    /** @brief Gives the stream its buffer back.*/
+    void Uninstall();
+
+    inline G4double GetTime() const { return fTime; } /**< @brief Get the time spent writing since the installation, in s.*/
+
+protected:
+    int_type overflow(int_type c) override; /**< @brief Forwards a character.*/
+    std::streamsize xsputn(const char *s, std::streamsize n) override; /**< @brief Forwards characters.*/
+    int sync() override; /**< @brief Forwards the flush, when the buffer of the stream writes the line.*/
+
+private:
+    std::ostream *fStream = nullptr; /**< @brief The stream the buffer is installed in.*/
+    std::streambuf *fTarget = nullptr; /**< @brief The buffer of the stream.*/
+    G4double fTime = 0.; /**< @brief Time spent writing, in s.*/
+};
+
+#endif  // TIMEDSTREAMBUF_HH
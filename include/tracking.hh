@@ -0,0 +1,45 @@
+/**
+ * @file tracking.hh
+ * @brief Declaration of the class @ref MyTrackingAction
+ */
+#ifndef TRACKING_HH
+#define TRACKING_HH
+
+#include "G4UserTrackingAction.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4OpticalPhoton.hh"
+
+#include "event.hh"
+
+/**
+ * @brief User action concrete class of G4UserTrackingAction. It counts the
+ * optical photons killed by the readout window (see
+ * MyDetectorConstruction::SetReadoutWindow()), and the tracks and their
+ * steps for the benchmarks.
+ */
+class MyTrackingAction : public G4UserTrackingAction
+{
+public:
+    /**
+     * @brief Constructor of the class.
+     *
+     * @param eventAction Pointer to the MyEventAction object storing the
+     * counts of the event.
+     */
+    MyTrackingAction(MyEventAction *eventAction);
+    ~MyTrackingAction() override = default; /**< @brief Destructor of the class.*/
+
+    /**
+     * @brief Counts the track and its steps, and the optical photon if its
+     * last step has been limited by G4UserSpecialCuts.
+     *
+     * @param track Pointer to the G4Track at its end.
+     */
+    void PostUserTrackingAction(const G4Track *track) override;
+
+private:
+    MyEventAction *fEventAction; /**< @brief Pointer to the MyEventAction object.*/
+};
+
+#endif  // TRACKING_HH
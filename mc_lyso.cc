@@ -12,10 +12,11 @@
 #include <iostream>
 #include <chrono>
 #include <cstdlib> 
-#include <sstream>
-#include <cstring>
+#include <vector>
+#include <filesystem>
 
 #include "G4RunManagerFactory.hh"
+#include "G4MTRunManager.hh"
 #include "G4VisManager.hh"
 #include "G4UImanager.hh"
 #include "G4VisExecutive.hh"
@@ -27,34 +28,137 @@
 #include "physics.hh"
 #include "action.hh"
 #include "summary.hh"
+#include "shard.hh"
+#include "benchmark.hh"
+
+/** @brief Prints the command line options */
+void PrintUsage(const char *program)
+{
+    G4cerr << "Usage: " << program << " [options] [macro]" << G4endl;
+    G4cerr << "       " << program << " --merge manifest..." << G4endl;
+    G4cerr << "Options:" << G4endl;
+    G4cerr << "  -s|-S seed          Seed, i.e. the MCID (random if not set)" << G4endl;
+    G4cerr << "  -r type             Run manager type: Serial, MT, Tasking, ..." << G4endl;
+    G4cerr << "  -t threads          Number of threads, overriding /run/numberOfThreads" << G4endl;
+    G4cerr << "  -e events           Events per task, as /run/eventModulo" << G4endl;
+    G4cerr << "  --shard i/N         Run the shard i of N" << G4endl;
+    G4cerr << "  --events N          Total number of events of every run" << G4endl;
+    G4cerr << "  --checkpoint N      Run in checkpointed blocks of N events" << G4endl;
+    G4cerr << "  --resume            Resume from the manifest" << G4endl;
+    G4cerr << "  --stats file        Write the throughput as JSON" << G4endl;
+    G4cerr << "  --baseline file     Compare the throughput with the baseline" << G4endl;
+    G4cerr << "  --record file       Record the throughput as the baseline" << G4endl;
+    G4cerr << "  --scaling file      Add the row of this process to the thread-scaling table" << G4endl;
+}
+
+
 
 /** @brief Main of the application */
 int main(int argc, char** argv)
 {
     // Seed
     G4int fSeed = 0;
+    // Run manager settings, zero means the Geant4 defaults
+    G4String runManagerType = "Default";
+    G4int nThreads = 0;
+    G4int nEventsPerTask = 0;
+    // Sharding: this process runs the shard i of N, on nEvents per run
+    G4String shardSpec;
+    G4int nEvents = 0;
+    // Checkpoint: events per block, and resume from the manifest
+    G4int checkpointInterval = 0;
+    G4bool resume = false;
+    // Benchmark: JSON file of the throughput, baseline to compare with or
+    // to record, and thread-scaling table to add the row of this process to
+    G4String statsFile, baselineFile, recordFile, scalingFile;
+    // Macro to execute in batch mode
+    G4String fileName;
+    // Exit code: 1 if the shard failed, 3 if the benchmark regressed
+    G4int exitCode = 0;
+
+    // Merge of the shards or blocks: all the other arguments are their manifests
+    if(argc > 1 && G4String(argv[1]) == "--merge")
+    {
+        std::vector<G4String> manifests(argv + 2, argv + argc);
+        return MyShardDriver::Merge(manifests) ? 0 : 1;
+    }
 
     // Parsing command line arguments
     for(G4int i = 1; i < argc; i++)
     {
-        if(G4String(argv[i]) == "-s" || G4String(argv[i]) == "-S")
+        G4String arg = argv[i];
+        if(arg == "--resume")
         {
-            if(i + 1 < argc)
+            resume = true;
+        }
+        else if(arg == "-s" || arg == "-S" || arg == "-r" || arg == "-t" || arg == "-e" || arg == "--shard" || arg == "--events" || arg == "--checkpoint" || arg == "--stats" || arg == "--baseline" || arg == "--record" || arg == "--scaling")
+        {
+            if(i + 1 >= argc)
+            {
+                G4cerr << "Error: Missing value after " << arg << "." << G4endl;
+                return 1;
+            }
+            G4String value = argv[++i]; // Skip the next argument since it is the value
+
+            if(arg == "-s" || arg == "-S")
             {
-                fSeed = std::stoi(argv[i + 1]);
+                fSeed = std::stoi(value);
                 G4cout << "Seed set manually to: " << fSeed << G4endl;
-                ++i; // Skip the next argument since it is the seed
+            }
+            else if(arg == "-r")
+            {
+                runManagerType = value;
+            }
+            else if(arg == "-t")
+            {
+                nThreads = std::stoi(value);
+            }
+            else if(arg == "-e")
+            {
+                nEventsPerTask = std::stoi(value);
+            }
+            else if(arg == "--shard")
+            {
+                shardSpec = value;
+            }
+            else if(arg == "--checkpoint")
+            {
+                checkpointInterval = std::stoi(value);
+            }
+            else if(arg == "--stats")
+            {
+                statsFile = value;
+            }
+            else if(arg == "--baseline")
+            {
+                baselineFile = value;
+            }
+            else if(arg == "--record")
+            {
+                recordFile = value;
+            }
+            else if(arg == "--scaling")
+            {
+                scalingFile = value;
             }
             else
             {
-                G4cerr << "Error: Missing seed value after -s or -S." << G4endl;
-                return 1;
+                nEvents = std::stoi(value);
             }
         }
+        else if(arg[0] == '-')
+        {
+            G4cerr << "Error: Unknown option " << arg << "." << G4endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        else
+            fileName = arg;
     }
 
     // If no seed is passed, set the seed randomly
-    if(fSeed == 0)
+    G4bool isSeedSet = fSeed != 0;
+    if(!isSeedSet)
         G4Random::setTheSeed(time(NULL) + getpid());
     else
         G4Random::setTheSeed(fSeed);
@@ -62,17 +166,76 @@ int main(int argc, char** argv)
     // Save the seed of the simulation
     fSeed = G4Random::getTheSeed();
 
+    // A shard keeps the MCID, but its random stream is derived from it
+    MyShardDriver *shardDriver = nullptr;
+    if(!shardSpec.empty() || nEvents > 0 || checkpointInterval > 0 || resume)
+    {
+        G4int shardIndex = 0, nShards = 1;
+        if(!shardSpec.empty() && !MyShardDriver::ParseShard(shardSpec, shardIndex, nShards))
+        {
+            G4cerr << "Error: Invalid shard " << shardSpec << ", expected i/N with 0 <= i < N." << G4endl;
+            return 1;
+        }
+        if((nShards > 1 || resume) && !isSeedSet)
+        {
+            G4cerr << "Error: The shards of a Monte Carlo, or its resume, need its seed: pass it with -s." << G4endl;
+            return 1;
+        }
+        if(fileName.empty())
+        {
+            G4cerr << "Error: A shard or a checkpointed run needs a run macro." << G4endl;
+            return 1;
+        }
+
+        shardDriver = new MyShardDriver(fSeed, shardIndex, nShards, nEvents, checkpointInterval, resume);
+        G4Random::setTheSeed(shardDriver->GetSeed());
+    }
+
+    // The writes to the output streams are timed for the benchmarks only
+    MyBenchmark::Instance()->SetTimingStreams(!statsFile.empty() || !recordFile.empty() || !scalingFile.empty());
+
+    // Choose the run manager type (Serial, MT, Tasking, ...)
+    G4RunManagerType type = G4RunManagerType::Default;
+    if(runManagerType != "Default")
+    {
+        auto options = G4RunManagerFactory::GetOptions();
+        if(options.find(runManagerType) == options.end())
+        {
+            G4cerr << "Error: Run manager type " << runManagerType << " not available. Choose among:";
+            for(const auto &option : options)
+                G4cerr << " " << option;
+            G4cerr << G4endl;
+            return 1;
+        }
+        type = G4RunManagerFactory::GetType(runManagerType);
+    }
+
+    // The number of threads (pool size for tasking) passed here is forced,
+    // i.e. it overrides /run/numberOfThreads of the macro
+    if(nThreads > 0)
+        setenv("G4FORCENUMBEROFTHREADS", std::to_string(nThreads).c_str(), 1);
+
     // Construct the run manager
-    auto* runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+    auto* runManager = G4RunManagerFactory::CreateRunManager(type);
+
+    // Events per task (tasking) or per request of a worker (MT): the macro
+    // can set it as well with /run/eventModulo
+    if(nEventsPerTask > 0)
+    {
+        if(auto *mtRunManager = dynamic_cast<G4MTRunManager*>(runManager))
+            mtRunManager->SetEventModulo(nEventsPerTask);
+        else
+            G4cout << "Events per task ignored: the run manager is sequential." << G4endl;
+    }
     
     // Set mandatory initialization classes
     runManager->SetUserInitialization(new MyDetectorConstruction());
     runManager->SetUserInitialization(new MyPhysicsList());
-    runManager->SetUserInitialization(new MyActionInitialization(fSeed));
+    runManager->SetUserInitialization(new MyActionInitialization(fSeed, shardDriver));
     
-    // Detect interactive mode (if no arguments) and define UI session
+    // Detect interactive mode (if no macro) and define UI session
     G4UIExecutive *ui = 0;
-    if(argc == 1)
+    if(fileName.empty())
     {
         ui = new G4UIExecutive(argc, argv);
     }
@@ -95,57 +258,52 @@ int main(int argc, char** argv)
     {
         // Batch mode
         auto start = std::chrono::high_resolution_clock::now();
+        G4double wallTime = 0.;
         
-        G4String command = "/control/execute ";
-        G4String fileName = argv[argc - 1];
-        UImanager->ApplyCommand(command+fileName);
+        if(shardDriver)
+        {
+            G4bool done = shardDriver->ExecuteMacro(fileName);
 
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> duration = end - start;
-        
-        // Save a summary of the simulation
-        MC_summary(fileName, fSeed, duration.count(), "MC_summaries.txt");
-        G4cout << G4endl;
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = end - start;
+            wallTime = duration.count();
 
-        // Execute hadd shell command for MT Run Manager
-        if(runManager->GetRunManagerType() == 1)
-        {
-            G4int nOfRuns = runManager->GetCurrentRun()->GetRunID();
-            std::ostringstream shell_command;
-            std::stringstream strMCID;
-            strMCID << fSeed;
-            std::stringstream strRunID;
-
-            // First run hadd
-            shell_command << "hadd -v 0 MCID_" + strMCID.str() + ".root MCID_" + strMCID.str() + "_t*";
-            system(shell_command.str().c_str());
-
-            // Loop for next runs
-            for(G4int i = 1; i <= nOfRuns; i++)
+            // The summary is written by the merge of the shards or blocks; a
+            // failed shard neither closes its manifest nor writes a summary
+            if(!done)
             {
-                shell_command.str("");
-                shell_command.clear();
-                strRunID.str("");
-                strRunID.clear();
-
-                if(i == 1)
-                {
-                    std::ostringstream shell_command_0;
-                    shell_command_0 << "mv MCID_" + strMCID.str() + ".root MCID_" + strMCID.str() + "_RunID_0.root";
-                    system(shell_command_0.str().c_str());
-                }
-
-                strRunID << i;
-
-                shell_command << "hadd -v 0 MCID_" + strMCID.str() + "_RunID_" + strRunID.str() + ".root MCID_" + strMCID.str() + "_RunID_" + strRunID.str() + "_t*";
-                system(shell_command.str().c_str());
+                G4cerr << "Error: The shard didn't complete." << G4endl;
+                exitCode = 1;
             }
+            else if(shardDriver->NeedsMerge())
+                shardDriver->CloseManifest(duration.count());
+            else
+                MC_summary(fileName, fSeed, duration.count(), "MC_summaries.txt", 1, nEvents);
+        }
+        else
+        {
+            G4String command = "/control/execute ";
+            UImanager->ApplyCommand(command+fileName);
 
-            // Move files in RootFiles directory
-            std::ostringstream move_files_command;
-            move_files_command << "rm *" + strMCID.str() + "_t* && mv MCID_" + strMCID.str() + ".root ./RootFiles/";
-            system(move_files_command.str().c_str());
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> duration = end - start;
+            wallTime = duration.count();
+            
+            // Save a summary of the simulation
+            MC_summary(fileName, fSeed, duration.count(), "MC_summaries.txt");
         }
+
+        // Throughput of the macro, compared with the baseline of its name
+        MyBenchmark *benchmark = MyBenchmark::Instance();
+        if(!statsFile.empty())
+            benchmark->WriteStats(statsFile, fileName, runManager->GetNumberOfThreads(), wallTime);
+        if(!baselineFile.empty() && !benchmark->CompareBaseline(baselineFile, std::filesystem::path(fileName).stem().string()))
+            exitCode = 3;
+        if(!recordFile.empty())
+            benchmark->RecordBaseline(recordFile, std::filesystem::path(fileName).stem().string());
+        if(!scalingFile.empty())
+            benchmark->AddScalingRow(scalingFile, fileName, runManager->GetNumberOfThreads());
+        G4cout << G4endl;
     }
 
     // Finally print some useful messages
@@ -157,5 +315,6 @@ int main(int argc, char** argv)
     // Job termination
     delete visManager;
     delete runManager;
-    return 0;
+    delete shardDriver;
+    return exitCode;
 }
@@ -4,9 +4,10 @@
  */
 #include "action.hh"
 
-MyActionInitialization::MyActionInitialization(G4int theMCID)
+MyActionInitialization::MyActionInitialization(G4int theMCID, MyShardDriver *shardDriver)
 {
     fMCID = theMCID;
+    fShardDriver = shardDriver;
 }
 
 
@@ -16,7 +17,7 @@ void MyActionInitialization::BuildForMaster() const
     // Here must be initialized only Run Action
     MyEventAction *eventAction = new MyEventAction();
     
-    MyRunAction *runAction = new MyRunAction(fMCID, eventAction);
+    MyRunAction *runAction = new MyRunAction(fMCID, eventAction, fShardDriver);
     SetUserAction(runAction);
 }
 
@@ -25,15 +26,18 @@ void MyActionInitialization::BuildForMaster() const
 void MyActionInitialization::Build() const
 {
     // Initialize all the user actions. Only PrimaryGenerator is mandatory in G4
-    MyPrimaryGenerator *generator = new MyPrimaryGenerator();
+    MyPrimaryGenerator *generator = new MyPrimaryGenerator(fMCID);
     SetUserAction(generator);
 
     MyEventAction *eventAction = new MyEventAction();
     SetUserAction(eventAction);
 
-    MyRunAction *runAction = new MyRunAction(fMCID, eventAction);
+    MyRunAction *runAction = new MyRunAction(fMCID, eventAction, fShardDriver);
     SetUserAction(runAction);
 
-    MySteppingAction *steppingAction = new MySteppingAction(eventAction);
-    SetUserAction(steppingAction);
+    MyStackingAction *stackingAction = new MyStackingAction(eventAction);
+    SetUserAction(stackingAction);
+
+    MyTrackingAction *trackingAction = new MyTrackingAction(eventAction);
+    SetUserAction(trackingAction);
 }
@@ -0,0 +1,160 @@
+/**
+ * @file asyncwriter.cc
+ * @brief Definition of the class @ref MyAsyncWriter
+ */
+#include "asyncwriter.hh"
+
+#include <chrono>
+#include <algorithm>
+
+MyAsyncWriter::~MyAsyncWriter()
+{
+    if(IsRunning())
+        Stop();
+}
+
+
+
+MyAsyncWriter *MyAsyncWriter::Instance()
+{
+    static MyAsyncWriter instance;
+    return &instance;
+}
+
+
+
+void MyAsyncWriter::Start(G4int queueSize, G4int chunkSize, const MyOutputSchema &schema)
+{
+    if(IsRunning())
+        Stop();
+
+    fQueue = std::make_unique<MyBoundedQueue<MyEventRecord*>>(queueSize);
+    fFreeRecords = std::make_unique<MyBoundedQueue<MyEventRecord*>>(queueSize);
+    fChunkSize = chunkSize;
+    fChunk.SetSchema(schema);
+
+    fNEvents = 0;
+    fSumDepth = 0;
+    fMaxDepth = 0;
+    fNStalls = 0;
+    fStallNs = 0;
+
+    fStop = false;
+    fThread = std::thread(&MyAsyncWriter::Loop, this);
+}
+
+
+
+void MyAsyncWriter::Submit(MyEventRecord &record)
+{
+    // Reuse a record already written, with its capacity
+    MyEventRecord *owned;
+    if(!fFreeRecords->TryPop(owned))
+        owned = new MyEventRecord();
+    record.MoveTo(*owned);
+
+    if(!fQueue->TryPush(owned))
+    {
+        auto start = std::chrono::steady_clock::now();
+        while(!fQueue->TryPush(owned))
+            std::this_thread::yield();
+        auto stall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        fNStalls.fetch_add(1, std::memory_order_relaxed);
+        fStallNs.fetch_add(stall.count(), std::memory_order_relaxed);
+    }
+
+    std::uint64_t depth = fQueue->GetDepth();
+    fNEvents.fetch_add(1, std::memory_order_relaxed);
+    fSumDepth.fetch_add(depth, std::memory_order_relaxed);
+    std::uint64_t maxDepth = fMaxDepth.load(std::memory_order_relaxed);
+    while(depth > maxDepth && !fMaxDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed));
+}
+
+
+
+void MyAsyncWriter::Stop()
+{
+    if(!IsRunning())
+        return;
+
+    fStop = true;
+    fThread.join();
+
+    // Release the records
+    MyEventRecord *record;
+    while(fFreeRecords->TryPop(record))
+        delete record;
+
+    fRunStats.nEvents = fNEvents;
+    fRunStats.capacity = fQueue->GetCapacity();
+    fRunStats.maxDepth = fMaxDepth;
+    fRunStats.meanDepth = fNEvents ? static_cast<G4double>(fSumDepth)/fNEvents : 0.;
+    fRunStats.nStalls = fNStalls;
+    fRunStats.stallTime = fStallNs*1e-9;
+
+    std::uint64_t nEvents = fTotalStats.nEvents + fRunStats.nEvents;
+    if(nEvents)
+        fTotalStats.meanDepth = (fTotalStats.meanDepth*fTotalStats.nEvents + fRunStats.meanDepth*fRunStats.nEvents)/nEvents;
+    fTotalStats.nEvents = nEvents;
+    fTotalStats.capacity = std::max(fTotalStats.capacity, fRunStats.capacity);
+    fTotalStats.maxDepth = std::max(fTotalStats.maxDepth, fRunStats.maxDepth);
+    fTotalStats.nStalls += fRunStats.nStalls;
+    fTotalStats.stallTime += fRunStats.stallTime;
+
+    G4cout << "Output queue: " << fRunStats.nEvents << " events, depth " << fRunStats.meanDepth << " on average and " << fRunStats.maxDepth << " at most (capacity " << fRunStats.capacity << "), " << fRunStats.nStalls << " stalls for " << fRunStats.stallTime << " s" << G4endl;
+}
+
+
+
+void MyAsyncWriter::Loop()
+{
+    MyEventRecord *record;
+    G4int nIdle = 0;
+
+    for(;;)
+    {
+        if(fQueue->TryPop(record))
+        {
+            Write(record);
+            nIdle = 0;
+            continue;
+        }
+
+        // The threads push their last events before the master stops the
+        // writer: the ones pushed since the last look are still to write
+        if(fStop)
+        {
+            while(fQueue->TryPop(record))
+                Write(record);
+            break;
+        }
+
+        // Spin a little, then sleep: the events come at most every few us
+        if(++nIdle < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    MyColumnarWriter::Instance()->Append(fChunk);
+    fChunk.Clear();
+}
+
+
+
+void MyAsyncWriter::Write(MyEventRecord *record)
+{
+    fChunk.Add(*record);
+    if(fChunk.GetNEvents() >= fChunkSize)
+    {
+        MyColumnarWriter::Instance()->Append(fChunk);
+        fChunk.Clear();
+    }
+
+    for(auto &values : record->intStorage) values.clear();
+    for(auto &values : record->doubleStorage) values.clear();
+
+    if(!fFreeRecords->TryPush(record))
+        delete record;
+}
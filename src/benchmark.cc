@@ -0,0 +1,284 @@
+/**
+ * @file benchmark.cc
+ * @brief Definition of the class @ref MyBenchmark
+ */
+#include "benchmark.hh"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <sys/resource.h>
+
+namespace
+{
+    // Peak resident memory of the process, in MB
+    G4double GetPeakRSS()
+    {
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0.;
+#ifdef __APPLE__
+        return usage.ru_maxrss/(1024.*1024.);
+#else
+        return usage.ru_maxrss/1024.;
+#endif
+    }
+
+    // Tolerances suggested for a new baseline: the throughputs are noisy,
+    // the output of a fixed seed is not
+    G4double GetDefaultTolerance(const MyBenchmarkMetric &metric)
+    {
+        if(metric.higherIsBetter)
+            return 0.10;
+        return G4String(metric.name) == "peak_rss_mb" ? 0.05 : 0.01;
+    }
+}
+
+
+
+MyBenchmark *MyBenchmark::Instance()
+{
+    static MyBenchmark instance;
+    return &instance;
+}
+
+
+
+void MyBenchmark::BeginRun()
+{
+    fRunStart = std::chrono::steady_clock::now();
+}
+
+
+
+void MyBenchmark::EndRun(const MyPerfCounters &counters, std::uint64_t outputBytes, G4double mergeTime)
+{
+    std::chrono::duration<G4double> duration = std::chrono::steady_clock::now() - fRunStart;
+    fRunTime += duration.count();
+    fNRuns++;
+    fNEvents += counters.GetNEvents();
+    fNOpticalPhotons += counters.GetNOpticalPhotons();
+    fNSteps += counters.GetNSteps();
+    fNHits += counters.GetNHits();
+    fOutputBytes += outputBytes;
+
+    fNThreads = counters.GetNThreads();
+    fBusyTime += counters.fBusyTime;
+    fMinBusyTime += counters.GetMinBusyTime();
+    fMaxBusyTime += counters.GetMaxBusyTime();
+    fOutputTime += counters.fOutputTime;
+    fStreamTime += counters.fStreamTime;
+    fEndOfRunTime += counters.fEndOfRunTime;
+    fMergeTime += mergeTime;
+}
+
+
+
+std::vector<MyBenchmarkMetric> MyBenchmark::GetMetrics() const
+{
+    G4double runTime = fRunTime > 0. ? fRunTime : 1.;
+    G4double nEvents = fNEvents > 0 ? fNEvents : 1.;
+
+    return {
+        {"events_per_s", fNEvents/runTime, true},
+        {"optical_photons_per_s", fNOpticalPhotons/runTime, true},
+        {"steps_per_s", fNSteps/runTime, true},
+        {"hits_per_s", fNHits/runTime, true},
+        {"peak_rss_mb", GetPeakRSS(), false},
+        {"output_bytes_per_event", fOutputBytes/nEvents, false}
+    };
+}
+
+
+
+G4bool MyBenchmark::WriteStats(const G4String &fileName, const G4String &macro, G4int nThreads, G4double wallTime) const
+{
+    std::ofstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't write the stats file " << fileName << G4endl;
+        return false;
+    }
+
+    file << std::setprecision(10);
+    file << "{\n";
+    file << "  \"macro\": \"" << macro << "\",\n";
+    file << "  \"threads\": " << nThreads << ",\n";
+    file << "  \"runs\": " << fNRuns << ",\n";
+    file << "  \"events\": " << fNEvents << ",\n";
+    file << "  \"optical_photons\": " << fNOpticalPhotons << ",\n";
+    file << "  \"steps\": " << fNSteps << ",\n";
+    file << "  \"hits\": " << fNHits << ",\n";
+    file << "  \"output_bytes\": " << fOutputBytes << ",\n";
+    file << "  \"run_time_s\": " << fRunTime << ",\n";
+    file << "  \"wall_time_s\": " << wallTime;
+    for(const auto &metric : GetMetrics())
+        file << ",\n  \"" << metric.name << "\": " << metric.value;
+
+    // Where the threads wait
+    G4double runTime = fRunTime > 0. ? fRunTime : 1.;
+    file << ",\n  \"busy_fraction_min\": " << fMinBusyTime/runTime;
+    file << ",\n  \"busy_fraction_mean\": " << fBusyTime/(fNThreads*runTime);
+    file << ",\n  \"busy_fraction_max\": " << fMaxBusyTime/runTime;
+    file << ",\n  \"output_time_s\": " << fOutputTime;
+    file << ",\n  \"stream_time_s\": " << fStreamTime;
+    file << ",\n  \"end_of_run_time_s\": " << fEndOfRunTime;
+    file << ",\n  \"merge_time_s\": " << fMergeTime;
+    file << "\n}\n";
+
+    return true;
+}
+
+
+
+G4bool MyBenchmark::CompareBaseline(const G4String &baselineFile, const G4String &key) const
+{
+    std::ifstream file(baselineFile);
+    if(!file)
+    {
+        G4cerr << "Can't read the baseline file " << baselineFile << G4endl;
+        return false;
+    }
+
+    std::vector<MyBenchmarkMetric> metrics = GetMetrics();
+    std::vector<G4bool> found(metrics.size(), false);
+    G4bool passed = true;
+
+    G4cout << "Benchmark " << key << " against " << baselineFile << ":" << G4endl;
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string macro, name;
+        G4double value, tolerance;
+        if(line.empty() || line[0] == '#' || !(stream >> macro >> name >> value >> tolerance) || macro != key)
+            continue;
+
+        auto metric = std::find_if(metrics.begin(), metrics.end(), [&name](const MyBenchmarkMetric &m) { return name == m.name; });
+        if(metric == metrics.end())
+        {
+            G4cerr << "Unknown metric " << name << " in the baseline" << G4endl;
+            continue;
+        }
+        found[metric - metrics.begin()] = true;
+
+        G4bool regressed = metric->higherIsBetter ? metric->value < value*(1. - tolerance) : metric->value > value*(1. + tolerance);
+        passed = passed && !regressed;
+
+        G4double change = value != 0. ? 100.*(metric->value/value - 1.) : 0.;
+        G4cout << "  " << std::left << std::setw(24) << name << std::right << std::setw(14) << metric->value << " vs " << std::setw(14) << value << " (" << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos << ", tolerance " << 100.*tolerance << "%)" << std::defaultfloat << std::setprecision(6) << (regressed ? "  REGRESSED" : "  ok") << G4endl;
+    }
+
+    // Without a throughput the hot path isn't guarded: the macro fails
+    // until its baseline is recorded (see RecordBaseline())
+    G4bool isThroughputMissing = false;
+    for(size_t i = 0; i < metrics.size(); i++)
+    {
+        if(found[i])
+            continue;
+        if(metrics[i].higherIsBetter)
+            isThroughputMissing = true;
+        G4cout << "  Missing in the baseline: " << key << " " << metrics[i].name << " " << metrics[i].value << " " << GetDefaultTolerance(metrics[i]) << G4endl;
+    }
+    if(isThroughputMissing)
+    {
+        G4cerr << "No throughput baseline for " << key << " in " << baselineFile << ": record it with --record on this machine" << G4endl;
+        passed = false;
+    }
+
+    return passed;
+}
+
+
+
+G4bool MyBenchmark::RecordBaseline(const G4String &baselineFile, const G4String &key) const
+{
+    // Keep the comments and the lines of the other macros
+    std::vector<std::string> lines;
+    std::ifstream input(baselineFile);
+    std::string line;
+    while(std::getline(input, line))
+    {
+        std::istringstream stream(line);
+        std::string macro;
+        if(line.empty() || line[0] == '#' || !(stream >> macro) || macro != key)
+            lines.push_back(line);
+    }
+    input.close();
+
+    std::ofstream output(baselineFile);
+    if(!output)
+    {
+        G4cerr << "Can't write the baseline file " << baselineFile << G4endl;
+        return false;
+    }
+
+    for(const auto &otherLine : lines)
+        output << otherLine << G4endl;
+    for(const auto &metric : GetMetrics())
+        output << key << " " << metric.name << " " << std::setprecision(6) << metric.value << " " << GetDefaultTolerance(metric) << G4endl;
+
+    G4cout << "Baseline of " << key << " recorded in " << baselineFile << G4endl;
+    return true;
+}
+
+
+
+G4bool MyBenchmark::AddScalingRow(const G4String &fileName, const G4String &macro, G4int nThreads) const
+{
+    // A row of the table: the speedup and the efficiency are recomputed
+    struct Row
+    {
+        G4int nThreads;
+        G4double runTime, eventsPerS, busyMin, busyMean, busyMax, outputTime, streamTime, endOfRunTime, mergeTime;
+    };
+
+    G4double runTime = fRunTime > 0. ? fRunTime : 1.;
+    Row thisRow = {nThreads, fRunTime, fNEvents/runTime, fMinBusyTime/runTime, fBusyTime/(fNThreads*runTime), fMaxBusyTime/runTime, fOutputTime, fStreamTime, fEndOfRunTime, fMergeTime};
+
+    // The rows of the other processes, but the one with the same threads
+    std::vector<Row> rows;
+    std::ifstream input(fileName);
+    std::string line;
+    while(std::getline(input, line))
+    {
+        std::istringstream stream(line);
+        Row row;
+        G4double speedup, efficiency;
+        if(line.empty() || line[0] == '#' || !(stream >> row.nThreads >> row.runTime >> row.eventsPerS >> speedup >> efficiency >> row.busyMin >> row.busyMean >> row.busyMax >> row.outputTime >> row.streamTime >> row.endOfRunTime >> row.mergeTime))
+            continue;
+        if(row.nThreads != nThreads)
+            rows.push_back(row);
+    }
+    input.close();
+
+    rows.push_back(thisRow);
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.nThreads < b.nThreads; });
+
+    std::ofstream output(fileName);
+    if(!output)
+    {
+        G4cerr << "Can't write the scaling table " << fileName << G4endl;
+        return false;
+    }
+
+    std::ostringstream table;
+    table << "# Thread scaling of " << macro << ": speedup relative to " << rows.front().nThreads << " thread(s), busy fractions of the event loop, times in s\n";
+    table << "# threads     run_s  events/s  speedup  efficiency  busy_min  busy_mean  busy_max  output_s  stream_s  endrun_s   merge_s\n";
+    for(const auto &row : rows)
+    {
+        G4double speedup = rows.front().eventsPerS > 0. ? row.eventsPerS/rows.front().eventsPerS*rows.front().nThreads : 0.;
+        table << std::setw(9) << row.nThreads << std::fixed << std::setprecision(3)
+              << std::setw(10) << row.runTime << std::setw(10) << row.eventsPerS
+              << std::setw(9) << speedup << std::setw(12) << speedup/row.nThreads
+              << std::setw(10) << row.busyMin << std::setw(11) << row.busyMean << std::setw(10) << row.busyMax
+              << std::setw(10) << row.outputTime << std::setw(10) << row.streamTime << std::setw(10) << row.endOfRunTime << std::setw(10) << row.mergeTime << "\n";
+    }
+
+    output << table.str();
+    G4cout << table.str() << G4endl;
+
+    return true;
+}
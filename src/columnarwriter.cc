@@ -0,0 +1,373 @@
+/**
+ * @file columnarwriter.cc
+ * @brief Definition of the classes @ref MyColumnarChunk and
+ * @ref MyColumnarWriter
+ */
+#include "columnarwriter.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "G4AutoLock.hh"
+
+namespace
+{
+    G4Mutex columnarWriterMutex = G4MUTEX_INITIALIZER;
+
+    // Columnar type of a column of a schema
+    std::uint32_t ColumnarType(MyColumnType type)
+    {
+        switch(type)
+        {
+            case MyColumnType::Int: return kColumnarInt;
+            case MyColumnType::Double: return kColumnarDouble;
+            case MyColumnType::Float: return kColumnarFloat;
+            case MyColumnType::IntVector: return kColumnarIntArray;
+            case MyColumnType::DoubleVector: return kColumnarDoubleArray;
+            case MyColumnType::FloatVector: return kColumnarFloatArray;
+            case MyColumnType::ByteVector: return kColumnarByteArray;
+        }
+        return kColumnarInt;
+    }
+
+    template<typename T>
+    void AppendValue(std::vector<char> &bytes, T value)
+    {
+        const char *begin = reinterpret_cast<const char*>(&value);
+        bytes.insert(bytes.end(), begin, begin + sizeof(T));
+    }
+
+    // Converts the values to the stored type
+    template<typename T, typename S>
+    void AppendValues(std::vector<char> &bytes, const std::vector<S> &values)
+    {
+        size_t size = bytes.size();
+        bytes.resize(size + values.size()*sizeof(T));
+        T *out = reinterpret_cast<T*>(bytes.data() + size);
+        for(size_t i = 0; i < values.size(); i++)
+            out[i] = static_cast<T>(values[i]);
+    }
+
+    void AppendRaw(std::vector<char> &bytes, const void *data, size_t size)
+    {
+        const char *begin = static_cast<const char*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    // Delta, zigzag and LEB128 varint: the inverse of MyDecodeDeltaVarint()
+    void AppendDeltaVarint(std::vector<char> &bytes, const std::int32_t *values, size_t n)
+    {
+        std::int64_t previous = 0;
+        for(size_t i = 0; i < n; i++)
+        {
+            std::int64_t delta = values[i] - previous;
+            previous = values[i];
+            std::uint64_t zigzag = (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+            do
+            {
+                std::uint8_t byte = zigzag & 0x7F;
+                zigzag >>= 7;
+                if(zigzag) byte |= 0x80;
+                bytes.push_back(static_cast<char>(byte));
+            } while(zigzag);
+        }
+    }
+
+    void Align(std::vector<char> &bytes)
+    {
+        bytes.resize((bytes.size() + 7)/8*8, 0);
+    }
+}
+
+
+
+void MyColumnarChunk::SetSchema(const MyOutputSchema &schema)
+{
+    fColumns.resize(schema.columns.size());
+    for(size_t k = 0; k < schema.columns.size(); k++)
+        fColumns[k].column = schema.columns[k];
+    Clear();
+}
+
+
+
+void MyColumnarChunk::Add(const MyEventRecord &record)
+{
+    for(auto &column : fColumns)
+    {
+        size_t slot = column.column.slot;
+        switch(column.column.type)
+        {
+            case MyColumnType::Int:
+                AppendValue<std::int32_t>(column.values, record.ints[slot]);
+                break;
+            case MyColumnType::Double:
+                AppendValue<G4double>(column.values, record.doubles[slot]);
+                break;
+            case MyColumnType::Float:
+                AppendValue<G4float>(column.values, record.doubles[slot]);
+                break;
+            case MyColumnType::IntVector:
+                AppendValues<std::int32_t>(column.values, *record.intVectors[slot]);
+                break;
+            case MyColumnType::ByteVector:
+                AppendValues<std::uint8_t>(column.values, *record.intVectors[slot]);
+                break;
+            case MyColumnType::DoubleVector:
+                AppendValues<G4double>(column.values, *record.doubleVectors[slot]);
+                break;
+            case MyColumnType::FloatVector:
+                AppendValues<G4float>(column.values, *record.doubleVectors[slot]);
+                break;
+        }
+
+        // The offsets start with a zero
+        if(MyColumnarIsArray(ColumnarType(column.column.type)))
+        {
+            if(column.offsets.empty()) column.offsets.push_back(0);
+            size_t size = column.column.type == MyColumnType::IntVector || column.column.type == MyColumnType::ByteVector ? record.intVectors[slot]->size() : record.doubleVectors[slot]->size();
+            column.offsets.push_back(column.offsets.back() + size);
+        }
+    }
+
+    fNEvents++;
+}
+
+
+
+void MyColumnarChunk::Clear()
+{
+    fNEvents = 0;
+    for(auto &column : fColumns)
+    {
+        column.offsets.clear();
+        column.values.clear();
+    }
+}
+
+
+
+void MyColumnarChunk::Serialize(std::vector<char> &bytes, G4bool compress) const
+{
+    size_t nSegments = 0;
+    for(const auto &column : fColumns)
+        nSegments += MyColumnarSegments(ColumnarType(column.column.type));
+    std::vector<MyColumnarSegment> segments;
+    segments.reserve(nSegments);
+
+    // Header and table of the segments, filled at the end
+    bytes.assign(sizeof(MyColumnarChunkHeader) + nSegments*sizeof(MyColumnarSegment), 0);
+
+    auto addSegment = [&](const void *data, size_t size, G4bool isInt)
+    {
+        Align(bytes);
+        MyColumnarSegment segment = {bytes.size(), 0};
+        if(compress && isInt)
+            AppendDeltaVarint(bytes, static_cast<const std::int32_t*>(data), size/sizeof(std::int32_t));
+        else
+            AppendRaw(bytes, data, size);
+        segment.size = bytes.size() - segment.offset;
+        segments.push_back(segment);
+    };
+
+    // An empty chunk has no offsets at all
+    const std::int32_t zeroOffset = 0;
+
+    for(const auto &column : fColumns)
+    {
+        MyColumnType type = column.column.type;
+        if(MyColumnarIsArray(ColumnarType(type)))
+        {
+            if(column.offsets.empty())
+                addSegment(&zeroOffset, sizeof(zeroOffset), true);
+            else
+                addSegment(column.offsets.data(), column.offsets.size()*sizeof(std::int32_t), true);
+        }
+        addSegment(column.values.data(), column.values.size(), type == MyColumnType::Int || type == MyColumnType::IntVector);
+    }
+    Align(bytes);
+
+    MyColumnarChunkHeader header = {columnarChunkMagic, static_cast<std::uint32_t>(fNEvents), bytes.size()};
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + sizeof(header), segments.data(), nSegments*sizeof(MyColumnarSegment));
+}
+
+
+
+MyColumnarWriter::~MyColumnarWriter()
+{
+    if(IsOpen())
+        Close();
+}
+
+
+
+MyColumnarWriter *MyColumnarWriter::Instance()
+{
+    static MyColumnarWriter instance;
+    return &instance;
+}
+
+
+
+G4bool MyColumnarWriter::Open(const G4String &fileName, G4bool compress, const MyOutputSchema &schema)
+{
+    MyColumnarSchemaInfo schemaInfo;
+    std::memset(&schemaInfo, 0, sizeof(schemaInfo));
+    std::strncpy(schemaInfo.name, schema.name.c_str(), sizeof(schemaInfo.name) - 1);
+    schemaInfo.version = NT::schemaVersion;
+
+    std::vector<MyColumnarColumn> columns(schema.columns.size());
+    for(size_t k = 0; k < schema.columns.size(); k++)
+    {
+        std::memset(&columns[k], 0, sizeof(MyColumnarColumn));
+        std::strncpy(columns[k].name, schema.columns[k].GetName(), sizeof(columns[k].name) - 1);
+        columns[k].type = ColumnarType(schema.columns[k].type);
+    }
+
+    return Open(fileName, compress ? columnarFlagDeltaVarint : 0, schemaInfo, columns);
+}
+
+
+
+G4bool MyColumnarWriter::Open(const G4String &fileName, std::uint32_t flags, const MyColumnarSchemaInfo &schema, const std::vector<MyColumnarColumn> &columns)
+{
+    G4AutoLock lock(&columnarWriterMutex);
+
+    fFile.open(fileName, std::ios::binary | std::ios::trunc);
+    if(!fFile.is_open())
+    {
+        G4cerr << "Can't open the file " << fileName << "!" << G4endl;
+        return false;
+    }
+
+    fCompress = flags & columnarFlagDeltaVarint;
+    fSchema = schema;
+    fNEvents = 0;
+    fIndex.clear();
+
+    // The header is completed at Close(): a file not closed has no index
+    std::memset(&fHeader, 0, sizeof(fHeader));
+    std::memcpy(fHeader.magic, "LYSOCOLS", 8);
+    fHeader.version = columnarFormatVersion;
+    fHeader.headerSize = sizeof(MyColumnarFileHeader) + sizeof(MyColumnarSchemaInfo);
+    fHeader.nColumns = columns.size();
+    fHeader.flags = flags;
+    fHeader.columnsOffset = fHeader.headerSize;
+
+    fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+    fFile.write(reinterpret_cast<const char*>(&fSchema), sizeof(fSchema));
+    fFile.write(reinterpret_cast<const char*>(columns.data()), columns.size()*sizeof(MyColumnarColumn));
+    fOffset = fHeader.headerSize + columns.size()*sizeof(MyColumnarColumn);
+
+    return true;
+}
+
+
+
+void MyColumnarWriter::Append(const MyColumnarChunk &chunk)
+{
+    if(!chunk.GetNEvents())
+        return;
+
+    // Serialized by the calling thread, outside the lock
+    thread_local std::vector<char> bytes;
+    chunk.Serialize(bytes, fCompress);
+
+    AppendBytes(bytes.data(), bytes.size(), chunk.GetNEvents());
+}
+
+
+
+void MyColumnarWriter::AppendBytes(const char *bytes, std::uint64_t size, std::uint32_t nEvents)
+{
+    G4AutoLock lock(&columnarWriterMutex);
+
+    if(!fFile.is_open())
+        return;
+
+    fIndex.push_back({fOffset, fNEvents});
+    fFile.write(bytes, size);
+    fOffset += size;
+    fNEvents += nEvents;
+}
+
+
+
+void MyColumnarWriter::Close()
+{
+    G4AutoLock lock(&columnarWriterMutex);
+
+    if(!fFile.is_open())
+        return;
+
+    fHeader.indexOffset = fOffset;
+    fHeader.nChunks = fIndex.size();
+    fHeader.nEvents = fNEvents;
+    fHeader.fileSize = fOffset + fIndex.size()*sizeof(MyColumnarIndexEntry);
+
+    fFile.write(reinterpret_cast<const char*>(fIndex.data()), fIndex.size()*sizeof(MyColumnarIndexEntry));
+    fFile.seekp(0);
+    fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+    fFile.close();
+}
+
+
+
+G4bool MyColumnarWriter::Concatenate(const std::vector<G4String> &inputFiles, const G4String &outputFile)
+{
+    MyColumnarWriter writer;
+    std::vector<MyColumnarColumn> firstColumns;
+
+    try
+    {
+        for(size_t i = 0; i < inputFiles.size(); i++)
+        {
+            MyColumnarReader reader(inputFiles[i]);
+
+            std::vector<MyColumnarColumn> columns(reader.GetNColumns());
+            for(size_t k = 0; k < columns.size(); k++)
+                columns[k] = reader.GetColumn(k);
+
+            MyColumnarSchemaInfo schema;
+            std::memset(&schema, 0, sizeof(schema));
+            std::strncpy(schema.name, reader.GetSchemaName().c_str(), sizeof(schema.name) - 1);
+            schema.version = reader.GetSchemaVersion();
+
+            // The schema of the first file
+            if(i == 0)
+            {
+                if(!writer.Open(outputFile, reader.GetFlags(), schema, columns))
+                    return false;
+                firstColumns = columns;
+            }
+
+            G4bool sameSchema = reader.GetFlags() == writer.fHeader.flags && columns.size() == writer.fHeader.nColumns && schema.version == writer.fSchema.version && std::strncmp(schema.name, writer.fSchema.name, sizeof(schema.name)) == 0;
+            for(size_t k = 0; sameSchema && k < columns.size(); k++)
+            {
+                sameSchema = std::strncmp(columns[k].name, firstColumns[k].name, sizeof(columns[k].name)) == 0 && columns[k].type == firstColumns[k].type;
+            }
+            if(!sameSchema)
+            {
+                G4cerr << "Error: " << inputFiles[i] << " has a different schema or compression." << G4endl;
+                return false;
+            }
+
+            for(size_t c = 0; c < reader.GetNChunks(); c++)
+            {
+                MySpan<char> chunk = reader.GetRawChunk(c);
+                writer.AppendBytes(chunk.data(), chunk.size(), reinterpret_cast<const MyColumnarChunkHeader*>(chunk.data())->nEvents);
+            }
+        }
+    }
+    catch(const std::runtime_error &error)
+    {
+        G4cerr << "Error: " << error.what() << G4endl;
+        return false;
+    }
+
+    writer.Close();
+    G4cout << "Merged " << inputFiles.size() << " files into " << outputFile << ": " << writer.fNEvents << " events." << G4endl;
+
+    return true;
+}
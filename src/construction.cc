@@ -17,6 +17,11 @@ MyDetectorConstruction::MyDetectorConstruction()
     fIsEndcap = true;
     fIsASiPM = false;
     fIsCosmicRaysDetectors = true;
+    fIsFastLight = false;
+    fFastLightMap = "lightmap.bin";
+    fIsPDEPrescaling = false;
+    fReadoutWindow = 0.;
+    fReadoutLimits = nullptr;
 
     DefineMaterials();
 }
@@ -74,7 +79,8 @@ void MyDetectorConstruction::DefineMaterials()
     mptLYSO->AddProperty("SCINTILLATIONCOMPONENT1", emissionEnergies, LYSO_SCINTILLATIONCOMPONENT1);
     mptLYSO->AddProperty("RINDEX", Energies, LYSO_RINDEX);
     mptLYSO->AddProperty("ABSLENGTH", Energies, LYSO_ABSLENGTH);
-    mptLYSO->AddConstProperty("SCINTILLATIONYIELD", 29000./MeV);
+    fNominalYieldLYSO = 29000./MeV;
+    mptLYSO->AddConstProperty("SCINTILLATIONYIELD", fNominalYieldLYSO);
     mptLYSO->AddConstProperty("RESOLUTIONSCALE", 1.0);
     mptLYSO->AddConstProperty("SCINTILLATIONTIMECONSTANT1", 42.*ns);
     mptLYSO->AddConstProperty("SCINTILLATIONYIELD1", 1.);  
@@ -194,8 +200,16 @@ G4VPhysicalVolume *MyDetectorConstruction::Construct()
     logicScintillator = new G4LogicalVolume(solidScintillator, fLYSO, "logicScintillator");
     G4VPhysicalVolume *physScintillator = new G4PVPlacement(0, G4ThreeVector(GS::xScintillator, GS::yScintillator, GS::zScintillator), logicScintillator, "physScintillator", logicWorld, false, 0, true);
 
-    // Assign the logic scoring volume to the crystal
-    fScoringVolume = logicScintillator;
+    // The materials are defined before the macros are read: the yield is
+    // (re)scaled here, according to the current settings
+    fLYSO->GetMaterialPropertiesTable()->AddConstProperty("SCINTILLATIONYIELD", fNominalYieldLYSO*GetYieldScale());
+
+    // The crystal is the envelope of the fast light simulation
+    if(fIsFastLight)
+    {
+        G4Region *crystalRegion = new G4Region("CrystalRegion");
+        crystalRegion->AddRootLogicalVolume(logicScintillator);
+    }
     
     // Construct a coating for the crystal and the lightguide (if present)
     G4Tubs *solidCoating = new G4Tubs("solidCoating", (GS::radiusScintillator + GS::coating_space), (GS::radiusScintillator + GS::coating_space + GS::coating_thickness), GS::halfheightScintillator+2*(GS::halfheightLightGuide*fIsLightGuide), 0.*deg, 360.*deg);
@@ -226,21 +240,8 @@ G4VPhysicalVolume *MyDetectorConstruction::Construct()
     G4VPhysicalVolume *physFrontPackageSiPM[GS::nOfSiPMs];
     G4VPhysicalVolume *physBackPackageSiPM[GS::nOfSiPMs];
 
-    G4int indexDetector = 0;
-    for(G4int i = 0; i < GS::nRowsSiPMs; i++)
-    {
-        for(G4int j = 0; j < GS::nColsSiPMs; j++)
-        {
-            if(GS::panelSiPMs[i][j])
-            {
-                PositionSiPMs(physFrontPackageSiPM[indexDetector], physBackPackageSiPM[indexDetector], i, j, indexDetector);
-                indexDetector++;
-            }
-        }
-    }
-
-    // Assign the logic trigger volume to the Si layer
-    fDecayTriggerVolume = logicDetector;
+    for(G4int ch = 0; ch < GS::nOfSiPMs; ch++)
+        PositionSiPMs(physFrontPackageSiPM[ch], physBackPackageSiPM[ch], ch);
 
     // Construct dummy cosmic rays detectors
     if(fIsCosmicRaysDetectors)
@@ -249,6 +250,9 @@ G4VPhysicalVolume *MyDetectorConstruction::Construct()
     // Add visualization attributes
     DefineVisAttributes();
 
+    // Apply the readout window
+    SetReadoutLimits();
+
     // Always return physWorld
     return physWorld;
 }
@@ -262,11 +266,47 @@ void MyDetectorConstruction::ConstructSDandField()
     
     if(!sensDet)
     {
-        sensDet = new MySensitiveDetector("SensitiveDetector", "HitsCollection");
+        sensDet = new MySensitiveDetector("SensitiveDetector", GetYieldScale());
         G4SDManager::GetSDMpointer()->AddNewDetector(sensDet);
     }
 
     SetSensitiveDetector(logicDetector, sensDet);
+
+    // Scoring SDs of the crystal and of the cosmic rays detectors. Their
+    // filter rejects the optical photons
+    if(!fIsASiPM)
+    {
+        G4VSensitiveDetector *crystalSD = G4SDManager::GetSDMpointer()->FindSensitiveDetector("CrystalSD", false);
+        if(!crystalSD)
+        {
+            crystalSD = new MyCrystalSD("CrystalSD");
+            crystalSD->SetFilter(new MyNonOpticalFilter("CrystalFilter"));
+            G4SDManager::GetSDMpointer()->AddNewDetector(crystalSD);
+        }
+        SetSensitiveDetector(logicScintillator, crystalSD);
+    }
+
+    if(!fIsASiPM && fIsCosmicRaysDetectors)
+    {
+        G4VSensitiveDetector *cosmicTriggerSD = G4SDManager::GetSDMpointer()->FindSensitiveDetector("CosmicTriggerSD", false);
+        if(!cosmicTriggerSD)
+        {
+            cosmicTriggerSD = new MyCosmicTriggerSD("CosmicTriggerSD");
+            cosmicTriggerSD->SetFilter(new MyNonOpticalFilter("CosmicTriggerFilter"));
+            G4SDManager::GetSDMpointer()->AddNewDetector(cosmicTriggerSD);
+        }
+        SetSensitiveDetector(logicCosmicRaysDetector, cosmicTriggerSD);
+    }
+
+    // Attach the fast light model to the crystal (one per thread)
+    if(fIsFastLight)
+    {
+        // The map is mapped in memory once and shared by all the threads
+        std::shared_ptr<const MyLightMap> lightMap = MyLightMap::Open(fFastLightMap, GetLightMapGeometry());
+
+        G4Region *crystalRegion = G4RegionStore::GetInstance()->GetRegion("CrystalRegion");
+        new MyFastLightModel("FastLightModel", crystalRegion, sensDet, lightMap, GetYieldScale());
+    }
 }
 
 
@@ -374,19 +414,21 @@ void MyDetectorConstruction::ConstructEndcap()
 
 
 
-void MyDetectorConstruction::PositionSiPMs(G4VPhysicalVolume *physFrontSiPM, G4VPhysicalVolume *physBackSiPM, G4int row, G4int col, G4int index)
+void MyDetectorConstruction::PositionSiPMs(G4VPhysicalVolume *physFrontSiPM, G4VPhysicalVolume *physBackSiPM, G4int ch)
 {
-    G4double startX = -GS::halfXsidePackageSiPM*(GS::nColsSiPMs -1);
-    G4double startY = GS::halfYsidePackageSiPM*(GS::nRowsSiPMs - 1);
+    // The center of the package is taken from the channel map
+    G4double x = GS::sipmChannels[ch].x;
+    G4double y = GS::sipmChannels[ch].y;
 
-    // Place the packages. When in back face, need to rotate them of 180°
-    physFrontSiPM = new G4PVPlacement(0, G4ThreeVector(startX + col*2*GS::halfXsidePackageSiPM, startY - row*2*GS::halfYsidePackageSiPM, GS::zFrontFaceScintillator-(2*GS::halfheightGrease*fIsGrease)-2*(GS::halfheightLightGuide*fIsLightGuide)-(2*GS::halfheightGrease*fIsLightGuide*fIsGrease)-GS::halfZsidePackageSiPM), logicPackageSiPM, "physFrontPackageSiPM", logicWorld, false, index, true);
+    // Place the packages. The copy number encodes the face and the channel.
+    // When in back face, need to rotate them of 180°
+    physFrontSiPM = new G4PVPlacement(0, G4ThreeVector(x, y, GS::zFrontFaceScintillator-(2*GS::halfheightGrease*fIsGrease)-2*(GS::halfheightLightGuide*fIsLightGuide)-(2*GS::halfheightGrease*fIsLightGuide*fIsGrease)-GS::halfZsidePackageSiPM), logicPackageSiPM, "physFrontPackageSiPM", logicWorld, false, GS::EncodeSiPMCopyNo(0, ch), true);
     
     G4Rotate3D rotXBackDet(180*deg, G4ThreeVector(1, 0, 0));
-    G4Translate3D transBackDet(G4ThreeVector(startX + col*2*GS::halfXsidePackageSiPM, startY - row*2*GS::halfYsidePackageSiPM, GS::zBackFaceScintillator+(2*GS::halfheightGrease*fIsGrease)+2*(GS::halfheightLightGuide*fIsLightGuide)+(2*GS::halfheightGrease*fIsLightGuide*fIsGrease)+GS::halfZsidePackageSiPM));
+    G4Translate3D transBackDet(G4ThreeVector(x, y, GS::zBackFaceScintillator+(2*GS::halfheightGrease*fIsGrease)+2*(GS::halfheightLightGuide*fIsLightGuide)+(2*GS::halfheightGrease*fIsLightGuide*fIsGrease)+GS::halfZsidePackageSiPM));
     G4Transform3D transformBackDet = (transBackDet)*(rotXBackDet);
                 
-    physBackSiPM = new G4PVPlacement(transformBackDet, logicPackageSiPM, "physBackPackageSiPM", logicWorld, false, index, true);
+    physBackSiPM = new G4PVPlacement(transformBackDet, logicPackageSiPM, "physBackPackageSiPM", logicWorld, false, GS::EncodeSiPMCopyNo(1, ch), true);
 }
 
 
@@ -476,6 +518,42 @@ void MyDetectorConstruction::DefineCommands()
     fMessenger->DeclareProperty("MaterialOfLightGuide", nLightGuideMat, "Set the material of light guide: 1 = Plexiglass, 2 = Sapphire");
     fMessenger->DeclareProperty("isASiPM", fIsASiPM, "Set if construct only a SiPM");
     fMessenger->DeclareProperty("isCosmicRaysDetectors", fIsCosmicRaysDetectors, "Set if the two cosmic rays detector are present");
+    fMessenger->DeclareProperty("isFastLight", fIsFastLight, "Set if the optical photons emitted in the crystal are sampled from a light map instead of being tracked");
+    fMessenger->DeclareProperty("FastLightMap", fFastLightMap, "Set the light map file used by the fast light simulation");
+    fMessenger->DeclareProperty("isPDEPrescaling", fIsPDEPrescaling, "Set if the scintillation yield is scaled by the peak PDE and the hits are accepted with the relative PDE");
+
+    // Define my UD-messenger for the readout
+    fReadoutMessenger = new G4GenericMessenger(this, "/MC_LYSO/readout/", "Readout settings");
+    fReadoutMessenger->DeclareMethodWithUnit("window", "ns", &MyDetectorConstruction::SetReadoutWindow, "Set the readout window: optical photons and hits later than it are dropped (0 = no window), before /run/initialize").SetStates(G4State_PreInit).SetToBeBroadcasted(false);
+}
+
+
+
+void MyDetectorConstruction::SetReadoutLimits()
+{
+    // Without a window there's no G4UserSpecialCuts to read them
+    if(!IsReadoutWindow())
+        return;
+
+    if(!fReadoutLimits)
+        fReadoutLimits = new G4UserLimits();
+    fReadoutLimits->SetUserMaxTime(GetReadoutWindow());
+
+    // G4UserSpecialCuts reads the limits of the current volume: all of them
+    // must have it. Only the optical photons have that process
+    for(G4LogicalVolume *volume : *G4LogicalVolumeStore::GetInstance())
+    {
+        if(!volume->GetUserLimits())
+            volume->SetUserLimits(fReadoutLimits);
+    }
+}
+
+
+
+void MyDetectorConstruction::SetReadoutWindow(G4double window)
+{
+    // Applied by Construct() and by MyPhysicsList::ConstructProcess()
+    fReadoutWindow = window;
 }
 
 
@@ -529,6 +607,4 @@ void MyDetectorConstruction::ConstructCosmicRaysDetectors()
     logicCosmicRaysDetector = new G4LogicalVolume(solidCosmicRaysDetector, fAir, "logicCosmicRaysDetector");
     G4VPhysicalVolume *physUpCosmicRaysDetector = new G4PVPlacement(0, G4ThreeVector(GS::xCosmicRayDetector, GS::yCosmicRayDetector, GS::zCosmicRayDetector), logicCosmicRaysDetector, "physUpCosmicRaysDetector", logicWorld, false, 0, true);
     G4VPhysicalVolume *physBottomCosmicRaysDetector = new G4PVPlacement(0, G4ThreeVector(GS::xCosmicRayDetector, -GS::yCosmicRayDetector, GS::zCosmicRayDetector), logicCosmicRaysDetector, "physBottomCosmicRaysDetector", logicWorld, false, 1, true);
-
-    fCosmicTriggerVolume = logicCosmicRaysDetector;
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+/**
+ * @file cosmicrays.cc
+ * @brief Definition of the class @ref MyCosmicRaySampler
+ */
+#include "cosmicrays.hh"
+
+#include <cmath>
+#include <vector>
+
+#include "Randomize.hh"
+
+namespace
+{
+    // Order of the Gauss-Legendre quadrature, per axis
+    constexpr G4int nNodes = 32;
+
+    // Nodes and weights of the Gauss-Legendre quadrature on [0, length]
+    void GaussLegendre(G4double length, std::vector<G4double> &nodes, std::vector<G4double> &weights)
+    {
+        nodes.resize(nNodes);
+        weights.resize(nNodes);
+        for(G4int i = 0; i < (nNodes + 1)/2; i++)
+        {
+            // Newton on P_n, from the Chebyshev guess of the root
+            G4double x = std::cos(CLHEP::pi*(i + 0.75)/(nNodes + 0.5));
+            G4double derivative = 1.;
+            for(G4int iter = 0; iter < 100; iter++)
+            {
+                G4double p0 = 1., p1 = 0.;
+                for(G4int k = 1; k <= nNodes; k++)
+                {
+                    G4double p2 = p1;
+                    p1 = p0;
+                    p0 = ((2.*k - 1.)*x*p1 - (k - 1.)*p2)/k;
+                }
+                derivative = nNodes*(x*p0 - p1)/(x*x - 1.);
+                G4double step = p0/derivative;
+                x -= step;
+                if(std::abs(step) < 1e-15)
+                    break;
+            }
+            G4double weight = 2./((1. - x*x)*derivative*derivative);
+
+            nodes[i] = 0.5*length*(1. - x);
+            nodes[nNodes - 1 - i] = 0.5*length*(1. + x);
+            weights[i] = weights[nNodes - 1 - i] = 0.5*length*weight;
+        }
+    }
+}
+
+
+
+G4double MyCosmicRaySampler::SampleEnergy()
+{
+    // Areas of the flat part and of the power law
+    static const G4double flat = std::pow(breakEnergy, 1. - spectralIndex);
+    static const G4double tail = (flat - std::pow(maxEnergy, 1. - spectralIndex))/(spectralIndex - 1.);
+
+    G4double area = G4UniformRand()*(flat + tail);
+    if(area < flat)
+        return area*std::pow(breakEnergy, spectralIndex);
+
+    return std::pow(flat - (spectralIndex - 1.)*(area - flat), 1./(1. - spectralIndex));
+}
+
+
+
+G4double MyCosmicRaySampler::SampleCosTheta()
+{
+    return std::cbrt(G4UniformRand());
+}
+
+
+
+G4ThreeVector MyCosmicRaySampler::SampleDirection(G4double cosTheta)
+{
+    G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+    G4double phi = CLHEP::twopi*G4UniformRand();
+
+    // Remember the axis orientation: Y is vertical
+    return G4ThreeVector(sinTheta*std::sin(phi), -cosTheta, sinTheta*std::cos(phi));
+}
+
+
+
+void MyCosmicRaySampler::SampleTriggeredTrack(G4ThreeVector &position, G4ThreeVector &direction)
+{
+    G4double yTop = GS::yCosmicRayDetector + GS::halfYsideCosmicRayDetector;
+    for(;;)
+    {
+        G4double x0 = GS::xCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
+        G4double z0 = GS::zCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
+        G4double x1 = GS::xCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
+        G4double z1 = GS::zCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
+
+        G4ThreeVector track(x1 - x0, -height, z1 - z0);
+        G4double cosTheta = height/track.mag();
+        G4double cos2 = cosTheta*cosTheta;
+        if(G4UniformRand() < cos2*cos2*cosTheta)
+        {
+            position = G4ThreeVector(x0, yTop, z0);
+            direction = track.unit();
+            return;
+        }
+    }
+}
+
+
+
+G4double MyCosmicRaySampler::GetAcceptance()
+{
+    G4double area = 4.*GS::halfZXsideCosmicRayDetector*GS::halfZXsideCosmicRayDetector;
+    return GetEtendue()/(area*CLHEP::twopi/3.);
+}
+
+
+
+G4double MyCosmicRaySampler::GetEtendue()
+{
+    static const G4double etendue = IntegrateOverPaddles(5)/(height*height);
+    return etendue;
+}
+
+
+
+G4double MyCosmicRaySampler::GetSamplingEfficiency()
+{
+    G4double area = 4.*GS::halfZXsideCosmicRayDetector*GS::halfZXsideCosmicRayDetector;
+    return IntegrateOverPaddles(5)/(area*area);
+}
+
+
+
+G4double MyCosmicRaySampler::IntegrateOverPaddles(G4int n)
+{
+    // The separations of two uniform points of a side 2a are distributed as
+    // 2a - |u|: the integral over the pairs is the one over the separations,
+    // four times the quadrant u, v > 0
+    G4double side = 2.*GS::halfZXsideCosmicRayDetector;
+    std::vector<G4double> nodes, weights;
+    GaussLegendre(side, nodes, weights);
+
+    G4double integral = 0.;
+    for(G4int i = 0; i < nNodes; i++)
+        for(G4int j = 0; j < nNodes; j++)
+        {
+            G4double cosTheta = height/std::sqrt(height*height + nodes[i]*nodes[i] + nodes[j]*nodes[j]);
+            integral += weights[i]*weights[j]*(side - nodes[i])*(side - nodes[j])*std::pow(cosTheta, n);
+        }
+
+    return 4.*integral;
+}
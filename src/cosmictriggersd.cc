@@ -0,0 +1,39 @@
+/**
+ * @file cosmictriggersd.cc
+ * @brief Definition of the class @ref MyCosmicTriggerSD
+ */
+#include "cosmictriggersd.hh"
+
+#include "event.hh"
+
+MyCosmicTriggerSD::MyCosmicTriggerSD(G4String name) : G4VSensitiveDetector(name), fEventAction(nullptr)
+{}
+
+
+
+void MyCosmicTriggerSD::Initialize(G4HCofThisEvent *hce)
+{
+    fEventAction = static_cast<MyEventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+}
+
+
+
+G4bool MyCosmicTriggerSD::ProcessHits(G4Step *aStep, G4TouchableHistory *ROhist)
+{
+    // Should see this condition. Now I'm selecting only primary muon
+    if(aStep->GetTrack()->GetTrackID() != 1)
+        return false;
+
+    // Up (0) or Bottom (1) detector
+    G4bool isUpOrBottom = aStep->GetPreStepPoint()->GetTouchable()->GetCopyNumber();
+
+    if(!isUpOrBottom) // up
+        fEventAction->SetCosmicTriggerUp(true);
+    else // bottom
+    {
+        fEventAction->SetCosmicTriggerBottom(true);
+        aStep->GetTrack()->SetTrackStatus(fStopAndKill);
+    }
+
+    return true;
+}
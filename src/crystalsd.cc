@@ -0,0 +1,44 @@
+/**
+ * @file crystalsd.cc
+ * @brief Definition of the class @ref MyCrystalSD
+ */
+#include "crystalsd.hh"
+
+#include "event.hh"
+
+MyCrystalSD::MyCrystalSD(G4String name) : G4VSensitiveDetector(name), fEventAction(nullptr)
+{}
+
+
+
+void MyCrystalSD::Initialize(G4HCofThisEvent *hce)
+{
+    fEventAction = static_cast<MyEventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+}
+
+
+
+G4bool MyCrystalSD::ProcessHits(G4Step *aStep, G4TouchableHistory *ROhist)
+{
+    const G4StepPoint *preStepPoint = aStep->GetPreStepPoint();
+    const G4StepPoint *postStepPoint = aStep->GetPostStepPoint();
+
+    // Store time and position of arrival of primary gamma (or daughters)
+    if(preStepPoint->GetStepStatus() == fGeomBoundary)
+        fEventAction->SetArrivalandFirstInteraction(preStepPoint->GetGlobalTime(), preStepPoint->GetPosition(), postStepPoint->GetGlobalTime(), postStepPoint->GetPosition());
+
+    // Sum the energy deposited in the step
+    G4double edep = aStep->GetTotalEnergyDeposit();
+    fEventAction->AddEdep(edep);
+
+    // Check if it is the maximum deposition of energy per unit length.
+    // If yes it will be stored with its position.
+    G4double dx = aStep->GetStepLength();
+    if(dx == 0)
+        return false;
+
+    G4ThreeVector maxedeppos = (preStepPoint->GetPosition() + postStepPoint->GetPosition())/2;
+    fEventAction->SetMaxEdep(edep/dx, maxedeppos);
+
+    return true;
+}
@@ -4,18 +4,22 @@
  */
 #include "detector.hh"
 
-MySensitiveDetector::MySensitiveDetector(G4String name, G4String hitsCollectionName) : G4VSensitiveDetector(name)
+#include "G4EventManager.hh"
+
+#include "construction.hh"
+#include "event.hh"
+
+MySensitiveDetector::MySensitiveDetector(G4String name, G4double yieldScale) : G4VSensitiveDetector(name), fHitBuffer(nullptr), fEventAction(nullptr), fReadoutWindow(DBL_MAX), fIsSiTrigger(false), fYieldScale(yieldScale)
 {
-    fEfficiencySetting = fIsNominalEfficiency;
+    fEfficiencySetting = efficiencySetting;
 
-    // Add the collection name to collectionName vector
-    collectionName.insert(hitsCollectionName);
+    // The nominal curve is also the reference of the random efficiencies
+    fPDE = new G4PhysicsFreeVector(GS::pdeEnergies.data(), GS::pdeValues.data(), GS::pdeValues.size());
 
     switch(fEfficiencySetting)
     {
         case fIsNominalEfficiency:
         default:
-            fPDE = new G4PhysicsFreeVector(GS::pdeEnergies, GS::pdeValues);
             break;
         case fIsFixedEfficiency:
             fFixedEfficiency = GS::meanPDE;
@@ -27,17 +31,21 @@ MySensitiveDetector::MySensitiveDetector(G4String name, G4String hitsCollectionN
             GetEfficienciesFromFile();
             break;
     }
+
+    if(fYieldScale < 1.)
+        CheckEfficiencies();
 }
 
 
 
 void MySensitiveDetector::Initialize(G4HCofThisEvent *hce)
 {
-    // Add fHitsCollection to the GHCofThisEvent container
-    fHitsCollection = new MyHitsCollection(SensitiveDetectorName, collectionName[0]);
-    G4int hcID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+    // The hits go in the buffer of the event action, cleared by it
+    fEventAction = static_cast<MyEventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+    fHitBuffer = &fEventAction->fHits;
 
-    hce->AddHitsCollection(hcID, fHitsCollection);
+    // The window of the construction, set before the initialization
+    fReadoutWindow = static_cast<const MyDetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction())->GetReadoutWindow();
 }
 
 
@@ -48,55 +56,74 @@ G4bool MySensitiveDetector::ProcessHits(G4Step *aStep, G4TouchableHistory *ROhis
     G4Track *track = aStep->GetTrack();
     G4StepPoint *preStepPoint = aStep->GetPreStepPoint();
     const G4VTouchable *touchable = preStepPoint->GetTouchable();
+
+    // Only optical photons are detected. In the Si trigger runs, the
+    // electrons crossing the trigger SiPM (Front-57) fire the trigger
+    if(track->GetParticleDefinition() != G4OpticalPhoton::OpticalPhotonDefinition())
+    {
+        if(fIsSiTrigger && track->GetParticleDefinition()->GetPDGEncoding() == 11 && touchable->GetCopyNumber(2) == GS::EncodeSiPMCopyNo(0, 57))
+            fEventAction->SetDecayTriggerSi(true);
+        return false;
+    }
+
     G4double phEnergy = preStepPoint->GetTotalEnergy();
 
+    // If the scintillation yield is pre-scaled, the scintillation photons
+    // have already passed the peak PDE: accept them with the relative one
+    G4double scale = 1.;
+    if(fYieldScale < 1.)
+    {
+        const G4VProcess *creator = track->GetCreatorProcess();
+        if(creator && creator->GetProcessName() == "Scintillation")
+            scale = fYieldScale;
+    }
+    G4double u = G4UniformRand()*scale;
+
     // Here's implemented the PDE
     switch(fEfficiencySetting)
     {
         case fIsNominalEfficiency:
-            if(G4UniformRand() > fPDE->Value(phEnergy)) return false;
+            if(u > fPDE->Value(phEnergy)) return false;
             break;
         case fIsFixedEfficiency:
-            if(G4UniformRand() > fFixedEfficiency) return false;
+            if(u > fFixedEfficiency) return false;
             break;
         case fIsRandomEfficiency:
         case fIsAssignedEfficiency:
-            G4int ch = touchable->GetCopyNumber(2);
-            G4bool isFront = (touchable->GetVolume(2)->GetTranslation().z() < GS::zScintillator);
-            if(isFront)
+            G4int copyNo = touchable->GetCopyNumber(2);
+            G4int ch = GS::GetSiPMChannel(copyNo);
+            if(GS::GetSiPMFace(copyNo) == 0)
             {
-                if(G4UniformRand() > fFrontEfficiency[ch]) return false;
+                if(u > fFrontEfficiency[ch]) return false;
             }
             else
             {
-                if(G4UniformRand() > fBackEfficiency[ch]) return false;
+                if(u > fBackEfficiency[ch]) return false;
             }
             break;
     }
 
-    // Save, stop and kill only optical photons
-    if(track->GetParticleDefinition()->GetPDGEncoding()==-22)
-        track->SetTrackStatus(fStopAndKill);
-    else
+    // Stop and kill the detected photon
+    track->SetTrackStatus(fStopAndKill);
+
+    // Store the hit. Face and channel are encoded in the copy number of the package
+    G4int copyNo = touchable->GetCopyNumber(2);
+    return InsertHit(preStepPoint->GetGlobalTime(), GS::GetSiPMFace(copyNo), GS::GetSiPMChannel(copyNo));
+}
+
+
+
+G4bool MySensitiveDetector::InsertHit(G4double time, G4int face, G4int ch)
+{
+    // Out of the readout window
+    if(time > fReadoutWindow)
+    {
+        fEventAction->AddLateHit();
         return false;
-    
-    
-    // Create a new MyHit object
-    MyHit *newHit = new MyHit();
-    
-    // Time of detection
-    newHit->SetDetectionTime(preStepPoint->GetGlobalTime());
-    
-    // Position of detector (Note that the position of the package is taken)
-    newHit->SetDetectorPosition(touchable->GetVolume(2)->GetTranslation());
-
-    // Channel of detector
-    newHit->SetDetectorChannel(touchable->GetCopyNumber(2));
-
-
-    // Insert the hit
-    fHitsCollection->insert(newHit);
-    
+    }
+
+    fHitBuffer->Add(face, ch, time);
+
     return true;
 }
 
@@ -174,4 +201,35 @@ void MySensitiveDetector::GetEfficienciesFromFile()
     file.close();
 
     G4cout << "\n Data read from random_efficiencies.txt successfully. \n" << G4endl;
-}
\ No newline at end of file
+}
+
+
+
+void MySensitiveDetector::CheckEfficiencies() const
+{
+    // With the pre-scaled yield no channel can detect more than fYieldScale
+    // of the scintillation photons
+    G4double maxEfficiency = 0.;
+    switch(fEfficiencySetting)
+    {
+        case fIsNominalEfficiency:
+        default:
+            maxEfficiency = fPDE->GetMaxValue();
+            break;
+        case fIsFixedEfficiency:
+            maxEfficiency = fFixedEfficiency;
+            break;
+        case fIsRandomEfficiency:
+        case fIsAssignedEfficiency:
+            for(G4int ch = 0; ch < GS::nOfSiPMs; ch++)
+                maxEfficiency = std::max({maxEfficiency, fFrontEfficiency[ch], fBackEfficiency[ch]});
+            break;
+    }
+
+    if(maxEfficiency > fYieldScale)
+    {
+        G4ExceptionDescription msg;
+        msg << "An efficiency (" << maxEfficiency << ") exceeds the scale factor of the scintillation yield (" << fYieldScale << "): the scintillation hits of that channel will be underestimated. Switch off the PDE pre-scaling!";
+        G4Exception("MySensitiveDetector::CheckEfficiencies()", "Detector001", JustWarning, msg);
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @file digitizer.cc
+ * @brief Definition of the class @ref MyDigitizer
+ */
+#include "digitizer.hh"
+
+#include <cmath>
+#include <algorithm>
+
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include "G4Poisson.hh"
+
+namespace
+{
+    // The tabulated pulse stops after so many fall times
+    constexpr G4double kernelTails = 8.;
+}
+
+
+
+MyDigitizer::MyDigitizer()
+{
+    fEnabled = false;
+    fSaveTraces = false;
+    fSamplingPeriod = 0.5*ns;
+    fNSamples = 400;
+    fWindowStart = 0.;
+    fRiseTime = 1.*ns;
+    fFallTime = 20.*ns;
+    fDarkRate = 100.*kilohertz;
+    fCrosstalk = 0.1;
+    fThreshold = 0.5;
+    fIsTouched.assign(nChannels, false);
+
+    // Define my UD-messenger for the digitizer
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/digitizer/", "Settings of the SiPM digitizer");
+    fMessenger->DeclareProperty("enable", fEnabled, "Digitize the SiPMs: the output gets charges and leading-edge times instead of the photon lists");
+    fMessenger->DeclareProperty("saveTraces", fSaveTraces, "Write the sampled waveforms of every channel too");
+    fMessenger->DeclarePropertyWithUnit("samplingPeriod", "ns", fSamplingPeriod, "Set the sampling period of the waveforms");
+    fMessenger->DeclareProperty("nSamples", fNSamples, "Set the number of samples of the waveforms").SetParameterRange("nSamples>0");
+    fMessenger->DeclarePropertyWithUnit("windowStart", "ns", fWindowStart, "Set the time of the first sample");
+    fMessenger->DeclarePropertyWithUnit("riseTime", "ns", fRiseTime, "Set the rise time constant of the SPE pulse (0 = instantaneous)");
+    fMessenger->DeclarePropertyWithUnit("fallTime", "ns", fFallTime, "Set the fall time constant of the SPE pulse");
+    fMessenger->DeclarePropertyWithUnit("darkRate", "kHz", fDarkRate, "Set the dark count rate of a SiPM");
+    fMessenger->DeclareProperty("crosstalk", fCrosstalk, "Set the probability that an avalanche triggers another one").SetParameterRange("crosstalk>=0 && crosstalk<1");
+    fMessenger->DeclareProperty("threshold", fThreshold, "Set the threshold of the leading-edge time, in p.e.").SetParameterRange("threshold>0");
+}
+
+
+
+MyDigitizer::~MyDigitizer()
+{
+    delete fMessenger;
+}
+
+
+
+void MyDigitizer::Configure()
+{
+    if(fSamplingPeriod == fKernelPeriod && fRiseTime == fKernelRise && fFallTime == fKernelFall && fNSamples == fKernelSamples)
+        return;
+
+    if(fSamplingPeriod <= 0. || fFallTime <= 0. || fRiseTime < 0. || fRiseTime >= fFallTime)
+    {
+        G4Exception("MyDigitizer::Configure()", "Digitizer001", JustWarning, "The sampling period and the fall time must be positive, the rise time shorter than the fall time: the default ones are used");
+        fSamplingPeriod = 0.5*ns;
+        fRiseTime = 1.*ns;
+        fFallTime = 20.*ns;
+    }
+
+    fKernelPeriod = fSamplingPeriod;
+    fKernelRise = fRiseTime;
+    fKernelFall = fFallTime;
+    fKernelSamples = fNSamples;
+
+    // Double exponential, normalized to its peak
+    auto pulse = [this](G4double t)
+    {
+        if(t < 0.)
+            return 0.;
+        return fRiseTime > 0. ? std::exp(-t/fFallTime) - std::exp(-t/fRiseTime) : std::exp(-t/fFallTime);
+    };
+    G4double peakTime = fRiseTime > 0. ? fRiseTime*fFallTime/(fFallTime - fRiseTime)*std::log(fFallTime/fRiseTime) : 0.;
+    G4double peak = pulse(peakTime);
+
+    // Phase j is a pulse starting j/nPhases of a sample after the sample 0
+    fKernelLength = static_cast<G4int>(std::ceil((fRiseTime + kernelTails*fFallTime)/fSamplingPeriod)) + 1;
+    fKernel.assign(static_cast<size_t>(nPhases)*fKernelLength, 0.);
+    for(G4int j = 0; j < nPhases; j++)
+        for(G4int m = 0; m < fKernelLength; m++)
+            fKernel[j*fKernelLength + m] = pulse((m - static_cast<G4double>(j)/nPhases)*fSamplingPeriod)/peak;
+
+    fPulseArea = 0.;
+    for(G4int m = 0; m < fKernelLength; m++)
+        fPulseArea += fKernel[m];
+
+    fWaveforms.assign(static_cast<size_t>(nChannels)*fNSamples, 0.);
+    fTouched.clear();
+    fIsTouched.assign(nChannels, false);
+}
+
+
+
+void MyDigitizer::Digitize(const MyHitBuffer &hits)
+{
+    Configure();
+
+    // Photons, with their crosstalk
+    for(G4int face = 0; face < 2; face++)
+        for(G4int i = 0; i < hits.GetNHits(face); i++)
+            AddPulse(face*GS::nOfSiPMs + hits.fChannel[face][i], hits.fTime[face][i], SampleAvalanches());
+
+    // Dark counts, from a pulse length before the window, with their crosstalk
+    G4double tails = (fKernelLength - 1)*fSamplingPeriod;
+    G4double duration = fNSamples*fSamplingPeriod + tails;
+    G4long nDark = G4Poisson(fDarkRate*duration*nChannels);
+    for(G4long i = 0; i < nDark; i++)
+    {
+        G4int k = std::min(static_cast<G4int>(G4UniformRand()*nChannels), nChannels - 1);
+        AddPulse(k, fWindowStart - tails + G4UniformRand()*duration, SampleAvalanches());
+    }
+
+    // Outputs: assigned, the vectors may have been swapped by the writer
+    for(G4int face = 0; face < 2; face++)
+    {
+        fCharge[face].assign(GS::nOfSiPMs, 0.);
+        fLeadTime[face].assign(GS::nOfSiPMs, 999999.);
+        if(fSaveTraces)
+        {
+            auto begin = fWaveforms.begin() + static_cast<size_t>(face)*GS::nOfSiPMs*fNSamples;
+            fTrace[face].assign(begin, begin + static_cast<size_t>(GS::nOfSiPMs)*fNSamples);
+        }
+        else
+            fTrace[face].clear();
+    }
+
+    // Only the channels with pulses are analyzed, then reset
+    for(G4int k : fTouched)
+    {
+        G4int face = k/GS::nOfSiPMs;
+        G4int ch = k%GS::nOfSiPMs;
+        Analyze(k, fCharge[face][ch], fLeadTime[face][ch]);
+
+        std::fill_n(fWaveforms.begin() + static_cast<size_t>(k)*fNSamples, fNSamples, 0.);
+        fIsTouched[k] = false;
+    }
+    fTouched.clear();
+}
+
+
+
+void MyDigitizer::AddPulse(G4int k, G4double time, G4double amplitude)
+{
+    // Sample before the pulse and phase of the pulse, to the nearest one
+    G4double position = (time - fWindowStart)/fSamplingPeriod;
+    G4double sample = std::floor(position);
+    G4int phase = static_cast<G4int>((position - sample)*nPhases + 0.5);
+    if(phase == nPhases)
+    {
+        sample += 1.;
+        phase = 0;
+    }
+
+    // Out of the window, tails included
+    if(sample >= fNSamples || sample + fKernelLength <= 0)
+        return;
+
+    G4int first = static_cast<G4int>(sample);
+    G4int begin = std::max(0, -first);
+    G4int end = std::min(fKernelLength, fNSamples - first);
+
+    G4double *waveform = fWaveforms.data() + static_cast<size_t>(k)*fNSamples + first;
+    const G4double *kernel = fKernel.data() + static_cast<size_t>(phase)*fKernelLength;
+    for(G4int m = begin; m < end; m++)
+        waveform[m] += amplitude*kernel[m];
+
+    if(!fIsTouched[k])
+    {
+        fIsTouched[k] = true;
+        fTouched.push_back(k);
+    }
+}
+
+
+
+G4int MyDigitizer::SampleAvalanches() const
+{
+    G4int n = 1;
+    while(G4UniformRand() < fCrosstalk)
+        n++;
+    return n;
+}
+
+
+
+void MyDigitizer::Analyze(G4int k, G4double &charge, G4double &leadTime) const
+{
+    const G4double *waveform = fWaveforms.data() + static_cast<size_t>(k)*fNSamples;
+
+    G4double sum = 0.;
+    for(G4int i = 0; i < fNSamples; i++)
+        sum += waveform[i];
+    charge = sum/fPulseArea;
+
+    // First crossing of the threshold, interpolated between the samples
+    for(G4int i = 0; i < fNSamples; i++)
+    {
+        if(waveform[i] < fThreshold)
+            continue;
+        G4double fraction = i > 0 ? (fThreshold - waveform[i-1])/(waveform[i] - waveform[i-1]) : 1.;
+        leadTime = fWindowStart + (i - 1 + fraction)*fSamplingPeriod;
+        return;
+    }
+}
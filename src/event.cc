@@ -3,9 +3,37 @@
  * @brief Definition of the class @ref MyEventAction
  */
 #include "event.hh"
+#include "run.hh"
+
+MyEventAction::MyEventAction()
+{
+    // Bind the vector columns of NT::columns to the buffers
+    fRecord.BindIntVector<NT::FindColumn("NHits_F_Ch")>(&fHits.fHitsPerChannel[0]);
+    fRecord.BindDoubleVector<NT::FindColumn("T_F")>(&fHits.fTime[0]);
+    fRecord.BindDoubleVector<NT::FindColumn("X_F")>(&fX_F);
+    fRecord.BindDoubleVector<NT::FindColumn("Y_F")>(&fY_F);
+    fRecord.BindIntVector<NT::FindColumn("Ch_F")>(&fHits.fChannel[0]);
+    fRecord.BindIntVector<NT::FindColumn("NHits_B_Ch")>(&fHits.fHitsPerChannel[1]);
+    fRecord.BindDoubleVector<NT::FindColumn("T_B")>(&fHits.fTime[1]);
+    fRecord.BindDoubleVector<NT::FindColumn("X_B")>(&fX_B);
+    fRecord.BindDoubleVector<NT::FindColumn("Y_B")>(&fY_B);
+    fRecord.BindIntVector<NT::FindColumn("Ch_B")>(&fHits.fChannel[1]);
+    fRecord.BindDoubleVector<NT::FindColumn("Charge_F")>(&fDigitizer.fCharge[0]);
+    fRecord.BindDoubleVector<NT::FindColumn("TLead_F")>(&fDigitizer.fLeadTime[0]);
+    fRecord.BindDoubleVector<NT::FindColumn("Charge_B")>(&fDigitizer.fCharge[1]);
+    fRecord.BindDoubleVector<NT::FindColumn("TLead_B")>(&fDigitizer.fLeadTime[1]);
+    fRecord.BindDoubleVector<NT::FindColumn("Trace_F")>(&fDigitizer.fTrace[0]);
+    fRecord.BindDoubleVector<NT::FindColumn("Trace_B")>(&fDigitizer.fTrace[1]);
+    fRecord.BindIntVector<NT::FindColumn("TBins_F")>(&fTimeBins[0]);
+    fRecord.BindIntVector<NT::FindColumn("TBins_B")>(&fTimeBins[1]);
+}
+
+
 
 void MyEventAction::BeginOfEventAction(const G4Event *event)
 {
+    fEventStart = std::chrono::steady_clock::now();
+
     // Reset all event data
     fTimeIn = 999999.;
     fPosXIn = 999999.;
@@ -18,20 +46,13 @@ void MyEventAction::BeginOfEventAction(const G4Event *event)
     fEdep = 0.;
     fMaxEdep = 0.;
     fMaxEdepPos = G4ThreeVector(0., 0., 0.);
-    fHitsNum_F = 0.;
-    fHitsNum_B = 0.;
-    fHitsNum_F_Ch.clear();
-    fHitsNum_F_Ch = std::vector<G4int>(GS::nOfSiPMs, 0);
-    fT_F.clear();
+    fHits.Clear();
     fX_F.clear();
     fY_F.clear();
-    fChannel_F.clear();
-    fHitsNum_B_Ch.clear();
-    fHitsNum_B_Ch = std::vector<G4int>(GS::nOfSiPMs, 0);
-    fT_B.clear();
     fX_B.clear();
     fY_B.clear();
-    fChannel_B.clear();
+    fNKilledWindow = 0;
+    fNLateHits = 0;
     fDecayTriggerSi = false;
     fCosmicTriggerUp = false;
     fCosmicTriggerBottom = false;
@@ -44,48 +65,46 @@ void MyEventAction::EndOfEventAction(const G4Event *event)
     // Settings depending on run mode type
     G4int modeType = static_cast<const MyPrimaryGenerator*>(G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction())->GetModeType();
 
-    switch(modeType)
+    // Every event processed counts for the throughput, its time, output
+    // included, is the busy time of the thread
+    MyScopeTimer busyTimer(fPerfCounters.fBusyTime, fEventStart);
+    fPerfCounters.CountEvent(fHits.GetNHits());
+
+    // Events aborted before the generation (beyond the replay list) are not saved
+    if(event->IsAborted() || !event->GetPrimaryVertex() || !IsEventTriggered(modeType))
+        return;
+
+    // In light map mode only the map statistics are accumulated
+    if(modeType == 50)
     {
-        case 22: // 176Lu decay with trigger
-            if(!fDecayTriggerSi)
-                return;
-        case 30: // Cosmic rays
-        case 31:
-            if(!(fCosmicTriggerUp*fCosmicTriggerBottom))
-                return;
+        FillLightMap(event);
+        return;
     }
 
+    // Accumulate the statistics of the run, from the raw hits
+    if(fLEDID >= 0)
+        fLEDStats.Fill(fLEDID, fLEDPhotons, fHits.fHitsPerChannel);
+    if(fRunStats.IsEnabled())
+        fRunStats.Fill(fHits, fEdep);
 
-    // Access the hit collection
-    G4HCofThisEvent *hce = event->GetHCofThisEvent();
-    MyHitsCollection *THC = (MyHitsCollection *)(hce->GetHC(0));
-    
-    if(!THC)
+    // Without the ntuple, nothing else to do
+    if(!fWriteNtuple)
         return;
 
-    // Fill vectors of data about hits
-    G4int nHits = THC->entries();
-    for(G4int i = 0; i < nHits; i++)
+    // Times and channels are already in the buffer, bound to the record.
+    // The digitized SiPMs, the histograms or the counts replace the photon
+    // lists in the output
+    if(fDigitizer.IsEnabled())
+        fDigitizer.Digitize(fHits);
+    else if(fNTimeBins > 0)
+    {
+        FillTimeBins(0);
+        FillTimeBins(1);
+    }
+    else if(!fCountsOnly)
     {
-        if((*THC)[i]->GetDetectorPosition().z() < GS::zScintillator)
-            {   
-                fHitsNum_F++;
-                fHitsNum_F_Ch[(*THC)[i]->GetDetectorChannel()]++;
-                fT_F.push_back((*THC)[i]->GetDetectionTime());
-                fX_F.push_back((*THC)[i]->GetDetectorPosition().x());
-                fY_F.push_back((*THC)[i]->GetDetectorPosition().y());
-                fChannel_F.push_back((*THC)[i]->GetDetectorChannel());
-            }
-
-            if((*THC)[i]->GetDetectorPosition().z() > GS::zScintillator)
-            {
-                fHitsNum_B++;
-                fHitsNum_B_Ch[(*THC)[i]->GetDetectorChannel()]++;
-                fT_B.push_back((*THC)[i]->GetDetectionTime());
-                fX_B.push_back((*THC)[i]->GetDetectorPosition().x());
-                fY_B.push_back((*THC)[i]->GetDetectorPosition().y());
-                fChannel_B.push_back((*THC)[i]->GetDetectorChannel());
-            }
+        FillHitPositions(0, fX_F, fY_F);
+        FillHitPositions(1, fX_B, fY_B);
     }
 
     // Access info about primary particle
@@ -93,37 +112,116 @@ void MyEventAction::EndOfEventAction(const G4Event *event)
     G4PrimaryParticle *primaryParticle = primaryVertex->GetPrimary(); 
 
     // Store data
-    G4AnalysisManager *man = G4AnalysisManager::Instance();
-    G4int evt = event->GetEventID();
+    G4int evt = fEventID;
     
-    // Fill the primary gamma branches
-    man->FillNtupleIColumn(0, evt);
-    man->FillNtupleIColumn(1, primaryParticle->GetParticleDefinition()->GetPDGEncoding());
-    man->FillNtupleDColumn(2, primaryParticle->GetTotalEnergy());
-    man->FillNtupleDColumn(3, primaryVertex->GetX0());
-    man->FillNtupleDColumn(4, primaryVertex->GetY0());
-    man->FillNtupleDColumn(5, primaryVertex->GetZ0());
-    man->FillNtupleDColumn(6, primaryParticle->GetMomentumDirection().x());
-    man->FillNtupleDColumn(7, primaryParticle->GetMomentumDirection().y());
-    man->FillNtupleDColumn(8, primaryParticle->GetMomentumDirection().z());
-    man->FillNtupleDColumn(9, fTimeIn);
-    man->FillNtupleDColumn(10, fPosXIn);
-    man->FillNtupleDColumn(11, fPosYIn);
-    man->FillNtupleDColumn(12, fPosZIn);
-    man->FillNtupleDColumn(13, fTimeFirstInter);
-    man->FillNtupleDColumn(14, fPosXFirstInter);
-    man->FillNtupleDColumn(15, fPosYFirstInter);
-    man->FillNtupleDColumn(16, fPosZFirstInter);
-    // Fill the energy deposition branches
-    man->FillNtupleDColumn(17, fEdep);
-    man->FillNtupleDColumn(18, fMaxEdep);
-    man->FillNtupleDColumn(19, fMaxEdepPos.x());
-    man->FillNtupleDColumn(20, fMaxEdepPos.y());
-    man->FillNtupleDColumn(21, fMaxEdepPos.z());
-    // Fill the detectors branches
-    man->FillNtupleIColumn(22, fHitsNum_F);
-    man->FillNtupleIColumn(23, fHitsNum_B);
-    man->FillNtupleIColumn(24, fHitsNum_F + fHitsNum_B);
-    // Close the row
-    man->AddNtupleRow(0);
+    // Fill the primary gamma columns
+    fRecord.SetInt<NT::FindColumn("Event")>(evt);
+    fRecord.SetInt<NT::FindColumn("PID_gun")>(primaryParticle->GetParticleDefinition()->GetPDGEncoding());
+    fRecord.SetDouble<NT::FindColumn("E_gun")>(primaryParticle->GetTotalEnergy());
+    fRecord.SetDouble<NT::FindColumn("X_gun")>(primaryVertex->GetX0());
+    fRecord.SetDouble<NT::FindColumn("Y_gun")>(primaryVertex->GetY0());
+    fRecord.SetDouble<NT::FindColumn("Z_gun")>(primaryVertex->GetZ0());
+    fRecord.SetDouble<NT::FindColumn("MomX_gun")>(primaryParticle->GetMomentumDirection().x());
+    fRecord.SetDouble<NT::FindColumn("MomY_gun")>(primaryParticle->GetMomentumDirection().y());
+    fRecord.SetDouble<NT::FindColumn("MomZ_gun")>(primaryParticle->GetMomentumDirection().z());
+    fRecord.SetDouble<NT::FindColumn("ToA")>(fTimeIn);
+    fRecord.SetDouble<NT::FindColumn("XoA")>(fPosXIn);
+    fRecord.SetDouble<NT::FindColumn("YoA")>(fPosYIn);
+    fRecord.SetDouble<NT::FindColumn("ZoA")>(fPosZIn);
+    fRecord.SetDouble<NT::FindColumn("ToFI")>(fTimeFirstInter);
+    fRecord.SetDouble<NT::FindColumn("XoFI")>(fPosXFirstInter);
+    fRecord.SetDouble<NT::FindColumn("YoFI")>(fPosYFirstInter);
+    fRecord.SetDouble<NT::FindColumn("ZoFI")>(fPosZFirstInter);
+    // Fill the energy deposition columns
+    fRecord.SetDouble<NT::FindColumn("Edep")>(fEdep);
+    fRecord.SetDouble<NT::FindColumn("MaxEdep")>(fMaxEdep);
+    fRecord.SetDouble<NT::FindColumn("MaxEdepPosX")>(fMaxEdepPos.x());
+    fRecord.SetDouble<NT::FindColumn("MaxEdepPosY")>(fMaxEdepPos.y());
+    fRecord.SetDouble<NT::FindColumn("MaxEdepPosZ")>(fMaxEdepPos.z());
+    // Fill the detectors columns
+    fRecord.SetInt<NT::FindColumn("NHits_F")>(fHits.GetNHits(0));
+    fRecord.SetInt<NT::FindColumn("NHits_B")>(fHits.GetNHits(1));
+    fRecord.SetInt<NT::FindColumn("NHits_Tot")>(fHits.GetNHits());
+    // Fill the readout window columns
+    fRecord.SetInt<NT::FindColumn("NKilled_Window")>(fNKilledWindow);
+    fRecord.SetInt<NT::FindColumn("NLateHits")>(fNLateHits);
+    // Fill the seeds of the event
+    fRecord.SetInt<NT::FindColumn("Seed0")>(fSeed0);
+    fRecord.SetInt<NT::FindColumn("Seed1")>(fSeed1);
+    // Fill the LED column
+    fRecord.SetInt<NT::FindColumn("LED")>(fLEDID);
+    // Write the event
+    fRunAction->WriteEvent(fRecord);
+}
+
+
+
+G4bool MyEventAction::IsEventTriggered(G4int modeType) const
+{
+    switch(modeType)
+    {
+        case 22: // 176Lu decay with trigger
+            return fDecayTriggerSi;
+        case 30: // Cosmic rays
+        case 31:
+            return fCosmicTriggerUp && fCosmicTriggerBottom;
+        default:
+            return true;
+    }
+}
+
+
+
+void MyEventAction::FillHitPositions(G4int face, std::vector<G4double> &x, std::vector<G4double> &y)
+{
+    const std::vector<G4int> &channels = fHits.fChannel[face];
+    x.resize(channels.size());
+    y.resize(channels.size());
+    for(size_t i = 0; i < channels.size(); i++)
+    {
+        x[i] = GS::sipmChannels[channels[i]].x;
+        y[i] = GS::sipmChannels[channels[i]].y;
+    }
+}
+
+
+
+void MyEventAction::FillTimeBins(G4int face)
+{
+    // Assigned, not filled: the vectors may have been swapped with empty
+    // ones by the asynchronous writer
+    std::vector<G4int> &bins = fTimeBins[face];
+    bins.assign(static_cast<size_t>(GS::nOfSiPMs)*fNTimeBins, 0);
+
+    const std::vector<G4double> &times = fHits.fTime[face];
+    const std::vector<G4int> &channels = fHits.fChannel[face];
+    for(size_t i = 0; i < times.size(); i++)
+    {
+        G4double bin = (times[i] - fTimeBinStart)/fTimeBinWidth;
+        if(bin < 0. || bin >= fNTimeBins)
+            continue;
+        bins[channels[i]*fNTimeBins + static_cast<G4int>(bin)]++;
+    }
+}
+
+
+
+void MyEventAction::FillLightMap(const G4Event *event)
+{
+    // Emission point of the primary photon, in the crystal frame
+    G4PrimaryVertex *primaryVertex = event->GetPrimaryVertex();
+    G4ThreeVector localPos = primaryVertex->GetPosition() - G4ThreeVector(GS::xScintillator, GS::yScintillator, GS::zScintillator);
+    G4double emissionTime = primaryVertex->GetT0();
+
+    G4int voxel = fLightMapBuilder.GetBinning().GetVoxel(localPos);
+    if(voxel < 0)
+        return;
+
+    fLightMapBuilder.CountEmission(voxel);
+
+    for(G4int face = 0; face < 2; face++)
+    {
+        for(G4int i = 0; i < fHits.GetNHits(face); i++)
+            fLightMapBuilder.Fill(voxel, face*GS::nOfSiPMs + fHits.fChannel[face][i], fHits.fTime[face][i] - emissionTime);
+    }
 }
@@ -0,0 +1,57 @@
+/**
+ * @file fastlight.cc
+ * @brief Definition of the class @ref MyFastLightModel
+ */
+#include "fastlight.hh"
+
+MyFastLightModel::MyFastLightModel(G4String name, G4Region *envelope, MySensitiveDetector *sensDet, std::shared_ptr<const MyLightMap> lightMap, G4double yieldScale) : G4VFastSimulationModel(name, envelope), fSensDet(sensDet), fLightMap(lightMap), fYieldScale(yieldScale)
+{}
+
+
+
+G4bool MyFastLightModel::IsApplicable(const G4ParticleDefinition &particle)
+{
+    return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+
+
+G4bool MyFastLightModel::ModelTrigger(const G4FastTrack &fastTrack)
+{
+    // Only photons at their emission point: the ones re-entering the crystal
+    // (e.g. reflected back by the grease) are already accounted in the map.
+    // Primary photons are always tracked, that's how the map is built
+    const G4Track *track = fastTrack.GetPrimaryTrack();
+    return track->GetParentID() > 0 && track->GetTrackLength() == 0.;
+}
+
+
+
+void MyFastLightModel::DoIt(const G4FastTrack &fastTrack, G4FastStep &fastStep)
+{
+    // The photon is never transported
+    fastStep.KillPrimaryTrack();
+    fastStep.ProposePrimaryTrackPathLength(0.);
+
+    G4int voxel = fLightMap->GetBinning().GetVoxel(fastTrack.GetPrimaryTrackLocalPosition());
+    if(voxel < 0)
+        return;
+
+    // Sample the channel and the time of detection. The map is built with
+    // the nominal PDE, so it is divided by the pre-scaling of the yield for
+    // the scintillation photons, the only pre-scaled ones (as in the SD)
+    G4double scale = 1.;
+    if(fYieldScale < 1.)
+    {
+        const G4VProcess *creator = fastTrack.GetPrimaryTrack()->GetCreatorProcess();
+        if(creator && creator->GetProcessName() == "Scintillation")
+            scale = fYieldScale;
+    }
+
+    G4int channel;
+    G4double time;
+    if(!fLightMap->SampleHit(voxel, scale, channel, time))
+        return;
+
+    fSensDet->InsertHit(fastTrack.GetPrimaryTrack()->GetGlobalTime() + time, channel/GS::nOfSiPMs, channel%GS::nOfSiPMs);
+}
@@ -4,8 +4,22 @@
  */
 #include "generator.hh"
 
-MyPrimaryGenerator::MyPrimaryGenerator()
+#include <algorithm>
+#include <sstream>
+
+#include "G4Run.hh"
+
+#include "event.hh"
+#include "cosmicrays.hh"
+#include "physics.hh"
+#include "ledstats.hh"
+
+#include "G4Poisson.hh"
+
+MyPrimaryGenerator::MyPrimaryGenerator(G4int theMCID)
 {
+    fSeeder = new MyEventSeeder(theMCID);
+
     DefineCommands();
 
     // Default values     
@@ -20,10 +34,16 @@ MyPrimaryGenerator::MyPrimaryGenerator()
 
     // 176Lu decay
     fPosFixedDecay = G4ThreeVector(0., 0., 200.*mm);
+    fIsTabulatedLuDecay = false;
 
     // LED mode
     fChooseFrontorBack = "F";
     fSwitchOnLED = "u";
+    fLEDPhotons = 1000;
+    fIsPoissonLED = false;
+    fLEDPulseShape = "gauss";
+    fLEDPulseWidth = 2.*ns;
+    SetLEDSchedule("");
 
 
     // Construct the Particle Gun
@@ -41,12 +61,26 @@ MyPrimaryGenerator::~MyPrimaryGenerator()
     delete fMessenger_Gun;
     delete fMessenger_Calib;
     delete fParticleGun;
+    delete fSeeder;
 }
 
 
 
 void MyPrimaryGenerator::GeneratePrimaries(G4Event *anEvent)
 {
+    // Reseed the engine from (MCID, run, event): the event doesn't depend on
+    // the thread processing it and can be replayed alone
+    G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+    if(!fSeeder->SeedEvent(runID, anEvent->GetEventID()))
+    {
+        anEvent->SetEventAborted();
+        return;
+    }
+
+    MyEventAction *eventAction = static_cast<MyEventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+    eventAction->SetEventSeeds(fSeeder->GetEventID(), fSeeder->GetSeed(0), fSeeder->GetSeed(1));
+    eventAction->SetLEDPulse(-1, 0);
+
     switch(fModeType)
     {
         // Standard mode
@@ -60,6 +94,16 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event *anEvent)
         case 20:
         case 21:  // Fixed position
         case 22:  // Si trigger
+            if(!fIsTabulatedLuDecay && !static_cast<const MyPhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList())->HasRadioactiveDecay())
+            {
+                G4Exception("MyPrimaryGenerator::GeneratePrimaries()", "Generator001", JustWarning, "The radioactive decay is not simulated: the tabulated 176Lu decay is used");
+                fIsTabulatedLuDecay = true;
+            }
+            if(fIsTabulatedLuDecay)
+            {
+                PrimariesForTabulatedLuDecayMode(anEvent);
+                return;
+            }
             PrimariesForLuDecayMode();
             break;
 
@@ -73,6 +117,21 @@ void MyPrimaryGenerator::GeneratePrimaries(G4Event *anEvent)
         // LED-System mode
         case 40:
             PrimariesForLEDMode();
+            eventAction->SetLEDPulse(MyLEDStats::FindLED(fChooseFrontorBack, fSwitchOnLED), 1);
+            break;
+        case 41: // Pulses
+            eventAction->SetLEDPulse(MyLEDStats::FindLED(fChooseFrontorBack, fSwitchOnLED), PrimariesForLEDPulseMode(anEvent, GetLEDPosition(fChooseFrontorBack, fSwitchOnLED)));
+            return;
+        case 42: // Pulses of all the LEDs, in turn
+        {
+            G4int led = fLEDSchedule[fSeeder->GetEventID()%fLEDSchedule.size()];
+            G4String name = MyLEDStats::GetLEDName(led);
+            eventAction->SetLEDPulse(led, PrimariesForLEDPulseMode(anEvent, GetLEDPosition(name.substr(0, 1), name.substr(1))));
+            return;
+        }
+        // Light map mode
+        case 50:
+            PrimariesForLightMapMode(fSeeder->GetEventID());
             break;
 
         default:
@@ -151,15 +210,14 @@ void MyPrimaryGenerator::PrimariesForStandardMode()
 
 
 
-void MyPrimaryGenerator::PrimariesForLEDMode()
+G4ThreeVector MyPrimaryGenerator::GetLEDPosition(const G4String &face, const G4String &hole)
 {
     G4ThreeVector posLed;
-    G4ThreeVector momLed;
 
     // Which face
     G4double posZLed;
-    if(fChooseFrontorBack=="F") posZLed = GS::zFrontFaceScintillator-GS::halfheightLightGuide; 
-    else if(fChooseFrontorBack=="B") posZLed = GS::zBackFaceScintillator+GS::halfheightLightGuide;
+    if(face=="F") posZLed = GS::zFrontFaceScintillator-GS::halfheightLightGuide; 
+    else if(face=="B") posZLed = GS::zBackFaceScintillator+GS::halfheightLightGuide;
     else
     {
         G4cerr << "Option for detector face not valid. 'Front' has been setted" << G4endl;
@@ -167,18 +225,28 @@ void MyPrimaryGenerator::PrimariesForLEDMode()
     }
 
     // Which LED
-    if(fSwitchOnLED=="u") posLed = G4ThreeVector(0, GS::radiusLightGuide-GS::depthLED, posZLed);
-    else if(fSwitchOnLED=="d") posLed = G4ThreeVector(0, -GS::radiusLightGuide+GS::depthLED, posZLed);
-    else if(fSwitchOnLED=="l") posLed = G4ThreeVector(GS::radiusLightGuide-GS::depthLED, 0, posZLed);
-    else if(fSwitchOnLED=="r") posLed = G4ThreeVector(-GS::radiusLightGuide+GS::depthLED, 0, posZLed);
+    if(hole=="u") posLed = G4ThreeVector(0, GS::radiusLightGuide-GS::depthLED, posZLed);
+    else if(hole=="d") posLed = G4ThreeVector(0, -GS::radiusLightGuide+GS::depthLED, posZLed);
+    else if(hole=="l") posLed = G4ThreeVector(GS::radiusLightGuide-GS::depthLED, 0, posZLed);
+    else if(hole=="r") posLed = G4ThreeVector(-GS::radiusLightGuide+GS::depthLED, 0, posZLed);
     else
     {
         G4cerr << "Option for LED not valid. 'up' has been setted" << G4endl;
         posLed = G4ThreeVector(0, GS::radiusLightGuide-GS::depthLED, posZLed);
     }
 
-    // Isotropic emission (not accurate, should be Lambert's cosine law,
-    // but need G4GeneralParticleSource for this)
+    return posLed;
+}
+
+
+
+void MyPrimaryGenerator::PrimariesForLEDMode()
+{
+    G4ThreeVector posLed = GetLEDPosition(fChooseFrontorBack, fSwitchOnLED);
+    G4ThreeVector momLed;
+
+    // Isotropic emission (not accurate, should be Lambert's cosine law as
+    // in the pulses of mode 41)
     G4double cosTheta = 2*G4UniformRand() - 1.;
     G4double phi = CLHEP::twopi*G4UniformRand();
     G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
@@ -196,12 +264,150 @@ void MyPrimaryGenerator::PrimariesForLEDMode()
 
 
 
-void MyPrimaryGenerator::PrimariesForLuDecayMode()
+G4int MyPrimaryGenerator::PrimariesForLEDPulseMode(G4Event *anEvent, const G4ThreeVector &posLed)
+{
+    // The LED looks at the axis of the light guide from its hole
+    G4ThreeVector normal = -G4ThreeVector(posLed.x(), posLed.y(), 0.).unit();
+    G4ThreeVector tangent1 = normal.orthogonal().unit();
+    G4ThreeVector tangent2 = normal.cross(tangent1);
+
+    G4int nPhotons = fIsPoissonLED ? static_cast<G4int>(G4Poisson(fLEDPhotons)) : fLEDPhotons;
+    G4ParticleDefinition *particle = G4ParticleTable::GetParticleTable()->FindParticle("opticalphoton");
+
+    for(G4int i = 0; i < nPhotons; i++)
+    {
+        // Lambert's cosine law around the normal of the LED
+        G4double cosTheta = std::sqrt(G4UniformRand());
+        G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+        G4double phi = CLHEP::twopi*G4UniformRand();
+        G4ThreeVector momPhoton = cosTheta*normal + sinTheta*(std::cos(phi)*tangent1 + std::sin(phi)*tangent2);
+
+        // Random linear polarization, perpendicular to the momentum
+        G4ThreeVector polPhoton = momPhoton.orthogonal().unit().rotate(momPhoton, CLHEP::twopi*G4UniformRand());
+
+        // Every photon has its own emission time, so its own vertex
+        G4PrimaryVertex *vertex = new G4PrimaryVertex(posLed, SampleLEDPulseTime());
+        G4PrimaryParticle *photon = new G4PrimaryParticle(particle);
+        photon->SetKineticEnergy(GS::energyLED);
+        photon->SetMomentumDirection(momPhoton);
+        photon->SetPolarization(polPhoton);
+        vertex->SetPrimary(photon);
+        anEvent->AddPrimaryVertex(vertex);
+    }
+
+    return nPhotons;
+}
+
+
+
+void MyPrimaryGenerator::SetLEDSchedule(const G4String &schedule)
+{
+    fLEDSchedule.clear();
+
+    std::istringstream leds(schedule);
+    G4String name;
+    while(leds >> name)
+    {
+        G4int led = name.size() == 2 ? MyLEDStats::FindLED(name.substr(0, 1), name.substr(1)) : -1;
+        if(led < 0)
+        {
+            G4Exception("MyPrimaryGenerator::SetLEDSchedule()", "Generator002", JustWarning, ("Not valid LED " + name + " (e.g. Fu, Bl), skipped").c_str());
+            continue;
+        }
+        fLEDSchedule.push_back(led);
+    }
+
+    // All the LEDs in turn by default
+    if(fLEDSchedule.empty())
+        for(G4int led = 0; led < MyLEDStats::nLEDs; led++)
+            fLEDSchedule.push_back(led);
+}
+
+
+
+G4double MyPrimaryGenerator::SampleLEDPulseTime()
+{
+    if(fLEDPulseWidth <= 0.)
+        return 0.;
+
+    if(fLEDPulseShape == "gauss")
+        return std::max(0., G4RandGauss::shoot(3.*fLEDPulseWidth, fLEDPulseWidth));
+    if(fLEDPulseShape == "exp")
+        return -fLEDPulseWidth*std::log(1. - G4UniformRand());
+    // square
+    return fLEDPulseWidth*G4UniformRand();
+}
+
+
+
+void MyPrimaryGenerator::PrimariesForLightMapMode(G4int eventID)
+{
+    // The binning of the map being built in this thread
+    const MyEventAction *eventAction = static_cast<const MyEventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+    const MyLightMapBinning &binning = eventAction->fLightMapBuilder.GetBinning();
+
+    // Visit the voxels in turn
+    G4int voxel = eventID%binning.GetNVoxels();
+    G4ThreeVector posPhoton = binning.SampleInVoxel(voxel) + G4ThreeVector(GS::xScintillator, GS::yScintillator, GS::zScintillator);
+
+    // Isotropic emission
+    G4double cosTheta = 2*G4UniformRand() - 1.;
+    G4double phi = CLHEP::twopi*G4UniformRand();
+    G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+    G4ThreeVector momPhoton(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+
+    // Random linear polarization, perpendicular to the momentum
+    G4ThreeVector polPhoton = momPhoton.orthogonal().unit().rotate(momPhoton, CLHEP::twopi*G4UniformRand());
+
+    // Set everything in fParticleGun
+    G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle("opticalphoton");
+    fParticleGun->SetParticleDefinition(particle);
+    fParticleGun->SetParticlePosition(posPhoton);
+    fParticleGun->SetParticleMomentumDirection(momPhoton);
+    fParticleGun->SetParticlePolarization(polPhoton);
+    fParticleGun->SetParticleEnergy(SampleScintillationEnergy());
+    fParticleGun->SetParticleTime(0.);
+}
+
+
+
+G4double MyPrimaryGenerator::SampleScintillationEnergy()
+{
+    // Build the cumulative spectrum the first time
+    if(fEmissionCDF.empty())
+    {
+        G4MaterialPropertyVector *spectrum = G4Material::GetMaterial("LYSO")->GetMaterialPropertiesTable()->GetProperty("SCINTILLATIONCOMPONENT1");
+
+        G4double cumulative = 0.;
+        fEmissionEnergies.push_back(spectrum->Energy(0));
+        fEmissionCDF.push_back(0.);
+        for(size_t i = 1; i < spectrum->GetVectorLength(); i++)
+        {
+            cumulative += 0.5*((*spectrum)[i] + (*spectrum)[i-1])*(spectrum->Energy(i) - spectrum->Energy(i-1));
+            fEmissionEnergies.push_back(spectrum->Energy(i));
+            fEmissionCDF.push_back(cumulative);
+        }
+        for(auto &value : fEmissionCDF)
+            value /= cumulative;
+    }
+
+    // Invert the cumulative, linearly between the points
+    G4double u = G4UniformRand();
+    size_t i = std::upper_bound(fEmissionCDF.begin(), fEmissionCDF.end(), u) - fEmissionCDF.begin();
+    if(i >= fEmissionCDF.size())
+        return fEmissionEnergies.back();
+
+    G4double fraction = (u - fEmissionCDF[i-1])/(fEmissionCDF[i] - fEmissionCDF[i-1]);
+    return fEmissionEnergies[i-1] + fraction*(fEmissionEnergies[i] - fEmissionEnergies[i-1]);
+}
+
+
+
+G4ThreeVector MyPrimaryGenerator::SampleLuDecayPosition()
 {
     G4ThreeVector posDecay;
-    G4ThreeVector momDecay;
     G4double posZ, posR, posPhi;
-    
+
     switch(fModeType)
     {
         case 20:  // Default
@@ -222,6 +428,16 @@ void MyPrimaryGenerator::PrimariesForLuDecayMode()
             break;
     }
 
+    return posDecay;
+}
+
+
+
+void MyPrimaryGenerator::PrimariesForLuDecayMode()
+{
+    G4ThreeVector posDecay = SampleLuDecayPosition();
+    G4ThreeVector momDecay;
+
     // Isotropic emission
     G4double cosTheta = 2*G4UniformRand() - 1.;
     G4double phi = CLHEP::twopi*G4UniformRand();
@@ -244,67 +460,28 @@ void MyPrimaryGenerator::PrimariesForLuDecayMode()
 
 
 
-void MyPrimaryGenerator::PrimariesForCosmicRaysMode()
+void MyPrimaryGenerator::PrimariesForTabulatedLuDecayMode(G4Event *anEvent)
 {
-    G4ThreeVector posRay;
-    G4ThreeVector momRay;
+    // The products start from the decay point at t = 0: the electron is the
+    // primary of the event
+    G4PrimaryVertex *vertex = new G4PrimaryVertex(SampleLuDecayPosition(), 0.);
+    fLuDecay.GenerateDecay(vertex);
+    anEvent->AddPrimaryVertex(vertex);
+}
 
-    // Compute initial random position in the up detector
-    G4double posX = GS::xCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
-    G4double posY = GS::yCosmicRayDetector + GS::halfYsideCosmicRayDetector;
-    G4double posZ = GS::zCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
 
-    posRay = G4ThreeVector(posX, posY, posZ);
-    
-    // Compute initial cosmic ray direction
-    G4double cosTheta = -G4UniformRand(); // Note that cosine is in [-1, 0] now
-    G4double cosThetaa = G4UniformRand(); // On the image of cos^2(Theta)
-    G4double phi = CLHEP::twopi*G4UniformRand();
-    G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
-    G4double uz = sinTheta*std::cos(phi); // Remember the axis orientation
-    G4double ux = sinTheta*std::sin(phi);
-    G4double uy = cosTheta; // Y is vertical
 
-    momRay = G4ThreeVector(ux, uy, uz);
-
-    while(std::abs(ProjectOnBottomDetector(posRay, momRay).x() - GS::xCosmicRayDetector) > GS::halfZXsideCosmicRayDetector || std::abs(ProjectOnBottomDetector(posRay, momRay).z() - GS::zCosmicRayDetector) > GS::halfZXsideCosmicRayDetector) // Conditions on trigger
-    {
-        posX = GS::xCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
-        posZ = GS::zCosmicRayDetector + 2*(G4UniformRand()-0.5)*GS::halfZXsideCosmicRayDetector;
+void MyPrimaryGenerator::PrimariesForCosmicRaysMode()
+{
+    G4ThreeVector posRay;
+    G4ThreeVector momRay;
 
-        posRay = G4ThreeVector(posX, posY, posZ);
+    // Track crossing both the cosmic rays detectors, on the top face of the
+    // up one: no muon misses the trigger
+    MyCosmicRaySampler::SampleTriggeredTrack(posRay, momRay);
 
-        cosTheta = -G4UniformRand(); // Note that cosine is in [-1, 0] now
-        cosThetaa = G4UniformRand(); // On the image of cos^2(Theta)
-        phi = CLHEP::twopi*G4UniformRand();
-        while(cosThetaa > (cosTheta*cosTheta)) // Mom-dir generation
-        {
-            cosTheta = -G4UniformRand();
-            cosThetaa = G4UniformRand();
-            
-            phi = CLHEP::twopi*G4UniformRand();
-        }
-        sinTheta = std::sqrt(1. - cosTheta*cosTheta);
-        uz = sinTheta*std::cos(phi);
-        ux = sinTheta*std::sin(phi);
-        uy = cosTheta;
-    
-        momRay = G4ThreeVector(ux, uy, uz);
-    }
-    
-    
     // Cosmic ray energy
-    G4double energy = 999.;
-    G4double energyy = 1.; // On the image of pdf(E)
-    G4double emin = 0.; // kinetic energy
-    G4double emax = 1.*TeV;
-
-    while(energyy > PDF_E_CosmicRay(energy))
-    {   // Accept-Reject method
-        energy = emin + emax*G4UniformRand();
-            // Note that the maximum probability is at minimum energy
-        energyy = PDF_E_CosmicRay(emin)*G4UniformRand();
-    }
+    G4double energy = MyCosmicRaySampler::SampleEnergy();
 
     // Set everything in fParticleGun
     G4ParticleDefinition* particle = nullptr;
@@ -315,7 +492,8 @@ void MyPrimaryGenerator::PrimariesForCosmicRaysMode()
 
     fParticleGun->SetParticleDefinition(particle);
     fParticleGun->SetParticlePosition(posRay);
-    fParticleGun->SetParticleMomentumDirection(momRay);        fParticleGun->SetParticleEnergy(energy);
+    fParticleGun->SetParticleMomentumDirection(momRay);
+    fParticleGun->SetParticleEnergy(energy);
 }
 
 
@@ -326,41 +504,17 @@ void MyPrimaryGenerator::PrimariesForCountingCosmicRaysMode()
     G4ThreeVector momRay;
 
     // Compute initial random position in the up detector
-    G4double posX = GS::xCosmicRayDetector + (G4UniformRand()-0.5) * 10*cm;
+    G4double posX = GS::xCosmicRayDetector + 2*(G4UniformRand()-0.5)*MyCosmicRaySampler::halfSideCountingArea;
     G4double posY = GS::yCosmicRayDetector + GS::halfYsideCosmicRayDetector;
-    G4double posZ = GS::zCosmicRayDetector + (G4UniformRand()-0.5) * 10*cm;
+    G4double posZ = GS::zCosmicRayDetector + 2*(G4UniformRand()-0.5)*MyCosmicRaySampler::halfSideCountingArea;
 
     posRay = G4ThreeVector(posX, posY, posZ);
-    
+
     // Compute initial cosmic ray direction
-    G4double cosTheta = -G4UniformRand(); // Note that cosine is in [-1, 0] now
-    G4double cosThetaa = G4UniformRand(); // On the image of cos^2(Theta)
-    while(cosThetaa > (cosTheta*cosTheta)) // Mom-dir generation
-    {
-        cosTheta = -G4UniformRand();
-        cosThetaa = G4UniformRand();
-            
-    }
-    G4double phi = CLHEP::twopi*G4UniformRand();
-    G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
-    G4double uz = sinTheta*std::cos(phi);
-    G4double ux = sinTheta*std::sin(phi);
-    G4double uy = cosTheta;
+    momRay = MyCosmicRaySampler::SampleDirection(MyCosmicRaySampler::SampleCosTheta());
 
-    momRay = G4ThreeVector(ux, uy, uz);
-    
     // Cosmic ray energy
-    G4double energy = 999.;
-    G4double energyy = 1.; // On the image of pdf(E)
-    G4double emin = 0.; // kinetic energy
-    G4double emax = 1.*TeV;
-
-    while(energyy > PDF_E_CosmicRay(energy))
-    {   // Accept-Reject method
-        energy = emin + emax*G4UniformRand();
-            // Note that the maximum probability is at minimum energy
-        energyy = PDF_E_CosmicRay(emin)*G4UniformRand();
-    }
+    G4double energy = MyCosmicRaySampler::SampleEnergy();
 
     // Set everything in fParticleGun
     G4ParticleDefinition* particle = nullptr;
@@ -371,44 +525,17 @@ void MyPrimaryGenerator::PrimariesForCountingCosmicRaysMode()
 
     fParticleGun->SetParticleDefinition(particle);
     fParticleGun->SetParticlePosition(posRay);
-    fParticleGun->SetParticleMomentumDirection(momRay);        fParticleGun->SetParticleEnergy(energy);
-}
-
-
-
-G4double MyPrimaryGenerator::PDF_E_CosmicRay(G4double energy)
-{
-    if(energy < 3.4*GeV)
-    {
-        return std::pow(3.4*GeV, -2.7);
-    }
-    else
-    {
-        return std::pow(energy, -2.7);
-    }
+    fParticleGun->SetParticleMomentumDirection(momRay);
+    fParticleGun->SetParticleEnergy(energy);
 }
 
 
 
-G4ThreeVector MyPrimaryGenerator::ProjectOnBottomDetector(G4ThreeVector pos0, G4ThreeVector mom0)
-{   
-    G4double y_b = -(GS::yCosmicRayDetector + GS::halfYsideCosmicRayDetector);
-    G4double x_b, z_b;
-    G4double t = (y_b - pos0.y())/mom0.y();
-    
-    x_b = pos0.x() + mom0.x()*t;
-    z_b = pos0.z() + mom0.z()*t;
-
-    return G4ThreeVector(x_b, y_b, z_b);
-};
-
-
-
 void MyPrimaryGenerator::DefineCommands()
 {
     // Define my UD-messenger for mode selection
     fMessenger_Mode = new G4GenericMessenger(this, "/MC_LYSO/", "Commands for MC_LYSO run");
-    fMessenger_Mode->DeclareProperty("Mode", fModeType, "Available modes are: 10 = Standard with pointlike beam, 11 = Standard with spread beam, 12 = Standard with circle beam, 20 = Lu decay, 21 = Lu decay with fixed position, 22 = Lu decay with Si trigger test, 30 = Cosmic Rays, 40 = LED-system");
+    fMessenger_Mode->DeclareProperty("Mode", fModeType, "Available modes are: 10 = Standard with pointlike beam, 11 = Standard with spread beam, 12 = Standard with circle beam, 20 = Lu decay, 21 = Lu decay with fixed position, 22 = Lu decay with Si trigger test, 30 = Cosmic Rays, 31 = Cosmic Rays counting, 40 = LED-system, 41 = LED-system pulses, 42 = LED-system pulses of all the LEDs, 50 = Light map generation");
 
     // Define my UD-messenger for primary gamma
     fMessenger_Gun = new G4GenericMessenger(this, "/MC_LYSO/myGun/", "Cinematical settings for primary particle");
@@ -417,9 +544,15 @@ void MyPrimaryGenerator::DefineCommands()
     fMessenger_Gun->DeclarePropertyWithUnit("radiusSpread", "mm", fRadiusSpread, "Set radius of the spread on the front face of scintillator");
     fMessenger_Gun->DeclarePropertyWithUnit("radiusCircle", "mm", fRadiusCircle, "Set radius of the beam (in 'Circle' case)");
     fMessenger_Gun->DeclarePropertyWithUnit("posLuDecay", "mm", fPosFixedDecay, "Set position for Lu decay in fixed position mode");
+    fMessenger_Gun->DeclareProperty("tabulatedLuDecay", fIsTabulatedLuDecay, "Generate the 176Lu decay products directly from tables, instead of the ion decayed by G4RadioactiveDecay");
 
     // Define my UD-messenger for LED mode
     fMessenger_Calib = new G4GenericMessenger(this, "/MC_LYSO/myGun/LED-System/", "Settings for LED-system calibration");
     fMessenger_Calib->DeclareProperty("FrontOrBack", fChooseFrontorBack, "Choose side of detector you want to calibrate: F(ront) or B(ack)");
     fMessenger_Calib->DeclareProperty("switchOnLED", fSwitchOnLED, "Choose which LED turn ON: u(p), d(own), r(ight), l(eft)");
+    fMessenger_Calib->DeclareProperty("nPhotons", fLEDPhotons, "Set the number of photons of a pulse in mode 41 (the mean with poisson)").SetParameterRange("nPhotons>=0");
+    fMessenger_Calib->DeclareProperty("poisson", fIsPoissonLED, "Set if the number of photons of a pulse is Poisson-distributed");
+    fMessenger_Calib->DeclareProperty("pulseShape", fLEDPulseShape, "Choose the time profile of a pulse: square (width = duration), gauss (width = sigma, peak at 3 sigma) or exp (width = decay time)").SetCandidates("square gauss exp");
+    fMessenger_Calib->DeclarePropertyWithUnit("pulseWidth", "ns", fLEDPulseWidth, "Set the width of the time profile of a pulse (0 = all the photons at t = 0)");
+    fMessenger_Calib->DeclareMethod("sweepSchedule", &MyPrimaryGenerator::SetLEDSchedule, "Set the LEDs fired in turn by the events in mode 42, e.g. Fu Fd Fr Fl Bu Bd Br Bl (empty = all)");
 }
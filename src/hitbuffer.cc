@@ -0,0 +1,25 @@
+/**
+ * @file hitbuffer.cc
+ * @brief Definition of the class @ref MyHitBuffer
+ */
+#include "hitbuffer.hh"
+
+MyHitBuffer::MyHitBuffer()
+{
+    for(G4int face = 0; face < 2; face++)
+        fHitsPerChannel[face].assign(GS::nOfSiPMs, 0);
+}
+
+
+
+void MyHitBuffer::Clear()
+{
+    for(G4int face = 0; face < 2; face++)
+    {
+        fTime[face].clear();
+        fChannel[face].clear();
+        // Assigned, not filled: the vectors may have been swapped with empty
+        // ones by the asynchronous writer
+        fHitsPerChannel[face].assign(GS::nOfSiPMs, 0);
+    }
+}
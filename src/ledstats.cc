@@ -0,0 +1,192 @@
+/**
+ * @file ledstats.cc
+ * @brief Definition of the class @ref MyLEDStats
+ */
+#include "ledstats.hh"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace
+{
+    // Faces and holes, in the order of the LEDs
+    constexpr const char *faceNames[2] = {"F", "B"};
+    constexpr const char *holeNames[4] = {"u", "d", "r", "l"};
+}
+
+
+
+void MyLEDStats::Book()
+{
+    fNPulses.assign(nLEDs, 0);
+    fNPhotons.assign(nLEDs, 0);
+    fSum.assign(static_cast<size_t>(nLEDs)*nChannels, 0.);
+    fSum2.assign(static_cast<size_t>(nLEDs)*nChannels, 0.);
+}
+
+
+
+void MyLEDStats::Fill(G4int led, G4int nPhotons, const std::vector<G4int> hitsPerChannel[2])
+{
+    if(fNPulses.empty())
+        Book();
+
+    fNPulses[led]++;
+    fNPhotons[led] += nPhotons;
+
+    G4double *sum = fSum.data() + static_cast<size_t>(led)*nChannels;
+    G4double *sum2 = fSum2.data() + static_cast<size_t>(led)*nChannels;
+    for(G4int face = 0; face < 2; face++)
+        for(G4int ch = 0; ch < GS::nOfSiPMs; ch++)
+        {
+            G4double hits = hitsPerChannel[face][ch];
+            sum[face*GS::nOfSiPMs + ch] += hits;
+            sum2[face*GS::nOfSiPMs + ch] += hits*hits;
+        }
+}
+
+
+
+void MyLEDStats::Merge(const G4VAccumulable &other)
+{
+    const MyLEDStats &otherStats = static_cast<const MyLEDStats&>(other);
+    if(!otherStats.HasEntries())
+        return;
+
+    if(fNPulses.empty())
+        Book();
+
+    for(G4int led = 0; led < nLEDs; led++)
+    {
+        fNPulses[led] += otherStats.fNPulses[led];
+        fNPhotons[led] += otherStats.fNPhotons[led];
+    }
+    for(size_t i = 0; i < fSum.size(); i++)
+    {
+        fSum[i] += otherStats.fSum[i];
+        fSum2[i] += otherStats.fSum2[i];
+    }
+}
+
+
+
+void MyLEDStats::Reset()
+{
+    fNPulses.clear();
+    fNPhotons.clear();
+    fSum.clear();
+    fSum.shrink_to_fit();
+    fSum2.clear();
+    fSum2.shrink_to_fit();
+}
+
+
+
+void MyLEDStats::Write(const G4String &fileName) const
+{
+    std::ofstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't create the LED table " << fileName << G4endl;
+        return;
+    }
+
+    // The sums are written as they are, so that the tables of the shards
+    // can be merged (see Read()): they are integers
+    file << "# Photons detected per pulse by every channel" << G4endl;
+    file << "# LED Face Ch Pulses Photons Sum Sum2 Mean RMS" << G4endl;
+    for(G4int led = 0; led < nLEDs; led++)
+    {
+        if(fNPulses[led] == 0)
+            continue;
+
+        G4double nPulses = fNPulses[led];
+        G4double detected = 0.;
+        for(G4int k = 0; k < nChannels; k++)
+        {
+            size_t i = static_cast<size_t>(led)*nChannels + k;
+            G4double mean = fSum[i]/nPulses;
+            G4double rms = std::sqrt(std::max(0., fSum2[i]/nPulses - mean*mean));
+            detected += mean;
+            file << GetLEDName(led) << " " << faceNames[k/GS::nOfSiPMs] << " " << k%GS::nOfSiPMs << " " << fNPulses[led] << " " << fNPhotons[led] << " "
+                 << std::fixed << std::setprecision(0) << fSum[i] << " " << fSum2[i] << " " << std::defaultfloat << std::setprecision(6) << mean << " " << rms << G4endl;
+        }
+
+        G4cout << "LED " << GetLEDName(led) << ": " << fNPulses[led] << " pulses of " << fNPhotons[led]/nPulses << " photons, " << detected << " detected per pulse" << G4endl;
+    }
+}
+
+
+
+G4bool MyLEDStats::Read(const G4String &fileName)
+{
+    std::ifstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't read the LED table " << fileName << G4endl;
+        return false;
+    }
+
+    if(fNPulses.empty())
+        Book();
+
+    // The pulses and the photons of an LED are repeated on all its lines
+    std::vector<G4bool> isCounted(nLEDs, false);
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream stream(line);
+        std::string name, face;
+        G4int ch;
+        std::uint64_t nPulses, nPhotons;
+        G4double sum, sum2;
+        if(!(stream >> name >> face >> ch >> nPulses >> nPhotons >> sum >> sum2))
+        {
+            G4cerr << "Not valid line of the LED table " << fileName << ": " << line << G4endl;
+            return false;
+        }
+
+        G4int led = name.size() == 2 ? FindLED(name.substr(0, 1), name.substr(1)) : -1;
+        G4int faceIndex = face == faceNames[0] ? 0 : (face == faceNames[1] ? 1 : -1);
+        if(led < 0 || faceIndex < 0 || ch < 0 || ch >= GS::nOfSiPMs)
+        {
+            G4cerr << "Not valid channel of the LED table " << fileName << ": " << line << G4endl;
+            return false;
+        }
+
+        if(!isCounted[led])
+        {
+            fNPulses[led] += nPulses;
+            fNPhotons[led] += nPhotons;
+            isCounted[led] = true;
+        }
+        size_t i = static_cast<size_t>(led)*nChannels + faceIndex*GS::nOfSiPMs + ch;
+        fSum[i] += sum;
+        fSum2[i] += sum2;
+    }
+
+    return true;
+}
+
+
+
+G4String MyLEDStats::GetLEDName(G4int led)
+{
+    return G4String(faceNames[led/4]) + holeNames[led%4];
+}
+
+
+
+G4int MyLEDStats::FindLED(const G4String &face, const G4String &hole)
+{
+    for(G4int led = 0; led < nLEDs; led++)
+        if(face == faceNames[led/4] && hole == holeNames[led%4])
+            return led;
+    return -1;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file lightmap.cc
+ * @brief Definition of the classes @ref MyLightMapBinning and
+ * @ref MyLightMap
+ */
+#include "lightmap.hh"
+
+#include <map>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "G4AutoLock.hh"
+#include "Randomize.hh"
+
+namespace
+{
+    G4Mutex lightMapMutex = G4MUTEX_INITIALIZER;
+    std::map<G4String, std::shared_ptr<const MyLightMap>> openedLightMaps;
+}
+
+
+
+G4int MyLightMapBinning::GetVoxel(const G4ThreeVector &localPos) const
+{
+    G4double r2 = localPos.perp2();
+    if(r2 >= radius*radius || std::abs(localPos.z()) >= halfHeight)
+        return -1;
+
+    // Equal-area radial bins
+    G4int iR = static_cast<G4int>(nR*r2/(radius*radius));
+
+    G4double phi = localPos.phi();
+    if(phi < 0) phi += CLHEP::twopi;
+    G4int iPhi = std::min(static_cast<G4int>(nPhi*phi/CLHEP::twopi), nPhi - 1);
+
+    G4int iZ = static_cast<G4int>(nZ*(localPos.z() + halfHeight)/(2*halfHeight));
+
+    return (iR*nPhi + iPhi)*nZ + iZ;
+}
+
+
+
+G4ThreeVector MyLightMapBinning::SampleInVoxel(G4int voxel) const
+{
+    G4int iZ = voxel%nZ;
+    G4int iPhi = (voxel/nZ)%nPhi;
+    G4int iR = voxel/(nZ*nPhi);
+
+    G4double r = radius*std::sqrt((iR + G4UniformRand())/nR);
+    G4double phi = CLHEP::twopi*(iPhi + G4UniformRand())/nPhi;
+    G4double z = -halfHeight + 2*halfHeight*(iZ + G4UniformRand())/nZ;
+
+    return G4ThreeVector(r*std::cos(phi), r*std::sin(phi), z);
+}
+
+
+
+G4int MyLightMapBinning::GetTimeBin(G4double time) const
+{
+    return std::min(std::max(static_cast<G4int>(nT*time/tMax), 0), nT - 1);
+}
+
+
+
+G4bool MyLightMapBinning::operator==(const MyLightMapBinning &right) const
+{
+    return nR == right.nR && nPhi == right.nPhi && nZ == right.nZ && nT == right.nT && radius == right.radius && halfHeight == right.halfHeight && tMax == right.tMax;
+}
+
+
+
+G4bool MyLightMapGeometry::operator==(const MyLightMapGeometry &right) const
+{
+    return isGrease == right.isGrease && (!isGrease || isOpticalGreaseSurface == right.isOpticalGreaseSurface) && isLightGuide == right.isLightGuide && (!isLightGuide || lightGuideMaterial == right.lightGuideMaterial) && isPCB == right.isPCB && isEndcap == right.isEndcap &&
+           efficiencySetting == right.efficiencySetting && pdeChecksum == right.pdeChecksum && activeArea == right.activeArea;
+}
+
+
+
+MyLightMap::~MyLightMap()
+{
+    if(fData)
+        munmap(fData, fSize);
+}
+
+
+
+std::shared_ptr<const MyLightMap> MyLightMap::Open(const G4String &fileName, const MyLightMapGeometry &geometry)
+{
+    G4AutoLock lock(&lightMapMutex);
+
+    // Already mapped by another thread?
+    auto it = openedLightMaps.find(fileName);
+    if(it != openedLightMaps.end())
+        return it->second;
+
+    std::shared_ptr<MyLightMap> lightMap(new MyLightMap());
+    if(!lightMap->Map(fileName))
+    {
+        G4Exception("MyLightMap::Open()", "LightMap001", FatalException, ("Can't use the light map " + fileName).c_str());
+        return nullptr;
+    }
+
+    // Refuse a map built with a different construction
+    if(!(lightMap->fGeometry == geometry))
+    {
+        G4Exception("MyLightMap::Open()", "LightMap002", FatalException, ("The light map " + fileName + " has been built with different construction or SiPM settings (grease, grease surface, light guide, PCB, endcap, PDE or active area)").c_str());
+        return nullptr;
+    }
+
+    G4cout << "\n Light map mapped from " << fileName << " successfully: " << lightMap->fBinning.nR << "x" << lightMap->fBinning.nPhi << "x" << lightMap->fBinning.nZ << " voxels. \n" << G4endl;
+
+    openedLightMaps[fileName] = lightMap;
+    return lightMap;
+}
+
+
+
+G4bool MyLightMap::Map(const G4String &fileName)
+{
+    // Open the file
+    G4int fd = open(fileName.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        G4cerr << "Can't open the light map file " << fileName << "!" << G4endl;
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(MyLightMapHeader))
+    {
+        G4cerr << "The light map " << fileName << " is not valid!" << G4endl;
+        close(fd);
+        return false;
+    }
+
+    // Map it read-only: the pages are shared by all the threads
+    fSize = fileStat.st_size;
+    void *data = mmap(nullptr, fSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        G4cerr << "Can't map the light map file " << fileName << "!" << G4endl;
+        return false;
+    }
+    fData = data;
+
+    // Validate the header
+    const MyLightMapHeader *header = static_cast<const MyLightMapHeader*>(fData);
+    if(std::memcmp(header->magic, "LYSOLMAP", 8) != 0 || header->headerSize != sizeof(MyLightMapHeader))
+    {
+        G4cerr << fileName << " is not a light map file!" << G4endl;
+        return false;
+    }
+    if(header->version != formatVersion)
+    {
+        G4cerr << "The light map " << fileName << " has format version " << header->version << ", expected " << formatVersion << "!" << G4endl;
+        return false;
+    }
+
+    fBinning.nR = header->nR;
+    fBinning.nPhi = header->nPhi;
+    fBinning.nZ = header->nZ;
+    fBinning.nT = header->nT;
+    fBinning.radius = header->radius;
+    fBinning.halfHeight = header->halfHeight;
+    fBinning.tMax = header->tMax;
+    fGeometry = header->geometry;
+
+    size_t nCumProb = static_cast<size_t>(fBinning.GetNVoxels())*nChannels;
+    size_t nTimeCDF = nCumProb*fBinning.nT;
+    if(header->nChannels != nChannels || header->fileSize != fSize || header->cumProbOffset + nCumProb*sizeof(float) > fSize || header->timeCDFOffset + nTimeCDF*sizeof(float) > fSize)
+    {
+        G4cerr << "The light map " << fileName << " is truncated or inconsistent!" << G4endl;
+        return false;
+    }
+
+    fCumProb = reinterpret_cast<const float*>(static_cast<const char*>(fData) + header->cumProbOffset);
+    fTimeCDF = reinterpret_cast<const float*>(static_cast<const char*>(fData) + header->timeCDFOffset);
+
+    return true;
+}
+
+
+
+G4bool MyLightMap::SampleHit(G4int voxel, G4double scale, G4int &channel, G4double &time) const
+{
+    const float *cumProb = fCumProb + static_cast<size_t>(voxel)*nChannels;
+
+    // Is the photon detected at all?
+    G4double u = G4UniformRand()*scale;
+    if(u >= cumProb[nChannels - 1])
+        return false;
+
+    // Which channel
+    channel = std::upper_bound(cumProb, cumProb + nChannels, static_cast<float>(u)) - cumProb;
+
+    // Arrival time: choose the bin, then uniform inside it
+    const G4int nT = fBinning.nT;
+    const float *timeCDF = fTimeCDF + (static_cast<size_t>(voxel)*nChannels + channel)*nT;
+    G4double v = G4UniformRand();
+    G4int bin = std::min(static_cast<G4int>(std::upper_bound(timeCDF, timeCDF + nT, static_cast<float>(v)) - timeCDF), nT - 1);
+    time = (bin + G4UniformRand())*fBinning.tMax/nT;
+
+    return true;
+}
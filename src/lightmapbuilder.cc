@@ -0,0 +1,286 @@
+/**
+ * @file lightmapbuilder.cc
+ * @brief Definition of the class @ref MyLightMapBuilder
+ */
+#include "lightmapbuilder.hh"
+
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+    /** @brief Header of the raw counters file, followed by the name of the map file and by the counters.*/
+    struct MyLightMapCountsHeader
+    {
+        char          magic[8]; // Always "LYSOLCNT"
+        std::uint32_t version, headerSize;
+        std::int32_t  nR, nPhi, nZ, nT;
+        MyLightMapGeometry geometry;
+        double        radius, halfHeight, tMax;
+        std::uint64_t nameLength;
+    };
+}
+
+MyLightMapBuilder::MyLightMapBuilder() : G4VAccumulable("LightMap")
+{
+    fFileName = "lightmap.bin";
+
+    // Define my UD-messenger for the light map
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/lightMap/", "Settings of the light map built in light map mode");
+    fMessenger->DeclareProperty("nR", fBinning.nR, "Set the number of (equal-area) radial bins of the map");
+    fMessenger->DeclareProperty("nPhi", fBinning.nPhi, "Set the number of azimuthal bins of the map");
+    fMessenger->DeclareProperty("nZ", fBinning.nZ, "Set the number of bins of the map along the crystal axis");
+    fMessenger->DeclareProperty("nT", fBinning.nT, "Set the number of bins of the arrival time distributions");
+    fMessenger->DeclarePropertyWithUnit("tMax", "ns", fBinning.tMax, "Set the upper edge of the arrival time distributions");
+    fMessenger->DeclareProperty("fileName", fFileName, "Set the output file of the map");
+}
+
+
+
+MyLightMapBuilder::~MyLightMapBuilder()
+{
+    delete fMessenger;
+}
+
+
+
+void MyLightMapBuilder::Book()
+{
+    fBookedBinning = fBinning;
+    fEmitted.assign(fBinning.GetNVoxels(), 0);
+    fCounts.assign(static_cast<size_t>(fBinning.GetNVoxels())*MyLightMap::nChannels*fBinning.nT, 0);
+}
+
+
+
+void MyLightMapBuilder::CountEmission(G4int voxel)
+{
+    if(fEmitted.empty())
+        Book();
+
+    fEmitted[voxel]++;
+}
+
+
+
+void MyLightMapBuilder::Fill(G4int voxel, G4int channel, G4double time)
+{
+    if(fEmitted.empty())
+        Book();
+
+    fCounts[(static_cast<size_t>(voxel)*MyLightMap::nChannels + channel)*fBookedBinning.nT + fBookedBinning.GetTimeBin(time)]++;
+}
+
+
+
+void MyLightMapBuilder::Merge(const G4VAccumulable &other)
+{
+    const MyLightMapBuilder &otherBuilder = static_cast<const MyLightMapBuilder&>(other);
+    if(!otherBuilder.HasEntries())
+        return;
+
+    // The master adopts the binning of the workers
+    if(fEmitted.empty())
+    {
+        fBinning = otherBuilder.fBookedBinning;
+        Book();
+    }
+    else if(!(fBookedBinning == otherBuilder.fBookedBinning))
+    {
+        G4Exception("MyLightMapBuilder::Merge()", "LightMap101", JustWarning, "Workers have different light map binnings, counters not merged");
+        return;
+    }
+
+    for(size_t i = 0; i < fEmitted.size(); i++)
+        fEmitted[i] += otherBuilder.fEmitted[i];
+    for(size_t i = 0; i < fCounts.size(); i++)
+        fCounts[i] += otherBuilder.fCounts[i];
+}
+
+
+
+void MyLightMapBuilder::Reset()
+{
+    fEmitted.clear();
+    fEmitted.shrink_to_fit();
+    fCounts.clear();
+    fCounts.shrink_to_fit();
+}
+
+
+
+void MyLightMapBuilder::Write(const MyLightMapGeometry &geometry) const
+{
+    const G4int nVoxels = fBookedBinning.GetNVoxels();
+    const G4int nChannels = MyLightMap::nChannels;
+    const G4int nT = fBookedBinning.nT;
+
+    // Normalize the counters
+    std::vector<float> cumProb(static_cast<size_t>(nVoxels)*nChannels, 0.f);
+    std::vector<float> timeCDF(static_cast<size_t>(nVoxels)*nChannels*nT, 0.f);
+    std::uint64_t nEmitted = 0;
+    G4int nEmptyVoxels = 0;
+
+    for(G4int v = 0; v < nVoxels; v++)
+    {
+        nEmitted += fEmitted[v];
+        if(!fEmitted[v]) nEmptyVoxels++;
+
+        G4double cumulative = 0.;
+        for(G4int k = 0; k < nChannels; k++)
+        {
+            size_t index = static_cast<size_t>(v)*nChannels + k;
+            const std::uint32_t *counts = &fCounts[index*nT];
+
+            std::uint64_t nDetected = 0;
+            for(G4int b = 0; b < nT; b++)
+                nDetected += counts[b];
+
+            cumulative += fEmitted[v] ? static_cast<G4double>(nDetected)/fEmitted[v] : 0.;
+            cumProb[index] = cumulative;
+
+            // Channels never hit get a flat distribution, they're never sampled anyway
+            std::uint64_t partial = 0;
+            for(G4int b = 0; b < nT; b++)
+            {
+                partial += counts[b];
+                timeCDF[index*nT + b] = nDetected ? static_cast<G4double>(partial)/nDetected : static_cast<G4double>(b + 1)/nT;
+            }
+        }
+    }
+
+    if(nEmptyVoxels)
+        G4cerr << "Warning: " << nEmptyVoxels << " voxels of the light map have no emitted photons!" << G4endl;
+
+    // Fill the header. The tables start at 64-byte aligned offsets
+    auto align = [](std::uint64_t offset) { return (offset + 63)/64*64; };
+
+    MyLightMapHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "LYSOLMAP", 8);
+    header.version = MyLightMap::formatVersion;
+    header.headerSize = sizeof(MyLightMapHeader);
+    header.nR = fBookedBinning.nR;
+    header.nPhi = fBookedBinning.nPhi;
+    header.nZ = fBookedBinning.nZ;
+    header.nT = nT;
+    header.nChannels = nChannels;
+    header.geometry = geometry;
+    header.radius = fBookedBinning.radius;
+    header.halfHeight = fBookedBinning.halfHeight;
+    header.tMax = fBookedBinning.tMax;
+    header.nEmitted = nEmitted;
+    header.cumProbOffset = align(sizeof(MyLightMapHeader));
+    header.timeCDFOffset = align(header.cumProbOffset + cumProb.size()*sizeof(float));
+    header.fileSize = header.timeCDFOffset + timeCDF.size()*sizeof(float);
+
+    // Write the file
+    std::ofstream file(fFileName, std::ios::binary);
+    if(!file.is_open())
+    {
+        G4cerr << "Can't open the file " << fFileName << "!" << G4endl;
+        return;
+    }
+
+    const char padding[64] = {0};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, header.cumProbOffset - sizeof(header));
+    file.write(reinterpret_cast<const char*>(cumProb.data()), cumProb.size()*sizeof(float));
+    file.write(padding, header.timeCDFOffset - (header.cumProbOffset + cumProb.size()*sizeof(float)));
+    file.write(reinterpret_cast<const char*>(timeCDF.data()), timeCDF.size()*sizeof(float));
+    file.close();
+
+    G4cout << "\n Light map written to " << fFileName << ": " << nEmitted << " photons emitted in " << nVoxels << " voxels. \n" << G4endl;
+}
+
+
+
+void MyLightMapBuilder::WriteCounts(const G4String &fileName, const MyLightMapGeometry &geometry) const
+{
+    MyLightMapCountsHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "LYSOLCNT", 8);
+    header.version = MyLightMap::formatVersion;
+    header.headerSize = sizeof(MyLightMapCountsHeader);
+    header.nR = fBookedBinning.nR;
+    header.nPhi = fBookedBinning.nPhi;
+    header.nZ = fBookedBinning.nZ;
+    header.nT = fBookedBinning.nT;
+    header.geometry = geometry;
+    header.radius = fBookedBinning.radius;
+    header.halfHeight = fBookedBinning.halfHeight;
+    header.tMax = fBookedBinning.tMax;
+    header.nameLength = fFileName.size();
+
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file.is_open())
+    {
+        G4cerr << "Can't open the file " << fileName << "!" << G4endl;
+        return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(fFileName.data(), fFileName.size());
+    file.write(reinterpret_cast<const char*>(fEmitted.data()), fEmitted.size()*sizeof(std::uint64_t));
+    file.write(reinterpret_cast<const char*>(fCounts.data()), fCounts.size()*sizeof(std::uint32_t));
+    file.close();
+
+    G4cout << "Light map counters written to " << fileName << ", to be merged into " << fFileName << G4endl;
+}
+
+
+
+G4bool MyLightMapBuilder::ReadCounts(const G4String &fileName, MyLightMapGeometry &geometry)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    MyLightMapCountsHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "LYSOLCNT", 8) ||
+       header.version != MyLightMap::formatVersion || header.headerSize != sizeof(MyLightMapCountsHeader))
+    {
+        G4cerr << "Error: " << fileName << " is not a valid light map counters file." << G4endl;
+        return false;
+    }
+
+    std::string mapName(header.nameLength, ' ');
+    file.read(&mapName[0], header.nameLength);
+
+    MyLightMapBinning binning;
+    binning.nR = header.nR;
+    binning.nPhi = header.nPhi;
+    binning.nZ = header.nZ;
+    binning.nT = header.nT;
+    binning.radius = header.radius;
+    binning.halfHeight = header.halfHeight;
+    binning.tMax = header.tMax;
+
+    // The first file sets the map, the others must match it
+    if(fEmitted.empty())
+    {
+        fBinning = binning;
+        fFileName = mapName;
+        geometry = header.geometry;
+        Book();
+    }
+    else if(!(fBookedBinning == binning) || !(geometry == header.geometry) || fFileName != mapName)
+    {
+        G4cerr << "Error: the light map counters of " << fileName << " don't match the ones read before." << G4endl;
+        return false;
+    }
+
+    std::vector<std::uint64_t> emitted(fEmitted.size());
+    std::vector<std::uint32_t> counts(fCounts.size());
+    file.read(reinterpret_cast<char*>(emitted.data()), emitted.size()*sizeof(std::uint64_t));
+    file.read(reinterpret_cast<char*>(counts.data()), counts.size()*sizeof(std::uint32_t));
+    if(!file)
+    {
+        G4cerr << "Error: the light map counters file " << fileName << " is truncated." << G4endl;
+        return false;
+    }
+
+    for(size_t i = 0; i < fEmitted.size(); i++)
+        fEmitted[i] += emitted[i];
+    for(size_t i = 0; i < fCounts.size(); i++)
+        fCounts[i] += counts[i];
+
+    return true;
+}
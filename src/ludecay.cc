@@ -0,0 +1,93 @@
+/**
+ * @file ludecay.cc
+ * @brief Definition of the class @ref MyLuDecaySampler
+ */
+#include "ludecay.hh"
+
+#include <cmath>
+#include <vector>
+
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "Randomize.hh"
+
+namespace
+{
+    // 176Lu -> 176Hf(596.8 keV) beta- branch
+    constexpr G4double endpointEnergy = 1194.1*keV - 596.8*keV;
+    constexpr G4int daughterZ = 72;
+
+    // Cascade of the 176Hf levels: energy and probability to emit the gamma
+    // (measured intensity per decay over the intensity of the branch)
+    constexpr G4int nTransitions = 3;
+    constexpr G4double transitionEnergy[nTransitions] = {306.8*keV, 201.8*keV, 88.3*keV};
+    constexpr G4double gammaProbability[nTransitions] = {0.939, 0.783, 0.145};
+
+    // K shell of Hf, for the converted transitions
+    constexpr G4double bindingEnergyK = 65.35*keV;
+    constexpr G4double energyKalpha = 55.79*keV;
+}
+
+
+
+MyLuDecaySampler::MyLuDecaySampler()
+{
+    fBinWidth = endpointEnergy/nBins;
+
+    // Allowed shape at the centers of the bins, energies in units of mc^2
+    G4double etaScale = daughterZ*fine_structure_const;
+    G4double w0 = 1. + endpointEnergy/electron_mass_c2;
+    std::vector<G4double> weights(nBins);
+    for(G4int i = 0; i < nBins; i++)
+    {
+        G4double w = 1. + (i + 0.5)*fBinWidth/electron_mass_c2;
+        G4double p = std::sqrt(w*w - 1.);
+        G4double twoPiEta = CLHEP::twopi*etaScale*w/p;
+        G4double fermi = twoPiEta/(1. - std::exp(-twoPiEta));
+        weights[i] = p*w*(w0 - w)*(w0 - w)*fermi;
+    }
+    fBetaTable.Build(weights);
+}
+
+
+
+void MyLuDecaySampler::GenerateDecay(G4PrimaryVertex *vertex) const
+{
+    AddIsotropic(vertex, false, SampleBetaEnergy());
+
+    for(G4int i = 0; i < nTransitions; i++)
+    {
+        if(G4UniformRand() < gammaProbability[i])
+            AddIsotropic(vertex, true, transitionEnergy[i]);
+        else
+        {
+            AddIsotropic(vertex, false, transitionEnergy[i] - bindingEnergyK);
+            AddIsotropic(vertex, true, energyKalpha);
+            AddIsotropic(vertex, false, bindingEnergyK - energyKalpha);
+        }
+    }
+}
+
+
+
+G4double MyLuDecaySampler::SampleBetaEnergy() const
+{
+    return (fBetaTable.Sample() + G4UniformRand())*fBinWidth;
+}
+
+
+
+void MyLuDecaySampler::AddIsotropic(G4PrimaryVertex *vertex, G4bool isGamma, G4double energy) const
+{
+    G4double cosTheta = 2*G4UniformRand() - 1.;
+    G4double phi = CLHEP::twopi*G4UniformRand();
+    G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+
+    G4PrimaryParticle *particle = new G4PrimaryParticle(isGamma ? G4Gamma::Definition() : G4Electron::Definition());
+    particle->SetKineticEnergy(energy);
+    particle->SetMomentumDirection(G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta));
+    vertex->SetPrimary(particle);
+}
@@ -0,0 +1,193 @@
+/**
+ * @file ntuple.cc
+ * @brief Definition of the output schemas and of the function
+ * @ref BookNtuple()
+ */
+#include "ntuple.hh"
+
+#include <cstring>
+
+namespace
+{
+    // Columns derivable from the others: the positions from the channels,
+    // the hits per channel from the channels, the total from the faces
+    G4bool IsDerived(const char *name)
+    {
+        for(const char *derived : {"X_F", "Y_F", "X_B", "Y_B", "NHits_F_Ch", "NHits_B_Ch", "NHits_Tot"})
+            if(std::strcmp(name, derived) == 0)
+                return true;
+        return false;
+    }
+
+    // Tells whether a column is one of the range [first, last] of NT::columns
+    constexpr G4bool IsInRange(size_t column, const char *first, const char *last)
+    {
+        return column >= NT::FindColumn(first) && column <= NT::FindColumn(last);
+    }
+
+    // The hits per channel
+    constexpr G4bool IsHitsPerChannel(size_t column)
+    {
+        return column == NT::FindColumn("NHits_F_Ch") || column == NT::FindColumn("NHits_B_Ch");
+    }
+
+    // Columns meaningless in LED mode: primary gamma (but the event ID) and crystal
+    G4bool IsGammaOrCrystal(size_t column)
+    {
+        return IsInRange(column, "PID_gun", "MaxEdepPosZ");
+    }
+
+    // Columns of the SiPMs, by the output they belong to: the hits per
+    // channel are in the photon lists, in the histograms and in the counts
+    G4bool IsInSiPMOutput(size_t column, MySiPMOutput sipmOutput)
+    {
+        if(IsHitsPerChannel(column))
+            return sipmOutput == MySiPMOutput::Photons || sipmOutput == MySiPMOutput::Binned || sipmOutput == MySiPMOutput::Counts;
+        if(IsInRange(column, "T_F", "Ch_B"))
+            return sipmOutput == MySiPMOutput::Photons;
+        if(IsInRange(column, "Charge_F", "TLead_B"))
+            return sipmOutput == MySiPMOutput::Digitized || sipmOutput == MySiPMOutput::Traces;
+        if(IsInRange(column, "Trace_F", "Trace_B"))
+            return sipmOutput == MySiPMOutput::Traces;
+        if(IsInRange(column, "TBins_F", "TBins_B"))
+            return sipmOutput == MySiPMOutput::Binned;
+        return true;
+    }
+
+    // Suffix of the name of the schemas
+    const char *GetSuffix(MySiPMOutput sipmOutput)
+    {
+        switch(sipmOutput)
+        {
+            case MySiPMOutput::Binned:
+                return "-binned";
+            case MySiPMOutput::Digitized:
+                return "-digi";
+            case MySiPMOutput::Traces:
+                return "-traces";
+            case MySiPMOutput::Counts:
+                return "-counts";
+            default:
+                return "";
+        }
+    }
+
+    // Reduced precision of the compact schemas
+    MyColumnType CompactType(size_t column)
+    {
+        const MyNtupleColumn &ntupleColumn = NT::columns[column];
+        switch(ntupleColumn.type)
+        {
+            case MyColumnType::Double:
+                return MyColumnType::Float;
+            case MyColumnType::DoubleVector:
+                return MyColumnType::FloatVector;
+            case MyColumnType::IntVector:
+                return std::strncmp(ntupleColumn.name, "Ch_", 3) == 0 ? MyColumnType::ByteVector : MyColumnType::IntVector;
+            default:
+                return ntupleColumn.type;
+        }
+    }
+
+    MyOutputSchema BuildSchema(const G4String &name, G4bool compact, G4bool led, G4bool dropDerived, MySiPMOutput sipmOutput)
+    {
+        MyOutputSchema schema;
+        schema.name = name + GetSuffix(sipmOutput);
+        for(size_t k = 0; k < NT::columns.size(); k++)
+        {
+            if((led && IsGammaOrCrystal(k)) || !IsInSiPMOutput(k, sipmOutput))
+                continue;
+            // Without the channels the hits per channel can't be derived
+            // (and count the photons out of the histograms too), they're kept
+            G4bool isHitsPerChannel = IsHitsPerChannel(k);
+            G4bool hasChannels = sipmOutput != MySiPMOutput::Binned && sipmOutput != MySiPMOutput::Counts;
+            if(dropDerived && IsDerived(NT::columns[k].name) && !(!hasChannels && isHitsPerChannel))
+                continue;
+            schema.columns.push_back({k, NT::GetSlot(k), compact ? CompactType(k) : NT::columns[k].type});
+        }
+        return schema;
+    }
+}
+
+
+
+G4String MyOutputSchema::GetTitle() const
+{
+    return G4String(NT::ntupleTitle) + " (schema " + name + " v" + std::to_string(NT::schemaVersion) + ")";
+}
+
+
+
+const std::vector<MyOutputSchema> &NT::GetSchemas()
+{
+    static const std::vector<MyOutputSchema> schemas = []()
+    {
+        std::vector<MyOutputSchema> built;
+        for(MySiPMOutput sipmOutput : {MySiPMOutput::Photons, MySiPMOutput::Binned, MySiPMOutput::Digitized, MySiPMOutput::Traces, MySiPMOutput::Counts})
+        {
+            built.push_back(BuildSchema("full", false, false, false, sipmOutput));
+            built.push_back(BuildSchema("compact", true, false, false, sipmOutput));
+            built.push_back(BuildSchema("compact-min", true, false, true, sipmOutput));
+            built.push_back(BuildSchema("led", true, true, false, sipmOutput));
+            built.push_back(BuildSchema("led-min", true, true, true, sipmOutput));
+        }
+        return built;
+    }();
+    return schemas;
+}
+
+
+
+G4int NT::FindSchema(const G4String &name, G4bool dropDerived, MySiPMOutput sipmOutput)
+{
+    G4String fullName = name;
+    if(dropDerived && name != "full")
+        fullName += "-min";
+    fullName += GetSuffix(sipmOutput);
+
+    const std::vector<MyOutputSchema> &schemas = GetSchemas();
+    for(size_t i = 0; i < schemas.size(); i++)
+        if(schemas[i].name == fullName)
+            return i;
+    return -1;
+}
+
+
+
+G4int BookNtuple(const MyOutputSchema &schema, const MyNtupleBuffers &buffers)
+{
+    G4AnalysisManager *man = G4AnalysisManager::Instance();
+
+    G4int ntupleId = man->CreateNtuple(NT::ntupleName, schema.GetTitle());
+
+    for(const auto &column : schema.columns)
+    {
+        switch(column.type)
+        {
+            case MyColumnType::Int:
+                man->CreateNtupleIColumn(ntupleId, column.GetName());
+                break;
+            case MyColumnType::Double:
+                man->CreateNtupleDColumn(ntupleId, column.GetName());
+                break;
+            case MyColumnType::Float:
+                man->CreateNtupleFColumn(ntupleId, column.GetName());
+                break;
+            // No 8-bit columns in the TTree
+            case MyColumnType::IntVector:
+            case MyColumnType::ByteVector:
+                man->CreateNtupleIColumn(ntupleId, column.GetName(), *buffers.intVectors[column.slot]);
+                break;
+            case MyColumnType::DoubleVector:
+                man->CreateNtupleDColumn(ntupleId, column.GetName(), *buffers.doubleVectors[column.slot]);
+                break;
+            case MyColumnType::FloatVector:
+                man->CreateNtupleFColumn(ntupleId, column.GetName(), *buffers.floatVectors[column.slot]);
+                break;
+        }
+    }
+
+    man->FinishNtuple(ntupleId);
+
+    return ntupleId;
+}
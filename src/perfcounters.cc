@@ -0,0 +1,42 @@
+/**
+ * @file perfcounters.cc
+ * @brief Definition of the class @ref MyPerfCounters
+ */
+#include "perfcounters.hh"
+
+#include <algorithm>
+
+void MyPerfCounters::Merge(const G4VAccumulable &other)
+{
+    const MyPerfCounters &otherCounters = static_cast<const MyPerfCounters&>(other);
+    fNEvents += otherCounters.fNEvents;
+    fNOpticalPhotons += otherCounters.fNOpticalPhotons;
+    fNSteps += otherCounters.fNSteps;
+    fNHits += otherCounters.fNHits;
+
+    fMinBusyTime = fNThreads > 0 ? std::min(fMinBusyTime, otherCounters.fBusyTime) : otherCounters.fBusyTime;
+    fMaxBusyTime = fNThreads > 0 ? std::max(fMaxBusyTime, otherCounters.fBusyTime) : otherCounters.fBusyTime;
+    fNThreads++;
+
+    fBusyTime += otherCounters.fBusyTime;
+    fOutputTime += otherCounters.fOutputTime;
+    fStreamTime += otherCounters.fStreamTime;
+    fEndOfRunTime = std::max(fEndOfRunTime, otherCounters.fEndOfRunTime);
+}
+
+
+
+void MyPerfCounters::Reset()
+{
+    fNEvents = 0;
+    fNOpticalPhotons = 0;
+    fNSteps = 0;
+    fNHits = 0;
+    fNThreads = 0;
+    fMinBusyTime = 0.;
+    fMaxBusyTime = 0.;
+    fBusyTime = 0.;
+    fOutputTime = 0.;
+    fStreamTime = 0.;
+    fEndOfRunTime = 0.;
+}
@@ -16,5 +16,59 @@ MyPhysicsList::MyPhysicsList()
     RegisterPhysics(new G4DecayPhysics());
     
     // Radioactive decay for GenericIon
-    RegisterPhysics(new G4RadioactiveDecayPhysics());
-}
\ No newline at end of file
+    fRadioactiveDecay = new G4RadioactiveDecayPhysics();
+    RegisterPhysics(fRadioactiveDecay);
+
+    // Fast simulation of optical photons (see MyFastLightModel), inactive
+    // unless a model is attached to the crystal
+    G4FastSimulationPhysics *fastSimulationPhysics = new G4FastSimulationPhysics();
+    fastSimulationPhysics->ActivateFastSimulation("opticalphoton");
+    RegisterPhysics(fastSimulationPhysics);
+
+    // Define my UD-messenger for the physics
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/physics/", "Settings of the physics list");
+    fMessenger->DeclareMethod("radioactiveDecay", &MyPhysicsList::SetRadioactiveDecay, "Simulate the radioactive decay (false with the tabulated 176Lu decay, before /run/initialize)").SetStates(G4State_PreInit);
+}
+
+
+
+MyPhysicsList::~MyPhysicsList()
+{
+    delete fMessenger;
+}
+
+
+
+void MyPhysicsList::ConstructProcess()
+{
+    G4VModularPhysicsList::ConstructProcess();
+
+    // Kill the optical photons beyond the user max time of the volume, only
+    // with a readout window: the process is invoked at every optical step
+    const MyDetectorConstruction *detectorConstruction = static_cast<const MyDetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if(detectorConstruction && detectorConstruction->IsReadoutWindow())
+    {
+        G4ProcessManager *processManager = G4OpticalPhoton::OpticalPhotonDefinition()->GetProcessManager();
+        processManager->AddDiscreteProcess(new G4UserSpecialCuts());
+    }
+}
+
+
+
+void MyPhysicsList::SetRadioactiveDecay(G4bool enable)
+{
+    if(enable == HasRadioactiveDecay())
+        return;
+
+    if(enable)
+    {
+        fRadioactiveDecay = new G4RadioactiveDecayPhysics();
+        RegisterPhysics(fRadioactiveDecay);
+    }
+    else
+    {
+        RemovePhysics(fRadioactiveDecay);
+        delete fRadioactiveDecay;
+        fRadioactiveDecay = nullptr;
+    }
+}
@@ -4,83 +4,359 @@
  */
 #include "run.hh"
 
-MyRunAction::MyRunAction(G4int theMCID, MyEventAction *eventAction) : fMCID(theMCID), fEventAction(eventAction)
+MyRunAction::MyRunAction(G4int theMCID, MyEventAction *eventAction, MyShardDriver *shardDriver) : fMCID(theMCID), fEventAction(eventAction), fShardDriver(shardDriver)
 {
     G4AnalysisManager *man = G4AnalysisManager::Instance();
 
-    // Create the TTree
-    man->CreateNtuple("lyso", "Primary Gamma, energy deposition inside the crystal and detectors output");
-    // Data of primary gamma
-    man->CreateNtupleIColumn("Event"); // entry 0
-    man->CreateNtupleIColumn("PID_gun");
-    man->CreateNtupleDColumn("E_gun");
-    man->CreateNtupleDColumn("X_gun");
-    man->CreateNtupleDColumn("Y_gun");
-    man->CreateNtupleDColumn("Z_gun"); // entry 5
-    man->CreateNtupleDColumn("MomX_gun");
-    man->CreateNtupleDColumn("MomY_gun");
-    man->CreateNtupleDColumn("MomZ_gun");
-    man->CreateNtupleDColumn("ToA");
-    man->CreateNtupleDColumn("XoA"); // entry 10
-    man->CreateNtupleDColumn("YoA");
-    man->CreateNtupleDColumn("ZoA");
-    man->CreateNtupleDColumn("ToFI");
-    man->CreateNtupleDColumn("XoFI");
-    man->CreateNtupleDColumn("YoFI"); // entry 15
-    man->CreateNtupleDColumn("ZoFI"); 
-    // Data of energy deposition inside the crystal
-    man->CreateNtupleDColumn("Edep");
-    man->CreateNtupleDColumn("MaxEdep");
-    man->CreateNtupleDColumn("MaxEdepPosX");
-    man->CreateNtupleDColumn("MaxEdepPosY"); // entry 20
-    man->CreateNtupleDColumn("MaxEdepPosZ"); 
-    // Data of detectors
-    man->CreateNtupleIColumn("NHits_F");
-    man->CreateNtupleIColumn("NHits_B");
-    man->CreateNtupleIColumn("NHits_Tot");
-    man->CreateNtupleIColumn("NHits_F_Ch", fEventAction->fHitsNum_F_Ch); // entry 25
-    man->CreateNtupleDColumn("T_F", fEventAction->fT_F);
-    man->CreateNtupleDColumn("X_F", fEventAction->fX_F);
-    man->CreateNtupleDColumn("Y_F", fEventAction->fY_F);
-    man->CreateNtupleIColumn("Ch_F", fEventAction->fChannel_F);
-    man->CreateNtupleIColumn("NHits_B_Ch", fEventAction->fHitsNum_B_Ch);
-    man->CreateNtupleDColumn("T_B", fEventAction->fT_B); // entry 30
-    man->CreateNtupleDColumn("X_B", fEventAction->fX_B);
-    man->CreateNtupleDColumn("Y_B", fEventAction->fY_B);
-    man->CreateNtupleIColumn("Ch_B", fEventAction->fChannel_B);
-
-    man->FinishNtuple(0);
+    // The workers' rows (MT or tasking) are merged by the master into one
+    // file per run, while the run goes on. Row-wise, for the vector columns
+    if(G4Threading::IsMultithreadedApplication())
+        man->SetNtupleMerging(true);
+    man->SetNtupleRowWise(true);
+
+    // The TTrees of the output schemas (see ntuple.hh) are booked by the
+    // first run writing them
+    man->SetActivation(true);
+    fNtupleIDs.assign(NT::GetSchemas().size(), -1);
+
+    // The event action hands its records to this run action
+    fEventAction->SetRunAction(this);
+
+    // Register the accumulables
+    G4AccumulableManager *accumulableManager = G4AccumulableManager::Instance();
+    accumulableManager->RegisterAccumulable(&fEventAction->fLightMapBuilder);
+    accumulableManager->RegisterAccumulable(&fEventAction->fPerfCounters);
+    accumulableManager->RegisterAccumulable(&fEventAction->fLEDStats);
+    accumulableManager->RegisterAccumulable(&fEventAction->fRunStats);
+
+    // Define my UD-messenger for the output
+    fOutputDirectory = "RootFiles";
+    fFormat = "root";
+    fSchemaName = "full";
+    fDropDerived = false;
+    fSchemaID = 0;
+    fCompress = false;
+    fChunkSize = 1000;
+    fQueueSize = 4096;
+    fNTimeBins = 0;
+    fTimeBinWidth = 0.5*ns;
+    fTimeBinStart = 0.;
+    fCountsOnly = false;
+    fWriteNtuple = true;
+    fRunWritesNtuple = true;
+    fColumnar = false;
+    fAsync = false;
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/output/", "Output settings");
+    fMessenger->DeclareProperty("directory", fOutputDirectory, "Set the directory of the output files");
+    fMessenger->DeclareProperty("format", fFormat, "Set the format of the output files: root (TTree) or columnar").SetCandidates("root columnar");
+    fMessenger->DeclareProperty("schema", fSchemaName, "Set the output schema: full (all the columns, doubles), compact (floats and 8-bit channels) or led (compact, without the primary gamma and crystal columns, for the LED modes)").SetCandidates("full compact led");
+    fMessenger->DeclareProperty("dropDerived", fDropDerived, "Drop the columns derivable from the others from the compact schemas (SiPM positions, hits per channel, total hits)");
+    fMessenger->DeclareProperty("compress", fCompress, "Delta-varint encode the integer columns of the columnar files");
+    fMessenger->DeclareProperty("chunkSize", fChunkSize, "Set the number of events per chunk of the columnar files").SetParameterRange("chunkSize>0");
+    fMessenger->DeclareProperty("queueSize", fQueueSize, "Set the capacity of the queue of the columnar writer thread (0 = no writer thread, every thread writes its chunks)").SetParameterRange("queueSize>=0");
+    fMessenger->DeclareProperty("timeBins", fNTimeBins, "Write the arrival time histograms of the channels with this number of bins instead of the photon lists (0 = photon lists)").SetParameterRange("timeBins>=0");
+    fMessenger->DeclarePropertyWithUnit("timeBinWidth", "ns", fTimeBinWidth, "Set the width of the bins of the arrival time histograms");
+    fMessenger->DeclarePropertyWithUnit("timeBinStart", "ns", fTimeBinStart, "Set the lower edge of the arrival time histograms");
+    fMessenger->DeclareProperty("countsOnly", fCountsOnly, "Write only the number of photons detected by every channel instead of the photon lists (e.g. for the LED pulses)");
+    fMessenger->DeclareProperty("ntuple", fWriteNtuple, "Write the events in the ntuple (false = only the tables of the run, e.g. /MC_LYSO/stats/enable)");
+}
+
+
+
+MyRunAction::~MyRunAction()
+{
+    delete fMessenger;
 }
 
 
 
 void MyRunAction::BeginOfRunAction(const G4Run* run)
 {
-    // Create and open the file root
+    // Reset the accumulables
+    G4AccumulableManager::Instance()->Reset();
+
+    // Choose the scoring of the run mode
+    ActivateScoring();
+
+    // The event loop is timed by the master, the waits by every thread
+    if(IsMaster())
+        MyBenchmark::Instance()->BeginRun();
+    if(MyBenchmark::Instance()->IsTimingStreams())
+    {
+        fCoutTimer.Install(G4cout);
+        fCerrTimer.Install(G4cerr);
+    }
+
+    // Choose the output of the SiPMs: the digitizer or the histograms
+    // replace the photon lists
+    const MyDigitizer &digitizer = fEventAction->fDigitizer;
+    // The settings are resolved for this run only, the ones of the
+    // messenger are kept for the next runs
+    G4int nTimeBins = fNTimeBins;
+    if(nTimeBins > 0 && fTimeBinWidth <= 0.)
+    {
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output004", JustWarning, "The bins of the arrival time histograms must have a positive width, the photon lists are written");
+        nTimeBins = 0;
+    }
+    if(nTimeBins > 0 && digitizer.IsEnabled())
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output005", JustWarning, "The digitizer is enabled, the arrival time histograms are not written");
+    if(fCountsOnly && (nTimeBins > 0 || digitizer.IsEnabled()))
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output006", JustWarning, "The digitizer or the arrival time histograms are written, not only the hits per channel");
+
+    MySiPMOutput sipmOutput = MySiPMOutput::Photons;
+    if(digitizer.IsEnabled())
+        sipmOutput = digitizer.SavesTraces() ? MySiPMOutput::Traces : MySiPMOutput::Digitized;
+    else if(nTimeBins > 0)
+        sipmOutput = MySiPMOutput::Binned;
+    else if(fCountsOnly)
+        sipmOutput = MySiPMOutput::Counts;
+    fEventAction->SetTimeBinning(sipmOutput == MySiPMOutput::Binned ? nTimeBins : 0, fTimeBinWidth, fTimeBinStart);
+    fEventAction->SetCountsOnly(sipmOutput == MySiPMOutput::Counts);
+
+    // Choose the output schema, the same in every thread
+    fSchemaID = NT::FindSchema(fSchemaName, fDropDerived, sipmOutput);
+    if(fSchemaID < 0)
+    {
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output002", JustWarning, "Unknown output schema, the full one is used");
+        fSchemaID = 0;
+    }
+    const MyOutputSchema &schema = NT::GetSchemas()[fSchemaID];
+
+    // Create and open the file root, directly in the output directory
     G4AnalysisManager *man = G4AnalysisManager::Instance();
 
+    if(IsMaster())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(fOutputDirectory, error);
+        if(error)
+            G4cerr << "Can't create the output directory " << fOutputDirectory << ": " << error.message() << G4endl;
+    }
+
     std::stringstream strMCID;
     strMCID << fMCID;
 
-    G4int runID = run->GetRunID();
+    // A driven macro runs every /run/beamOn in blocks, the file of the run
+    // is named after its /run/beamOn
+    G4int runID = fShardDriver ? fShardDriver->GetRunID() : run->GetRunID();
     std::stringstream strRunID;
     strRunID << runID;
 
-    if(!runID)
-        man->OpenFile("MCID_" + strMCID.str() + ".root");
-    else
+    G4String fileName = fOutputDirectory + "/MCID_" + strMCID.str();
+    if(runID)
+        fileName += "_RunID_" + strRunID.str();
+    if(fShardDriver)
+        fileName += fShardDriver->GetFileSuffix();
+
+    fBaseName = fileName;
+
+    // Without the ntuple no file is opened, but the merge of the shards
+    // needs one per block
+    fRunWritesNtuple = fWriteNtuple;
+    if(!fRunWritesNtuple && fShardDriver && fShardDriver->NeedsMerge())
+    {
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output007", JustWarning, "The shards are merged from their ntuples, the ntuple is written");
+        fRunWritesNtuple = true;
+    }
+    if(!fRunWritesNtuple && !fEventAction->fRunStats.IsEnabled())
+        G4Exception("MyRunAction::BeginOfRunAction()", "Output008", JustWarning, "Neither the ntuple nor the statistics of the run are written, only the tables of the LED and light map modes");
+    fEventAction->SetWriteNtuple(fRunWritesNtuple);
+
+    // The columnar file is shared by the threads, the master owns it and
+    // the writer thread, if any
+    fColumnar = fRunWritesNtuple && fFormat == "columnar";
+    fAsync = fColumnar && fQueueSize > 0;
+    fChunk.SetSchema(schema);
+    if(fColumnar)
     {
-        man->OpenFile("MCID_" + strMCID.str() + "_RunID_" + strRunID.str() + ".root");
+        fFileName = fileName + ".lysc";
+        if(IsMaster())
+        {
+            if(!MyColumnarWriter::Instance()->Open(fFileName, fCompress, schema))
+                G4Exception("MyRunAction::BeginOfRunAction()", "Output001", JustWarning, "The columnar file can't be created, the events of the run are lost");
+            if(fAsync)
+                MyAsyncWriter::Instance()->Start(fQueueSize, fChunkSize, schema);
+        }
     }
+    else if(fRunWritesNtuple)
+    {
+        fFileName = fileName + ".root";
+
+        // Book the TTree of the schema, in the same order in every thread
+        // since the schema is. The vectors are bound to the buffers of the
+        // record of the event action, the float vectors to their copies
+        if(fNtupleIDs[fSchemaID] < 0)
+        {
+            const MyEventRecord &record = fEventAction->GetRecord();
+            MyNtupleBuffers buffers;
+            buffers.intVectors = record.intVectors;
+            buffers.doubleVectors = record.doubleVectors;
+            for(size_t i = 0; i < NT::nDoubleVectors; i++)
+                buffers.floatVectors[i] = &fFloatVectors[i];
+            fNtupleIDs[fSchemaID] = BookNtuple(schema, buffers);
+        }
+
+        // Only the TTree of the run is activated, i.e. written
+        for(size_t i = 0; i < fNtupleIDs.size(); i++)
+            if(fNtupleIDs[i] >= 0)
+                man->SetNtupleActivation(fNtupleIDs[i], static_cast<G4int>(i) == fSchemaID);
+        man->OpenFile(fFileName);
+    }
+    else
+        fFileName.clear();
 }
 
 
 
 void MyRunAction::EndOfRunAction(const G4Run* run)
 {
+    auto endOfRunStart = std::chrono::steady_clock::now();
+
     // Write TTree and close root file
     G4AnalysisManager *man = G4AnalysisManager::Instance();
 
-    man->Write();
-    man->CloseFile();
-}
\ No newline at end of file
+    if(fColumnar)
+    {
+        // The workers end their runs before the master
+        MyColumnarWriter::Instance()->Append(fChunk);
+        fChunk.Clear();
+        if(IsMaster())
+        {
+            MyAsyncWriter::Instance()->Stop();
+            MyColumnarWriter::Instance()->Close();
+        }
+    }
+    else if(fRunWritesNtuple)
+    {
+        man->Write();
+        man->CloseFile();
+    }
+
+    // Record the file of the block in the manifest: it's the checkpoint
+    if(IsMaster() && fShardDriver)
+        fShardDriver->AddOutputFile(run->GetNumberOfEvent(), fFileName, NT::GetSchemas()[fSchemaID].name);
+
+    // The timers of the thread stop before the merge
+    MyPerfCounters &counters = fEventAction->fPerfCounters;
+    fCoutTimer.Uninstall();
+    fCerrTimer.Uninstall();
+    counters.fStreamTime += fCoutTimer.GetTime() + fCerrTimer.GetTime();
+    if(!IsMaster())
+        counters.fEndOfRunTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - endOfRunStart).count();
+
+    // Merge the accumulables of the workers into the master ones
+    G4AccumulableManager::Instance()->Merge();
+
+    // Write the light map, if built in this run: the shards and the blocks
+    // write their counters next to the output, the map is built by the merge
+    if(IsMaster() && fEventAction->fLightMapBuilder.HasEntries())
+    {
+        const MyDetectorConstruction *detectorConstruction = static_cast<const MyDetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        if(fShardDriver && fShardDriver->NeedsMerge())
+            fEventAction->fLightMapBuilder.WriteCounts(fBaseName + "_lightmap.counts", detectorConstruction->GetLightMapGeometry());
+        else
+            fEventAction->fLightMapBuilder.Write(detectorConstruction->GetLightMapGeometry());
+    }
+
+    // Write the LED table, if some LED was fired in this run, next to the output
+    if(IsMaster() && fEventAction->fLEDStats.HasEntries())
+        fEventAction->fLEDStats.Write(fBaseName + "_LED.txt");
+
+    // Write the statistics of the run, if enabled
+    if(IsMaster() && fEventAction->fRunStats.HasEntries())
+        fEventAction->fRunStats.Write(fBaseName + "_stats.txt");
+
+    // Throughput of the run, with the size of its output and the time of
+    // the merge
+    if(IsMaster())
+    {
+        std::error_code error;
+        std::uintmax_t outputBytes = std::filesystem::file_size(fFileName, error);
+        G4double mergeTime = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - endOfRunStart).count();
+        MyBenchmark::Instance()->EndRun(counters, error ? 0 : outputBytes, mergeTime);
+    }
+}
+
+
+
+void MyRunAction::WriteEvent(MyEventRecord &record)
+{
+    // Locks of the analysis manager or of the columnar file included
+    MyScopeTimer outputTimer(fEventAction->fPerfCounters.fOutputTime);
+
+    if(fAsync)
+    {
+        MyAsyncWriter::Instance()->Submit(record);
+        return;
+    }
+
+    if(fColumnar)
+    {
+        fChunk.Add(record);
+        if(fChunk.GetNEvents() >= fChunkSize)
+        {
+            MyColumnarWriter::Instance()->Append(fChunk);
+            fChunk.Clear();
+        }
+        return;
+    }
+
+    // The vector columns are bound to the buffers of the record, but the
+    // reduced-precision ones
+    G4AnalysisManager *man = G4AnalysisManager::Instance();
+    const MyOutputSchema &schema = NT::GetSchemas()[fSchemaID];
+    G4int ntupleId = fNtupleIDs[fSchemaID];
+
+    for(size_t k = 0; k < schema.columns.size(); k++)
+    {
+        const MyOutputColumn &column = schema.columns[k];
+        switch(column.type)
+        {
+            case MyColumnType::Int:
+                man->FillNtupleIColumn(ntupleId, k, record.ints[column.slot]);
+                break;
+            case MyColumnType::Double:
+                man->FillNtupleDColumn(ntupleId, k, record.doubles[column.slot]);
+                break;
+            case MyColumnType::Float:
+                man->FillNtupleFColumn(ntupleId, k, record.doubles[column.slot]);
+                break;
+            case MyColumnType::FloatVector:
+                fFloatVectors[column.slot].assign(record.doubleVectors[column.slot]->begin(), record.doubleVectors[column.slot]->end());
+                break;
+            default:
+                break;
+        }
+    }
+    man->AddNtupleRow(ntupleId);
+}
+
+
+
+void MyRunAction::ActivateScoring()
+{
+    // Only where the events are processed
+    const MyPrimaryGenerator *generator = static_cast<const MyPrimaryGenerator*>(G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+    if(!generator)
+        return;
+
+    G4int modeType = generator->GetModeType();
+    G4SDManager *sdManager = G4SDManager::GetSDMpointer();
+
+    // The LED schema has no primary gamma nor crystal columns
+    if(fSchemaName == "led" && modeType != 40 && modeType != 41 && modeType != 42)
+        G4Exception("MyRunAction::ActivateScoring()", "Output003", JustWarning, "The led output schema drops the primary gamma and crystal columns, use it in the LED modes only");
+
+    // Si trigger: electrons in the SiPMs
+    MySensitiveDetector *sensDet = static_cast<MySensitiveDetector*>(sdManager->FindSensitiveDetector("SensitiveDetector", false));
+    if(sensDet)
+        sensDet->SetSiTrigger(modeType == 22);
+
+    // Cosmic rays trigger
+    if(sdManager->FindSensitiveDetector("CosmicTriggerSD", false))
+        sdManager->Activate("/CosmicTriggerSD", modeType == 30 || modeType == 31);
+
+    // The crystal isn't scored when building the light map
+    if(sdManager->FindSensitiveDetector("CrystalSD", false))
+        sdManager->Activate("/CrystalSD", modeType != 50);
+}
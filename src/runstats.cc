@@ -0,0 +1,320 @@
+/**
+ * @file runstats.cc
+ * @brief Definition of the class @ref MyRunStats
+ */
+#include "runstats.hh"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace
+{
+    constexpr const char *faceNames[2] = {"F", "B"};
+}
+
+
+
+MyRunStats::MyRunStats() : G4VAccumulable("RunStats")
+{
+    fEnabled = false;
+    fNTimeBins = 200;
+    fTimeMax = 200.*ns;
+    fNEdepBins = 200;
+    fEdepMax = 2.*MeV;
+
+    // Define my UD-messenger for the statistics
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/stats/", "Per-channel, occupancy, time and energy statistics of the run");
+    fMessenger->DeclareProperty("enable", fEnabled, "Accumulate the statistics of the run and write them in the _stats.txt file next to the output");
+    fMessenger->DeclareProperty("nTimeBins", fNTimeBins, "Set the number of bins of the arrival time histograms").SetParameterRange("nTimeBins>0");
+    fMessenger->DeclarePropertyWithUnit("tMax", "ns", fTimeMax, "Set the upper edge of the arrival time histograms");
+    fMessenger->DeclareProperty("nEdepBins", fNEdepBins, "Set the number of bins of the spectrum of the energy deposited in the crystal").SetParameterRange("nEdepBins>0");
+    fMessenger->DeclarePropertyWithUnit("edepMax", "keV", fEdepMax, "Set the upper edge of the spectrum of the energy deposited in the crystal");
+}
+
+
+
+MyRunStats::~MyRunStats()
+{
+    delete fMessenger;
+}
+
+
+
+void MyRunStats::Book(G4int nTimeBins, G4double timeMax, G4int nEdepBins, G4double edepMax)
+{
+    fBookedNTimeBins = nTimeBins;
+    fBookedTimeMax = timeMax;
+    fBookedNEdepBins = nEdepBins;
+    fBookedEdepMax = edepMax;
+
+    fSum.assign(nChannels, 0.);
+    fSum2.assign(nChannels, 0.);
+    fOccupancy.assign(nChannels, 0);
+    fTimes.assign(2*(fBookedNTimeBins + 1), 0);
+    fEdep.assign(fBookedNEdepBins + 1, 0);
+}
+
+
+
+void MyRunStats::Fill(const MyHitBuffer &hits, G4double edep)
+{
+    if(fSum.empty())
+        Book(fNTimeBins, fTimeMax, fNEdepBins, fEdepMax);
+
+    fNEvents++;
+
+    for(G4int face = 0; face < 2; face++)
+    {
+        // Channels
+        const std::vector<G4int> &hitsPerChannel = hits.fHitsPerChannel[face];
+        for(G4int ch = 0; ch < GS::nOfSiPMs; ch++)
+        {
+            G4double n = hitsPerChannel[ch];
+            if(n == 0.)
+                continue;
+            G4int k = face*GS::nOfSiPMs + ch;
+            fSum[k] += n;
+            fSum2[k] += n*n;
+            fOccupancy[k]++;
+        }
+
+        // Arrival times, the overflow in the last bin
+        std::uint64_t *times = fTimes.data() + face*(fBookedNTimeBins + 1);
+        for(G4double time : hits.fTime[face])
+        {
+            G4int bin = time < fBookedTimeMax ? std::max(0, static_cast<G4int>(time/fBookedTimeMax*fBookedNTimeBins)) : fBookedNTimeBins;
+            times[bin]++;
+        }
+    }
+
+    // Energy deposited, only by the events depositing some
+    if(edep > 0.)
+        fEdep[edep < fBookedEdepMax ? static_cast<G4int>(edep/fBookedEdepMax*fBookedNEdepBins) : fBookedNEdepBins]++;
+}
+
+
+
+void MyRunStats::Merge(const G4VAccumulable &other)
+{
+    const MyRunStats &otherStats = static_cast<const MyRunStats&>(other);
+    if(!otherStats.HasEntries())
+        return;
+
+    if(fSum.empty())
+        Book(otherStats.fBookedNTimeBins, otherStats.fBookedTimeMax, otherStats.fBookedNEdepBins, otherStats.fBookedEdepMax);
+
+    fNEvents += otherStats.fNEvents;
+    for(G4int k = 0; k < nChannels; k++)
+    {
+        fSum[k] += otherStats.fSum[k];
+        fSum2[k] += otherStats.fSum2[k];
+        fOccupancy[k] += otherStats.fOccupancy[k];
+    }
+    for(size_t i = 0; i < fTimes.size(); i++)
+        fTimes[i] += otherStats.fTimes[i];
+    for(size_t i = 0; i < fEdep.size(); i++)
+        fEdep[i] += otherStats.fEdep[i];
+}
+
+
+
+void MyRunStats::Reset()
+{
+    fNEvents = 0;
+    fSum.clear();
+    fSum2.clear();
+    fOccupancy.clear();
+    fTimes.clear();
+    fTimes.shrink_to_fit();
+    fEdep.clear();
+    fEdep.shrink_to_fit();
+}
+
+
+
+void MyRunStats::Write(const G4String &fileName) const
+{
+    std::ofstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't create the statistics file " << fileName << G4endl;
+        return;
+    }
+
+    G4double nEvents = fNEvents;
+
+    // Every line of the sums starts with its tag, so that the files of the
+    // shards can be merged (see Read()); the maps are only for display
+    file << "# MC_LYSO run statistics of " << fNEvents << " events" << G4endl;
+    file << "Events " << fNEvents << G4endl;
+    file << std::setprecision(15) << "TimeBinning " << fBookedNTimeBins << " " << fBookedTimeMax/ns << G4endl;
+    file << "EdepBinning " << fBookedNEdepBins << " " << fBookedEdepMax/keV << std::setprecision(6) << G4endl;
+
+    // Channels
+    file << "# Photons detected per event by every channel, occupancy = fraction of events with a hit" << G4endl;
+    file << "# Ch Face Ch Row Col Sum Sum2 NHit Mean RMS Occupancy" << G4endl;
+    for(G4int k = 0; k < nChannels; k++)
+    {
+        const GS::SiPMChannel &channel = GS::sipmChannels[k%GS::nOfSiPMs];
+        G4double mean = fSum[k]/nEvents;
+        G4double rms = std::sqrt(std::max(0., fSum2[k]/nEvents - mean*mean));
+        file << "Ch " << faceNames[k/GS::nOfSiPMs] << " " << k%GS::nOfSiPMs << " " << channel.row << " " << channel.col << " "
+             << std::fixed << std::setprecision(0) << fSum[k] << " " << fSum2[k] << " " << std::defaultfloat << std::setprecision(6) << fOccupancy[k] << " "
+             << mean << " " << rms << " " << fOccupancy[k]/nEvents << G4endl;
+    }
+
+    // Occupancy maps, as seen from the beam (row 0 on top), "-" where no SiPM
+    for(G4int face = 0; face < 2; face++)
+    {
+        std::vector<G4double> map(GS::nRowsSiPMs*GS::nColsSiPMs, -1.);
+        for(G4int ch = 0; ch < GS::nOfSiPMs; ch++)
+            map[GS::sipmChannels[ch].row*GS::nColsSiPMs + GS::sipmChannels[ch].col] = fOccupancy[face*GS::nOfSiPMs + ch]/nEvents;
+
+        file << "# Occupancy map " << faceNames[face] << ", " << GS::nRowsSiPMs << " rows x " << GS::nColsSiPMs << " columns" << G4endl;
+        for(G4int row = 0; row < GS::nRowsSiPMs; row++)
+        {
+            file << "Map " << faceNames[face];
+            for(G4int col = 0; col < GS::nColsSiPMs; col++)
+            {
+                G4double occupancy = map[row*GS::nColsSiPMs + col];
+                file << " ";
+                if(occupancy < 0.)
+                    file << "-";
+                else
+                    file << occupancy;
+            }
+            file << G4endl;
+        }
+    }
+
+    // Arrival times
+    G4double timeWidth = fBookedTimeMax/fBookedNTimeBins;
+    file << "# Arrival time histograms, " << fBookedNTimeBins << " bins of " << timeWidth/ns << " ns, the last line is the overflow" << G4endl;
+    file << "# Time T[ns] F B" << G4endl;
+    for(G4int bin = 0; bin <= fBookedNTimeBins; bin++)
+        file << "Time " << bin*timeWidth/ns << " " << fTimes[bin] << " " << fTimes[fBookedNTimeBins + 1 + bin] << G4endl;
+
+    // Energy deposited
+    G4double edepWidth = fBookedEdepMax/fBookedNEdepBins;
+    file << "# Spectrum of the energy deposited in the crystal, " << fBookedNEdepBins << " bins of " << edepWidth/keV << " keV, the last line is the overflow" << G4endl;
+    file << "# Edep Edep[keV] Events" << G4endl;
+    for(G4int bin = 0; bin <= fBookedNEdepBins; bin++)
+        file << "Edep " << bin*edepWidth/keV << " " << fEdep[bin] << G4endl;
+
+    G4cout << "Run statistics of " << fNEvents << " events written in " << fileName << G4endl;
+}
+
+
+
+G4bool MyRunStats::Read(const G4String &fileName)
+{
+    std::ifstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't read the statistics file " << fileName << G4endl;
+        return false;
+    }
+
+    // The binning precedes the sums
+    G4int nTimeBins = 0, nEdepBins = 0;
+    G4double timeMax = 0., edepMax = 0.;
+    G4int nChannelLines = 0, nTimeLines = 0, nEdepLines = 0;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string tag;
+        if(!(stream >> tag) || tag[0] == '#' || tag == "Map")
+            continue;
+
+        G4bool isValid = true;
+        if(tag == "Events")
+        {
+            std::uint64_t n;
+            isValid = static_cast<G4bool>(stream >> n);
+            if(isValid)
+                fNEvents += n;
+        }
+        else if(tag == "TimeBinning")
+        {
+            isValid = (stream >> nTimeBins >> timeMax) && nTimeBins > 0;
+            timeMax *= ns;
+        }
+        else if(tag == "EdepBinning")
+        {
+            isValid = (stream >> nEdepBins >> edepMax) && nEdepBins > 0;
+            edepMax *= keV;
+        }
+        else
+        {
+            if(nTimeBins <= 0 || nEdepBins <= 0)
+            {
+                G4cerr << "No binning before the sums of the statistics file " << fileName << G4endl;
+                return false;
+            }
+            if(fSum.empty())
+                Book(nTimeBins, timeMax, nEdepBins, edepMax);
+            else if(nTimeBins != fBookedNTimeBins || timeMax != fBookedTimeMax || nEdepBins != fBookedNEdepBins || edepMax != fBookedEdepMax)
+            {
+                G4cerr << "The binning of the statistics file " << fileName << " differs from the one of the files read before" << G4endl;
+                return false;
+            }
+
+            if(tag == "Ch")
+            {
+                std::string face;
+                G4int ch, row, col;
+                G4double sum, sum2;
+                std::uint64_t nHit;
+                isValid = (stream >> face >> ch >> row >> col >> sum >> sum2 >> nHit) && (face == faceNames[0] || face == faceNames[1]) && ch >= 0 && ch < GS::nOfSiPMs;
+                if(isValid)
+                {
+                    G4int k = (face == faceNames[1])*GS::nOfSiPMs + ch;
+                    fSum[k] += sum;
+                    fSum2[k] += sum2;
+                    fOccupancy[k] += nHit;
+                    nChannelLines++;
+                }
+            }
+            else if(tag == "Time")
+            {
+                G4double time;
+                std::uint64_t front, back;
+                isValid = (stream >> time >> front >> back) && nTimeLines <= fBookedNTimeBins;
+                if(isValid)
+                {
+                    fTimes[nTimeLines] += front;
+                    fTimes[fBookedNTimeBins + 1 + nTimeLines] += back;
+                    nTimeLines++;
+                }
+            }
+            else if(tag == "Edep")
+            {
+                G4double edep;
+                std::uint64_t n;
+                isValid = (stream >> edep >> n) && nEdepLines <= fBookedNEdepBins;
+                if(isValid)
+                    fEdep[nEdepLines++] += n;
+            }
+            else
+                isValid = false;
+        }
+
+        if(!isValid)
+        {
+            G4cerr << "Not valid line of the statistics file " << fileName << ": " << line << G4endl;
+            return false;
+        }
+    }
+
+    if(nChannelLines != nChannels || nTimeLines != fBookedNTimeBins + 1 || nEdepLines != fBookedNEdepBins + 1)
+    {
+        G4cerr << "The statistics file " << fileName << " is incomplete" << G4endl;
+        return false;
+    }
+
+    return true;
+}
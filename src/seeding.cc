@@ -0,0 +1,78 @@
+/**
+ * @file seeding.cc
+ * @brief Definition of the class @ref MyEventSeeder
+ */
+#include "seeding.hh"
+
+#include <sstream>
+
+#include "shard.hh"
+
+MyEventSeeder::MyEventSeeder(G4int theMCID) : fMCID(theMCID), fEventOffset(0), fRunID(-1), fEventID(0), fSeeds{0, 0, 0}
+{
+    // Define my UD-messenger for the seeding
+    fMessenger = new G4GenericMessenger(this, "/MC_LYSO/seeding/", "Per-event seeding and replay");
+    fMessenger->DeclareProperty("eventOffset", fEventOffset, "Set the offset added to the event IDs (set by the shards)");
+    fMessenger->DeclareProperty("runID", fRunID, "Set the run ID the seeds are derived from, e.g. of the events to replay (negative = the current run)");
+    fMessenger->DeclareMethod("replay", &MyEventSeeder::SetReplayList, "Set the list of event IDs to replay: run /run/beamOn with as many events. Empty to disable the replay");
+}
+
+
+
+MyEventSeeder::~MyEventSeeder()
+{
+    delete fMessenger;
+}
+
+
+
+G4bool MyEventSeeder::SeedEvent(G4int runID, G4int eventIndex)
+{
+    if(fReplayEvents.empty())
+        fEventID = fEventOffset + eventIndex;
+    else if(eventIndex < static_cast<G4int>(fReplayEvents.size()))
+        fEventID = fReplayEvents[eventIndex];
+    else
+    {
+        G4Exception("MyEventSeeder::SeedEvent()", "Seeding001", JustWarning, "More events than the replay list, the event is aborted");
+        return false;
+    }
+
+    if(fRunID >= 0)
+        runID = fRunID;
+
+    DeriveSeeds(fMCID, runID, fEventID, fSeeds);
+    G4Random::setTheSeeds(fSeeds, -1);
+
+    return true;
+}
+
+
+
+void MyEventSeeder::DeriveSeeds(G4int mcid, G4int runID, G4int eventID, long seeds[2])
+{
+    // Chain the keys through the generator, then split the last output
+    std::uint64_t state = static_cast<std::uint32_t>(mcid);
+    state = MyShardDriver::SplitMix64(state) ^ static_cast<std::uint32_t>(runID);
+    state = MyShardDriver::SplitMix64(state) ^ static_cast<std::uint32_t>(eventID);
+    std::uint64_t z = MyShardDriver::SplitMix64(state);
+
+    // Never zero: it would terminate the list of seeds
+    seeds[0] = static_cast<long>(z % 2147483647ULL) + 1;
+    seeds[1] = static_cast<long>((z >> 32) % 2147483647ULL) + 1;
+}
+
+
+
+void MyEventSeeder::SetReplayList(const G4String &list)
+{
+    fReplayEvents.clear();
+
+    std::istringstream events(list);
+    G4int eventID;
+    while(events >> eventID)
+        fReplayEvents.push_back(eventID);
+
+    if(!fReplayEvents.empty())
+        G4cout << "Replaying " << fReplayEvents.size() << " events" << G4endl;
+}
@@ -0,0 +1,597 @@
+/**
+ * @file shard.cc
+ * @brief Definition of the class @ref MyShardDriver
+ */
+#include "shard.hh"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+
+#include "G4UImanager.hh"
+#include "G4AnalysisManager.hh"
+#include "G4RootAnalysisReader.hh"
+
+#include "ntuple.hh"
+#include "columnarwriter.hh"
+#include "summary.hh"
+#include "ledstats.hh"
+#include "runstats.hh"
+#include "lightmapbuilder.hh"
+
+MyShardDriver::MyShardDriver(G4int theMCID, G4int index, G4int nShards, G4int nEvents, G4int interval, G4bool resume) : fMCID(theMCID), fIndex(index), fNShards(nShards), fNEvents(nEvents), fInterval(interval), fResume(resume), fRunID(0), fFirstEvent(0)
+{
+    // In the working directory, to be found when resuming
+    fManifestName = "MCID_" + std::to_string(fMCID);
+    if(fNShards > 1)
+        fManifestName += "_Shard_" + std::to_string(fIndex);
+    fManifestName += ".manifest";
+}
+
+
+
+G4bool MyShardDriver::ParseShard(const G4String &spec, G4int &index, G4int &nShards)
+{
+    size_t slash = spec.find('/');
+    if(slash == G4String::npos)
+        return false;
+
+    try
+    {
+        index = std::stoi(spec.substr(0, slash));
+        nShards = std::stoi(spec.substr(slash + 1));
+    }
+    catch(const std::exception&)
+    {
+        return false;
+    }
+
+    return nShards > 0 && index >= 0 && index < nShards;
+}
+
+
+
+std::uint64_t MyShardDriver::SplitMix64(std::uint64_t &state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+
+long MyShardDriver::GetSeed() const
+{
+    // The (index + 1)-th output of the stream seeded with the MCID: the
+    // shards' seeds are uncorrelated even for consecutive MCIDs
+    std::uint64_t state = static_cast<std::uint32_t>(fMCID);
+    std::uint64_t seed = 0;
+    for(G4int i = 0; i <= fIndex; i++)
+        seed = SplitMix64(state);
+
+    // Positive, as the engines want
+    return static_cast<long>(seed >> 1);
+}
+
+
+
+G4int MyShardDriver::GetShardEvents(G4int nTotal) const
+{
+    // The first nTotal%N shards take one more event
+    return nTotal/fNShards + (fIndex < nTotal%fNShards ? 1 : 0);
+}
+
+
+
+G4int MyShardDriver::GetFirstEvent(G4int nTotal) const
+{
+    return fIndex*(nTotal/fNShards) + std::min(fIndex, nTotal%fNShards);
+}
+
+
+
+G4String MyShardDriver::GetFileSuffix() const
+{
+    G4String suffix;
+    if(fNShards > 1)
+        suffix += "_Shard_" + std::to_string(fIndex);
+    if(fInterval > 0)
+        suffix += "_Chunk_" + std::to_string(fFirstEvent);
+    return suffix;
+}
+
+
+
+G4bool MyShardDriver::ExecuteMacro(const G4String &macroFile)
+{
+    std::ifstream macro(macroFile);
+    if(!macro)
+    {
+        G4cerr << "Can't open run macro file " << macroFile << "!" << G4endl;
+        return false;
+    }
+
+    // Only the runs of the macro itself are split: the ones of the macros it
+    // executes would run whole in every shard and block
+    G4String nestedMacro;
+    if(FindNestedBeamOn(macroFile, 0, nestedMacro))
+    {
+        G4cerr << "Error: " << nestedMacro << ", executed by " << macroFile << ", has a /run/beamOn: the runs of a shard or a checkpointed run must be in its macro." << G4endl;
+        return false;
+    }
+
+    // The blocks already done, when resuming
+    std::vector<OutputFile> doneFiles;
+    if(fResume && (!NeedsMerge() || !std::filesystem::exists(fManifestName)))
+    {
+        G4cerr << "Error: nothing to resume, no manifest " << fManifestName << " of a shard or a checkpointed run." << G4endl;
+        return false;
+    }
+    if(fResume)
+    {
+        Manifest manifest;
+        if(!ReadManifest(fManifestName, manifest) || manifest.mcid != fMCID || manifest.index != fIndex || manifest.nShards != fNShards || manifest.interval != fInterval)
+        {
+            G4cerr << "Error: the manifest " << fManifestName << " can't be resumed with these MCID, shard and checkpoint interval." << G4endl;
+            return false;
+        }
+        doneFiles = manifest.files;
+        G4cout << "Resuming from " << fManifestName << ": " << doneFiles.size() << " blocks already done." << G4endl;
+    }
+    std::set<std::pair<G4int, G4int>> doneBlocks;
+    for(const auto &file : doneFiles)
+        doneBlocks.insert({file.runID, file.firstEvent});
+
+    if(NeedsMerge() && !OpenManifest(macroFile, doneFiles))
+        return false;
+
+    G4UImanager *UImanager = G4UImanager::GetUIpointer();
+    auto apply = [this, UImanager](const G4String &command)
+    {
+        if(UImanager->ApplyCommand(command) == fCommandSucceeded)
+            return true;
+        G4cerr << "Error: command " << command << " failed, shard " << fIndex << " stopped." << G4endl;
+        return false;
+    };
+
+    G4String line;
+    G4int runID = 0;
+
+    while(std::getline(macro, line))
+    {
+        // Skip empty lines and comments
+        size_t start = line.find_first_not_of(" \t");
+        if(start == G4String::npos || line[start] == '#')
+            continue;
+        line = line.substr(start);
+
+        if(line.find("/run/beamOn") != 0)
+        {
+            if(!apply(line))
+                return false;
+            continue;
+        }
+
+        // Reduce the events of the run to the ones of the shard
+        std::istringstream command(line.substr(std::string("/run/beamOn").length()));
+        G4int nTotal = 1;
+        command >> nTotal;
+        G4String options;
+        std::getline(command, options);
+
+        if(fNEvents > 0)
+            nTotal = fNEvents;
+
+        G4int nShardEvents = GetShardEvents(nTotal);
+        if(nShardEvents < 1)
+        {
+            G4cerr << "Error: " << nTotal << " events can't be split among " << fNShards << " shards." << G4endl;
+            return false;
+        }
+
+        // Run them block by block, skipping the ones already done. The events
+        // are numbered (and seeded) as in a single uninterrupted process
+        G4int blockSize = fInterval > 0 ? fInterval : nShardEvents;
+        for(G4int first = 0; first < nShardEvents; first += blockSize)
+        {
+            fRunID = runID;
+            fFirstEvent = GetFirstEvent(nTotal) + first;
+            if(doneBlocks.count({fRunID, fFirstEvent}))
+                continue;
+
+            G4int nBlockEvents = std::min(blockSize, nShardEvents - first);
+            if(!apply("/MC_LYSO/seeding/runID " + std::to_string(fRunID)) ||
+               !apply("/MC_LYSO/seeding/eventOffset " + std::to_string(fFirstEvent)) ||
+               !apply("/run/beamOn " + std::to_string(nBlockEvents) + options))
+                return false;
+        }
+
+        runID++;
+    }
+
+    return true;
+}
+
+
+
+G4bool MyShardDriver::FindNestedBeamOn(const G4String &macroFile, G4int depth, G4String &nestedMacro)
+{
+    // Deep enough for any sensible macro, and no endless recursion
+    if(depth > 16)
+        return false;
+
+    std::ifstream macro(macroFile);
+    G4String line;
+    while(std::getline(macro, line))
+    {
+        std::istringstream fields(line);
+        G4String command, argument;
+        fields >> command >> argument;
+
+        if(depth > 0 && command == "/run/beamOn")
+        {
+            nestedMacro = macroFile;
+            return true;
+        }
+        if((command == "/control/execute" || command == "/control/loop" || command == "/control/foreach") && FindNestedBeamOn(argument, depth + 1, nestedMacro))
+            return true;
+    }
+
+    return false;
+}
+
+
+
+void MyShardDriver::AddOutputFile(G4int nEvents, const G4String &fileName, const G4String &schema)
+{
+    if(!NeedsMerge())
+        return;
+
+    // Written at once: this is the checkpoint
+    std::ofstream manifest(fManifestName, std::ios::app);
+    manifest << "Run " << fRunID << " " << fFirstEvent << " " << nEvents << " " << schema << " " << fileName << std::endl;
+}
+
+
+
+G4bool MyShardDriver::OpenManifest(const G4String &macroFile, const std::vector<OutputFile> &doneFiles) const
+{
+    std::ofstream manifest(fManifestName);
+    if(!manifest)
+    {
+        G4cerr << "Can't write the manifest " << fManifestName << "!" << G4endl;
+        return false;
+    }
+
+    manifest << "# MC_LYSO shard manifest" << std::endl;
+    manifest << "MCID " << fMCID << std::endl;
+    manifest << "Shard " << fIndex << " " << fNShards << std::endl;
+    manifest << "Checkpoint " << fInterval << std::endl;
+    manifest << "Macro " << macroFile << std::endl;
+    for(const auto &file : doneFiles)
+        manifest << "Run " << file.runID << " " << file.firstEvent << " " << file.nEvents << " " << file.schema << " " << file.fileName << std::endl;
+
+    return true;
+}
+
+
+
+void MyShardDriver::CloseManifest(G4double duration) const
+{
+    if(!NeedsMerge())
+        return;
+
+    // Last, it marks the shard as completed
+    std::ofstream manifest(fManifestName, std::ios::app);
+    manifest << "Duration " << duration << std::endl;
+
+    G4cout << "Manifest of shard " << fIndex << "/" << fNShards << " written to " << fManifestName << G4endl;
+}
+
+
+
+G4bool MyShardDriver::ReadManifest(const G4String &fileName, Manifest &manifest)
+{
+    std::ifstream file(fileName);
+    if(!file)
+    {
+        G4cerr << "Can't open the manifest " << fileName << "!" << G4endl;
+        return false;
+    }
+
+    G4String line;
+    while(std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        G4String key;
+        fields >> key;
+
+        if(key == "MCID")
+            fields >> manifest.mcid;
+        else if(key == "Shard")
+            fields >> manifest.index >> manifest.nShards;
+        else if(key == "Checkpoint")
+            fields >> manifest.interval;
+        else if(key == "Macro")
+            fields >> manifest.macroFile;
+        else if(key == "Run")
+        {
+            OutputFile output;
+            fields >> output.runID >> output.firstEvent >> output.nEvents >> output.schema >> std::ws;
+            std::getline(fields, output.fileName);
+            manifest.files.push_back(output);
+        }
+        else if(key == "Duration")
+            fields >> manifest.duration;
+    }
+
+    return manifest.nShards > 0;
+}
+
+
+
+G4bool MyShardDriver::Merge(const std::vector<G4String> &manifestFiles)
+{
+    // Read the manifests and check they're a complete set of shards
+    std::vector<Manifest> manifests;
+    for(const auto &fileName : manifestFiles)
+    {
+        Manifest manifest;
+        if(!ReadManifest(fileName, manifest))
+            return false;
+        if(manifest.duration < 0)
+        {
+            G4cerr << "Error: the shard of " << fileName << " is not completed." << G4endl;
+            return false;
+        }
+        manifests.push_back(manifest);
+    }
+
+    if(manifests.empty())
+    {
+        G4cerr << "Error: no manifest to merge." << G4endl;
+        return false;
+    }
+
+    std::sort(manifests.begin(), manifests.end(), [](const Manifest &a, const Manifest &b) { return a.index < b.index; });
+
+    const Manifest &first = manifests.front();
+    G4int nShards = first.nShards;
+    if(static_cast<G4int>(manifests.size()) != nShards)
+    {
+        G4cerr << "Error: " << manifests.size() << " manifests given, the Monte Carlo has " << nShards << " shards." << G4endl;
+        return false;
+    }
+
+    for(G4int i = 0; i < nShards; i++)
+    {
+        const Manifest &manifest = manifests[i];
+        if(manifest.index != i || manifest.mcid != first.mcid || manifest.nShards != nShards)
+        {
+            G4cerr << "Error: the manifests don't belong to the same Monte Carlo, or a shard is missing." << G4endl;
+            return false;
+        }
+    }
+
+    // Group the files by run, in shard and block order
+    std::map<G4int, std::vector<std::vector<const OutputFile*>>> runs;
+    for(G4int i = 0; i < nShards; i++)
+    {
+        for(const auto &file : manifests[i].files)
+        {
+            auto &shards = runs[file.runID];
+            shards.resize(nShards);
+            shards[i].push_back(&file);
+        }
+    }
+
+    // One merged file per run, named as the unsharded one
+    std::vector<MergeJob> jobs;
+    G4int nEvents = 0;
+    G4double duration = 0.;
+    for(auto &run : runs)
+    {
+        MergeJob job;
+        for(auto &files : run.second)
+        {
+            if(files.empty())
+            {
+                G4cerr << "Error: the shards have different runs." << G4endl;
+                return false;
+            }
+            std::sort(files.begin(), files.end(), [](const OutputFile *a, const OutputFile *b) { return a->firstEvent < b->firstEvent; });
+            for(const OutputFile *file : files)
+            {
+                if(job.inputFiles.empty())
+                    job.schema = file->schema;
+                else if(file->schema != job.schema)
+                {
+                    G4cerr << "Error: the files of run " << run.first << " have different output schemas." << G4endl;
+                    return false;
+                }
+                job.inputFiles.push_back(file->fileName);
+                nEvents += file->nEvents;
+            }
+        }
+        const G4String &fileName = job.inputFiles.front();
+        job.outputFile = fileName.substr(0, std::min(fileName.rfind("_Shard_"), fileName.rfind("_Chunk_"))) + fileName.substr(fileName.rfind('.'));
+        jobs.push_back(job);
+    }
+
+    for(const auto &manifest : manifests)
+        duration = std::max(duration, manifest.duration);
+
+    if(!MergeFiles(jobs) || !MergeTables(jobs))
+        return false;
+
+    // One summary for the whole Monte Carlo
+    MC_summary(first.macroFile, first.mcid, duration, "MC_summaries.txt", nShards, nEvents);
+
+    G4cout << G4endl;
+    G4cout << "The outputs of the Monte Carlo with MCID " << first.mcid << " have been merged." << G4endl;
+    G4cout << G4endl;
+
+    return true;
+}
+
+
+
+G4bool MyShardDriver::MergeFiles(const std::vector<MergeJob> &jobs)
+{
+    // The buffers shared by the readers and the writer, by position among
+    // the columns of their type: the vector columns are bound to both, the
+    // scalar ones are copied
+    std::array<G4int, NT::nInts> ints;
+    std::array<G4double, NT::nDoubles> doubles;
+    std::array<G4float, NT::nDoubles> floats;
+    std::array<std::vector<G4int>, NT::nIntVectors> intVectors;
+    std::array<std::vector<G4double>, NT::nDoubleVectors> doubleVectors;
+    std::array<std::vector<G4float>, NT::nDoubleVectors> floatVectors;
+
+    MyNtupleBuffers buffers;
+    for(size_t i = 0; i < NT::nIntVectors; i++)
+        buffers.intVectors[i] = &intVectors[i];
+    for(size_t i = 0; i < NT::nDoubleVectors; i++)
+    {
+        buffers.doubleVectors[i] = &doubleVectors[i];
+        buffers.floatVectors[i] = &floatVectors[i];
+    }
+
+    // A TTree per output schema, as in MyRunAction
+    G4AnalysisManager *man = G4AnalysisManager::Instance();
+    man->SetNtupleRowWise(true);
+    man->SetActivation(true);
+    std::vector<G4int> ntupleIDs;
+    for(const auto &schema : NT::GetSchemas())
+        ntupleIDs.push_back(BookNtuple(schema, buffers));
+
+    G4RootAnalysisReader *reader = G4RootAnalysisReader::Instance();
+
+    for(const auto &job : jobs)
+    {
+        // The chunks of the columnar files are copied as they are
+        if(job.outputFile.size() > 5 && job.outputFile.substr(job.outputFile.size() - 5) == ".lysc")
+        {
+            if(!MyColumnarWriter::Concatenate(job.inputFiles, job.outputFile))
+                return false;
+            continue;
+        }
+
+        G4int schemaID = NT::FindSchema(job.schema);
+        if(schemaID < 0)
+        {
+            G4cerr << "Error: unknown output schema " << job.schema << "." << G4endl;
+            return false;
+        }
+        const MyOutputSchema &schema = NT::GetSchemas()[schemaID];
+        G4int outputId = ntupleIDs[schemaID];
+        for(size_t i = 0; i < ntupleIDs.size(); i++)
+            man->SetNtupleActivation(ntupleIDs[i], static_cast<G4int>(i) == schemaID);
+
+        man->OpenFile(job.outputFile);
+        G4int nRows = 0;
+
+        for(size_t i = 0; i < job.inputFiles.size(); i++)
+        {
+            G4int ntupleId = reader->GetNtuple(NT::ntupleName, job.inputFiles[i]);
+            if(ntupleId < 0)
+            {
+                G4cerr << "Error: can't read the TTree of " << job.inputFiles[i] << "." << G4endl;
+                man->CloseFile(false);
+                return false;
+            }
+
+            // Bind the columns of the schema (the 8-bit ones are integers in the TTree)
+            for(const auto &column : schema.columns)
+            {
+                switch(column.type)
+                {
+                    case MyColumnType::Int:
+                        reader->SetNtupleIColumn(ntupleId, column.GetName(), ints[column.slot]);
+                        break;
+                    case MyColumnType::Double:
+                        reader->SetNtupleDColumn(ntupleId, column.GetName(), doubles[column.slot]);
+                        break;
+                    case MyColumnType::Float:
+                        reader->SetNtupleFColumn(ntupleId, column.GetName(), floats[column.slot]);
+                        break;
+                    case MyColumnType::IntVector:
+                    case MyColumnType::ByteVector:
+                        reader->SetNtupleIColumn(ntupleId, column.GetName(), intVectors[column.slot]);
+                        break;
+                    case MyColumnType::DoubleVector:
+                        reader->SetNtupleDColumn(ntupleId, column.GetName(), doubleVectors[column.slot]);
+                        break;
+                    case MyColumnType::FloatVector:
+                        reader->SetNtupleFColumn(ntupleId, column.GetName(), floatVectors[column.slot]);
+                        break;
+                }
+            }
+
+            // Copy the rows. The event IDs are already unique, see MyEventSeeder
+            while(reader->GetNtupleRow(ntupleId))
+            {
+                for(size_t k = 0; k < schema.columns.size(); k++)
+                {
+                    const MyOutputColumn &column = schema.columns[k];
+                    if(column.type == MyColumnType::Int)
+                        man->FillNtupleIColumn(outputId, k, ints[column.slot]);
+                    else if(column.type == MyColumnType::Double)
+                        man->FillNtupleDColumn(outputId, k, doubles[column.slot]);
+                    else if(column.type == MyColumnType::Float)
+                        man->FillNtupleFColumn(outputId, k, floats[column.slot]);
+                }
+                man->AddNtupleRow(outputId);
+                nRows++;
+            }
+        }
+
+        man->Write();
+        man->CloseFile();
+
+        G4cout << "Merged " << job.inputFiles.size() << " shards into " << job.outputFile << ": " << nRows << " events." << G4endl;
+    }
+
+    return true;
+}
+
+
+
+G4bool MyShardDriver::MergeTables(const std::vector<MergeJob> &jobs)
+{
+    // The tables are named after the output files, without the extension
+    auto baseName = [](const G4String &fileName) { return fileName.substr(0, fileName.rfind('.')); };
+
+    for(const auto &job : jobs)
+    {
+        MyLEDStats ledStats;
+        MyRunStats runStats;
+        MyLightMapBuilder mapBuilder;
+        MyLightMapGeometry mapGeometry;
+        for(const auto &fileName : job.inputFiles)
+        {
+            G4String ledName = baseName(fileName) + "_LED.txt";
+            if(std::filesystem::exists(ledName) && !ledStats.Read(ledName))
+                return false;
+            G4String statsName = baseName(fileName) + "_stats.txt";
+            if(std::filesystem::exists(statsName) && !runStats.Read(statsName))
+                return false;
+            G4String countsName = baseName(fileName) + "_lightmap.counts";
+            if(std::filesystem::exists(countsName) && !mapBuilder.ReadCounts(countsName, mapGeometry))
+                return false;
+        }
+
+        if(ledStats.HasEntries())
+            ledStats.Write(baseName(job.outputFile) + "_LED.txt");
+        if(runStats.HasEntries())
+            runStats.Write(baseName(job.outputFile) + "_stats.txt");
+        if(mapBuilder.HasEntries())
+            mapBuilder.Write(mapGeometry);
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file stacking.cc
+ * @brief Definition of the class @ref MyStackingAction
+ */
+#include "stacking.hh"
+
+MyStackingAction::MyStackingAction(MyEventAction *eventAction) : fEventAction(eventAction), fModeType(10), fIsTriggeredMode(false), fIsLuDecayMode(false), fIsTabulatedLuDecay(false)
+{}
+
+
+
+void MyStackingAction::PrepareNewEvent()
+{
+    // The mode can't change during the event
+    const MyPrimaryGenerator *generator = static_cast<const MyPrimaryGenerator*>(G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+    fModeType = generator->GetModeType();
+    fIsTriggeredMode = (fModeType == 22 || fModeType == 30 || fModeType == 31);
+    fIsLuDecayMode = (fModeType == 20 || fModeType == 21 || fModeType == 22);
+    fIsTabulatedLuDecay = fIsLuDecayMode && generator->IsTabulatedLuDecay();
+}
+
+
+
+G4ClassificationOfNewTrack MyStackingAction::ClassifyNewTrack(const G4Track *track)
+{
+    if(fIsLuDecayMode)
+        SetTimeOfDecay(track);
+
+    if(fIsTriggeredMode && track->GetParticleDefinition() == G4OpticalPhoton::OpticalPhotonDefinition())
+        return fWaiting;
+
+    return fUrgent;
+}
+
+
+
+void MyStackingAction::NewStage()
+{
+    // All the other particles have been tracked: the trigger is known
+    if(fIsTriggeredMode && !fEventAction->IsEventTriggered(fModeType))
+        stackManager->clear();
+}
+
+
+
+void MyStackingAction::SetTimeOfDecay(const G4Track *track)
+{
+    // Set time = 0 ns also for primary data. Instantaneous decay
+    if(track->GetParentID() == 0)
+    {
+        fEventAction->SetArrivalandFirstInteraction(track->GetGlobalTime(), track->GetPosition(), track->GetGlobalTime(), track->GetPosition());
+        return;
+    }
+
+    // The tabulated decay products are the primaries themselves
+    if(fIsTabulatedLuDecay)
+        return;
+
+    // Products of the radioactive decay of the primary
+    if(track->GetParentID() == 1 && track->GetCreatorProcess() && track->GetCreatorProcess()->GetProcessType() == fDecay)
+    {
+        G4Track *modifiableTrack = const_cast<G4Track*>(track);
+        modifiableTrack->SetGlobalTime(0.);
+    }
+}
@@ -6,7 +6,7 @@
 #include "summary.hh"
 
 G4int beamType = 0, modeType = 0;
-G4bool boolLightGuide = false;
+G4bool boolLightGuide = false, boolFastLight = false;
 
 
 
@@ -29,7 +29,7 @@ G4String extract_value(const G4String& line, const G4String& keyword)
 
 
 
-void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4String& output_filename)
+void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4String& output_filename, G4int nShards, G4int nEvents)
 {
     // Open the output file in append mode
     std::ofstream outfile(output_filename, std::ios::app);
@@ -42,6 +42,18 @@ void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4Strin
     outfile << "Date: " << std::asctime(current_time);
     outfile << "User Name: " << getlogin() << G4endl;
     outfile << "Duration of the simulation: " << duration << " s" << G4endl;
+    if(nShards > 1)
+        outfile << "Shards: " << nShards << G4endl;
+    if(nEvents > 0)
+        outfile << "Number of events: " << nEvents << G4endl;
+
+    // The queue of the writer thread, to size it
+    const MyAsyncWriterStats &queueStats = MyAsyncWriter::Instance()->GetTotalStats();
+    if(queueStats.nEvents > 0)
+    {
+        outfile << "Output queue: capacity " << queueStats.capacity << ", mean depth " << queueStats.meanDepth << ", max depth " << queueStats.maxDepth << G4endl;
+        outfile << "Output queue stalls: " << queueStats.nStalls << " (" << queueStats.stallTime << " s)" << G4endl;
+    }
     outfile << G4endl;
 
     // Open the run macro file in read mode
@@ -60,6 +72,10 @@ void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4Strin
         // Trim leading whitespaces and tabs from each line
         line = line.substr(line.find_first_not_of(" \t"));
 
+        // Skip the commented commands
+        if(line[0] == '#')
+            continue;
+
         // Find all the settings and write them on the output file
         if(line.find("/MC_LYSO/Mode") != G4String::npos)
         {
@@ -87,10 +103,27 @@ void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4Strin
                     break;
                 case 30:
                     outfile << "Mode: Cosmic rays" << G4endl;
+                    outfile << "Cosmic rays trigger acceptance: " << MyCosmicRaySampler::GetAcceptance() << " (" << MyCosmicRaySampler::GetEtendue()/cm2 << " cm2 sr)" << G4endl;
+                    break;
+                case 31:
+                {
+                    outfile << "Mode: Cosmic rays - Counting" << G4endl;
+                    G4double areaRatio = std::pow(GS::halfZXsideCosmicRayDetector/MyCosmicRaySampler::halfSideCountingArea, 2);
+                    outfile << "Cosmic rays trigger acceptance: " << MyCosmicRaySampler::GetAcceptance() << " (expected fraction of triggers " << areaRatio*MyCosmicRaySampler::GetAcceptance() << ")" << G4endl;
                     break;
+                }
                 case 40:
                     outfile << "Mode: LED system" << G4endl;
                     break;
+                case 41:
+                    outfile << "Mode: LED system - Pulses" << G4endl;
+                    break;
+                case 42:
+                    outfile << "Mode: LED system - Pulses of all the LEDs" << G4endl;
+                    break;
+                case 50:
+                    outfile << "Mode: Light map generation" << G4endl;
+                    break;
             }
         }
         else if(modeType == 11 && line.find("/MC_LYSO/myGun/radiusSpread") != G4String::npos)
@@ -133,31 +166,123 @@ void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4Strin
                 outfile << "176Lu isotope position: " << posdecay_value << G4endl;
             }
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/FrontOrBack F") != G4String::npos)
+        else if((modeType == 20 || modeType == 21 || modeType == 22) && line.find("/MC_LYSO/myGun/tabulatedLuDecay true") != G4String::npos)
+        {
+            outfile << "176Lu decay: tabulated" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/physics/radioactiveDecay false") != G4String::npos)
+        {
+            outfile << "Radioactive decay: OFF" << G4endl;
+        }
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/FrontOrBack F") != G4String::npos)
         {
             outfile << "LED of Front detector" << G4endl;
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/FrontOrBack B") != G4String::npos)
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/FrontOrBack B") != G4String::npos)
         {
             outfile << "LED of Back detector" << G4endl;
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/switchOnLED u") != G4String::npos)
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/switchOnLED u") != G4String::npos)
         {
             outfile << "LED turned on: up" << G4endl;
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/switchOnLED d") != G4String::npos)
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/switchOnLED d") != G4String::npos)
         {
             outfile << "LED turned on: down" << G4endl;
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/switchOnLED r") != G4String::npos)
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/switchOnLED r") != G4String::npos)
         {
             outfile << "LED turned on: right" << G4endl;
         }
-        else if(modeType == 40 && line.find("/MC_LYSO/myGun/LED-System/switchOnLED l") != G4String::npos)
+        else if((modeType == 40 || modeType == 41) && line.find("/MC_LYSO/myGun/LED-System/switchOnLED l") != G4String::npos)
         {
             outfile << "LED turned on: left" << G4endl;
         }
-        else if(line.find("/run/beamOn") != G4String::npos)
+        else if((modeType == 41 || modeType == 42) && line.find("/MC_LYSO/myGun/LED-System/nPhotons") != G4String::npos)
+        {
+            G4String photons_value = extract_value(line, "/MC_LYSO/myGun/LED-System/nPhotons");
+            if(!photons_value.empty())
+            {
+                outfile << "Photons per LED pulse:" << photons_value << G4endl;
+            }
+        }
+        else if((modeType == 41 || modeType == 42) && line.find("/MC_LYSO/myGun/LED-System/poisson true") != G4String::npos)
+        {
+            outfile << "Photons per LED pulse: Poisson-distributed" << G4endl;
+        }
+        else if((modeType == 41 || modeType == 42) && line.find("/MC_LYSO/myGun/LED-System/pulseShape") != G4String::npos)
+        {
+            G4String shape_value = extract_value(line, "/MC_LYSO/myGun/LED-System/pulseShape");
+            if(!shape_value.empty())
+            {
+                outfile << "LED pulse shape:" << shape_value << G4endl;
+            }
+        }
+        else if((modeType == 41 || modeType == 42) && line.find("/MC_LYSO/myGun/LED-System/pulseWidth") != G4String::npos)
+        {
+            G4String width_value = extract_value(line, "/MC_LYSO/myGun/LED-System/pulseWidth");
+            if(!width_value.empty())
+            {
+                outfile << "LED pulse width:" << width_value << G4endl;
+            }
+        }
+        else if(modeType == 42 && line.find("/MC_LYSO/myGun/LED-System/sweepSchedule") != G4String::npos)
+        {
+            G4String schedule_value = extract_value(line, "/MC_LYSO/myGun/LED-System/sweepSchedule");
+            if(!schedule_value.empty())
+            {
+                outfile << "LEDs fired in turn:" << schedule_value << G4endl;
+            }
+        }
+        else if(line.find("/MC_LYSO/output/countsOnly true") != G4String::npos)
+        {
+            outfile << "SiPM output: hits per channel only" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/output/ntuple false") != G4String::npos)
+        {
+            outfile << "Ntuple: not written" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/stats/enable true") != G4String::npos)
+        {
+            outfile << "Run statistics: written" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/readout/window") != G4String::npos)
+        {
+            G4String window_value = extract_value(line, "/MC_LYSO/readout/window");
+            if(!window_value.empty())
+            {
+                outfile << "Readout window: " << window_value << G4endl;
+            }
+        }
+        else if(line.find("/MC_LYSO/output/schema") != G4String::npos)
+        {
+            G4String schema_value = extract_value(line, "/MC_LYSO/output/schema");
+            if(!schema_value.empty())
+            {
+                outfile << "Output schema:" << schema_value << G4endl;
+            }
+        }
+        else if(line.find("/MC_LYSO/output/dropDerived true") != G4String::npos)
+        {
+            outfile << "Derivable columns: dropped" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/output/timeBins") != G4String::npos)
+        {
+            G4String bins_value = extract_value(line, "/MC_LYSO/output/timeBins");
+            if(!bins_value.empty())
+            {
+                outfile << "Arrival time histograms: " << bins_value << " bins" << G4endl;
+            }
+        }
+        else if(line.find("/MC_LYSO/digitizer/enable true") != G4String::npos)
+        {
+            outfile << "SiPM digitizer: enabled" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/digitizer/saveTraces true") != G4String::npos)
+        {
+            outfile << "SiPM waveforms: saved" << G4endl;
+        }
+        else if(nEvents <= 0 && line.find("/run/beamOn") != G4String::npos)
         {
             G4String events_value = extract_value(line, "/run/beamOn");
             if(!events_value.empty())
@@ -232,6 +357,32 @@ void MC_summary(G4String macrofile, G4int seed, G4double duration, const G4Strin
         {
             outfile << "Cosmic rays detectors: OFF" << G4endl;
         }
+        else if(line.find("/MC_LYSO/myConstruction/isFastLight true") != G4String::npos)
+        {
+            outfile << "Fast light simulation: ON" << G4endl;
+            boolFastLight = true;
+        }
+        else if(line.find("/MC_LYSO/myConstruction/isFastLight false") != G4String::npos)
+        {
+            outfile << "Fast light simulation: OFF" << G4endl;
+            boolFastLight = false;
+        }
+        else if(boolFastLight && line.find("/MC_LYSO/myConstruction/FastLightMap") != G4String::npos)
+        {
+            G4String map_value = extract_value(line, "/MC_LYSO/myConstruction/FastLightMap");
+            if(!map_value.empty())
+            {
+                outfile << "Light map: " << map_value << G4endl;
+            }
+        }
+        else if(line.find("/MC_LYSO/myConstruction/isPDEPrescaling true") != G4String::npos)
+        {
+            outfile << "PDE pre-scaling: ON (scintillation yield x " << GS::peakPDE << ")" << G4endl;
+        }
+        else if(line.find("/MC_LYSO/myConstruction/isPDEPrescaling false") != G4String::npos)
+        {
+            outfile << "PDE pre-scaling: OFF" << G4endl;
+        }
     }
 
     construction_file.close();
@@ -0,0 +1,55 @@
+/**
+ * @file timedstreambuf.cc
+ * @brief Definition of the class @ref MyTimedStreamBuf
+ */
+#include "timedstreambuf.hh"
+
+#include "perfcounters.hh"
+
+void MyTimedStreamBuf::Install(std::ostream &stream)
+{
+    if(fStream)
+        Uninstall();
+
+    fStream = &stream;
+    fTarget = stream.rdbuf(this);
+    fTime = 0.;
+}
+
+
+
+void MyTimedStreamBuf::Uninstall()
+{
+    if(!fStream)
+        return;
+
+    fStream->rdbuf(fTarget);
+    fStream = nullptr;
+    fTarget = nullptr;
+}
+
+
+
+MyTimedStreamBuf::int_type MyTimedStreamBuf::overflow(int_type c)
+{
+    MyScopeTimer timer(fTime);
+    if(traits_type::eq_int_type(c, traits_type::eof()))
+        return fTarget->pubsync() == 0 ? traits_type::not_eof(c) : traits_type::eof();
+    return fTarget->sputc(traits_type::to_char_type(c));
+}
+
+
+
+std::streamsize MyTimedStreamBuf::xsputn(const char *s, std::streamsize n)
+{
+    MyScopeTimer timer(fTime);
+    return fTarget->sputn(s, n);
+}
+
+
+
+int MyTimedStreamBuf::sync()
+{
+    MyScopeTimer timer(fTime);
+    return fTarget->pubsync();
+}
@@ -0,0 +1,24 @@
+/**
+ * @file tracking.cc
+ * @brief Definition of the class @ref MyTrackingAction
+ */
+#include "tracking.hh"
+
+MyTrackingAction::MyTrackingAction(MyEventAction *eventAction) : fEventAction(eventAction)
+{}
+
+
+
+void MyTrackingAction::PostUserTrackingAction(const G4Track *track)
+{
+    G4bool isOpticalPhoton = track->GetParticleDefinition() == G4OpticalPhoton::OpticalPhotonDefinition();
+    fEventAction->fPerfCounters.CountTrack(track->GetCurrentStepNumber(), isOpticalPhoton);
+
+    if(!isOpticalPhoton)
+        return;
+
+    // The readout window is enforced by the "UserSpecialCut" process
+    const G4VProcess *process = track->GetStep()->GetPostStepPoint()->GetProcessDefinedStep();
+    if(process && process->GetProcessName() == "UserSpecialCut")
+        fEventAction->AddWindowKilledPhoton();
+}